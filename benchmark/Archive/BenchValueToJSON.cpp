@@ -0,0 +1,41 @@
+#include <EncryptedDevice/EncryptedDevice.hpp>
+#include <EncryptedDevice/ValueToJSON.hpp>
+#include <MockDevice/MockDevice.hpp>
+#include <Specification/Core/Defs/UIDs.hpp>
+
+#include <asyncpp/join.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+
+using namespace sedmgr;
+
+
+TEST_CASE("ValueToJSON: Locking row", "[ValueToJSON]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    const auto& modules = device.GetModules();
+    const auto lockingSp = modules.FindUid("SP::Locking").value();
+    const auto globalRange = modules.FindUid("Locking::GlobalRange", lockingSp).value();
+    const auto table = modules.FindTable(UID(core::eTable::Locking)).value();
+
+    auto session = join(device.Login(lockingSp));
+    std::vector<Value> row;
+    for (uint32_t column = 0; column < table.columns.size(); ++column) {
+        row.push_back(join(session.GetValue(globalRange, column)));
+    }
+    join(session.End());
+
+    const auto nameConverter = [&](UID uid) { return modules.FindName(uid, lockingSp); };
+
+    BENCHMARK("all columns") {
+        nlohmann::json json;
+        for (size_t column = 0; column < row.size(); ++column) {
+            if (!row[column].HasValue()) {
+                continue;
+            }
+            json.push_back(ValueToJSON(row[column], table.columns[column].type, nameConverter));
+        }
+        return json;
+    };
+}
@@ -0,0 +1,75 @@
+#include <Archive/Serialization.hpp>
+#include <Messaging/ComPacket.hpp>
+#include <Messaging/Method.hpp>
+#include <Messaging/Native.hpp>
+#include <Messaging/TokenStream.hpp>
+#include <Specification/Core/Defs/UIDs.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+
+using namespace sedmgr;
+
+
+static TokenStream MakeTokenStream() {
+    const MethodCall call{
+        .invokingId = 0x0000'0802'0000'0001_uid,
+        .methodId = UID(core::eMethod::Get),
+        .args = { value_cast(CellBlock{ .startColumn = 3, .endColumn = 8 }) },
+    };
+    return TokenStream{ Tokenize(MethodCallToValue(call)) };
+}
+
+
+static ComPacket MakeComPacket(size_t payloadSize) {
+    SubPacket subPacket{
+        .kind = static_cast<uint16_t>(eSubPacketKind::DATA),
+        .payload = std::vector<std::byte>(payloadSize, std::byte(0x5A)),
+    };
+    Packet packet{
+        .tperSessionNumber = 5000,
+        .hostSessionNumber = 100,
+    };
+    packet.payload.push_back(std::move(subPacket));
+    ComPacket comPacket{
+        .comId = 4097,
+        .comIdExtension = 0,
+    };
+    comPacket.payload.push_back(std::move(packet));
+    return comPacket;
+}
+
+
+TEST_CASE("TokenStream: Serialize / DeSerialize", "[TokenStream]") {
+    const auto stream = MakeTokenStream();
+    const auto bytes = Serialize(stream);
+
+    BENCHMARK("Serialize") {
+        return Serialize(stream);
+    };
+    BENCHMARK("DeSerialize") {
+        return DeSerialize(Serialized<TokenStream>{ bytes });
+    };
+}
+
+
+TEST_CASE("ComPacket: Serialize / DeSerialize", "[ComPacket]") {
+    const auto smallPacket = MakeComPacket(64);
+    const auto largePacket = MakeComPacket(2000);
+    const auto smallBytes = Serialize(smallPacket);
+    const auto largeBytes = Serialize(largePacket);
+
+    BENCHMARK("Serialize 64 B") {
+        return Serialize(smallPacket);
+    };
+    BENCHMARK("Serialize 2000 B") {
+        return Serialize(largePacket);
+    };
+    BENCHMARK("DeSerialize 64 B") {
+        return DeSerialize(Serialized<ComPacket>{ smallBytes });
+    };
+    BENCHMARK("DeSerialize 2000 B") {
+        return DeSerialize(Serialized<ComPacket>{ largeBytes });
+    };
+}
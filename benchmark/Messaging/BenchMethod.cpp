@@ -0,0 +1,56 @@
+#include <Messaging/Method.hpp>
+#include <Messaging/Native.hpp>
+#include <Specification/Core/Defs/UIDs.hpp>
+
+#include <asyncpp/join.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+
+using namespace sedmgr;
+
+
+static constexpr auto getMethod = Method<UID(core::eMethod::Get), 1, 0, 1, 0>{};
+static constexpr auto startSessionMethod = Method<UID(core::eMethod::StartSession), 3, 9, 2, 6>{};
+
+
+TEST_CASE("Method: pack and unpack", "[Method]") {
+    const Value cellBlock = value_cast(CellBlock{ .startColumn = 3, .endColumn = 8 });
+    const List row = { Named{ uint32_t(3), true }, Named{ uint32_t(4), true }, Named{ uint32_t(5), false } };
+    const CallContext context{
+        .invokingId = 0x0000'0802'0000'0001_uid,
+        .callRemoteMethod = [&row](MethodCall) -> asyncpp::task<MethodResult> {
+            co_return MethodResult{ .values = { Value(row) } };
+        },
+    };
+
+    BENCHMARK("Get operator()") {
+        return join(getMethod(context, cellBlock));
+    };
+    BENCHMARK("Get execute") {
+        return getMethod.Execute([&row](const Value&) { return std::pair{ std::tuple{ Value(row) }, eMethodStatus::SUCCESS }; },
+                                 std::span(&cellBlock, 1));
+    };
+}
+
+
+TEST_CASE("Method: pack and unpack optionals", "[Method]") {
+    const std::vector<Value> args = {
+        uint32_t(100),
+        value_cast(0x0000'0205'0000'0001_uid),
+        true,
+        Named{ uint16_t(0), Value(Bytes(32, std::byte(0xA5))) },
+        Named{ uint16_t(3), value_cast(0x0000'0009'0000'0006_uid) },
+    };
+    const auto executor = [](auto&&...) {
+        return std::pair{
+            std::tuple{ Value(uint32_t(5000)), Value(uint32_t(100)), std::optional<Value>{}, std::optional<Value>{}, std::optional<Value>{}, std::optional<Value>{}, std::optional<Value>{}, std::optional<Value>{} },
+            eMethodStatus::SUCCESS
+        };
+    };
+
+    BENCHMARK("StartSession execute") {
+        return startSessionMethod.Execute(executor, args);
+    };
+}
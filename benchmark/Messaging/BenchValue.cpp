@@ -0,0 +1,56 @@
+#include <Messaging/Method.hpp>
+#include <Messaging/Native.hpp>
+#include <Messaging/Value.hpp>
+#include <Specification/Core/Defs/UIDs.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+
+using namespace sedmgr;
+
+
+static Value MakeGetCall() {
+    const MethodCall call{
+        .invokingId = 0x0000'0802'0000'0001_uid,
+        .methodId = UID(core::eMethod::Get),
+        .args = { value_cast(CellBlock{ .startColumn = 3, .endColumn = 8 }) },
+    };
+    return MethodCallToValue(call);
+}
+
+
+static Value MakeSetCall() {
+    const MethodCall call{
+        .invokingId = 0x0000'000B'0000'0001_uid,
+        .methodId = UID(core::eMethod::Set),
+        .args = { Named{ uint16_t(1), Value(List{ Named{ uint16_t(3), Value(Bytes(32, std::byte(0xA5))) } }) } },
+    };
+    return MethodCallToValue(call);
+}
+
+
+TEST_CASE("Value: Tokenize", "[Value]") {
+    const auto getCall = MakeGetCall();
+    const auto setCall = MakeSetCall();
+
+    BENCHMARK("Get call") {
+        return Tokenize(getCall);
+    };
+    BENCHMARK("Set call") {
+        return Tokenize(setCall);
+    };
+}
+
+
+TEST_CASE("Value: DeTokenize", "[Value]") {
+    const auto getTokens = Tokenize(MakeGetCall());
+    const auto setTokens = Tokenize(MakeSetCall());
+
+    BENCHMARK("Get call") {
+        return DeTokenize(Tokenized<Value>{ getTokens }).first;
+    };
+    BENCHMARK("Set call") {
+        return DeTokenize(Tokenized<Value>{ setTokens }).first;
+    };
+}
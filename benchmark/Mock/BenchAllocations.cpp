@@ -0,0 +1,72 @@
+#include <EncryptedDevice/EncryptedDevice.hpp>
+#include <MockDevice/MockDevice.hpp>
+
+#include <asyncpp/join.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <new>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+using namespace sedmgr;
+
+
+// Ceilings rather than exact counts, as they depend on the standard library and
+// on asyncpp. A change that brings back per-call frames or std::function and
+// shared_ptr churn on the method path should still push a call over them.
+static constexpr double maxAllocationsPerGet = 150;
+static constexpr double maxAllocationsPerGetRow = 400;
+
+
+// Coroutines may resume on the device's threads, so the counter is global.
+static std::atomic_size_t allocationCount = 0;
+
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size > 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+
+template <class Func>
+static double AllocationsPerCall(Func&& func, size_t iterations) {
+    func(); // Warm up lazily initialized state.
+    const auto before = allocationCount.load();
+    for (size_t i = 0; i < iterations; ++i) {
+        func();
+    }
+    return double(allocationCount.load() - before) / double(iterations);
+}
+
+
+TEST_CASE("Session: allocations per method call", "[Session]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    const auto adminSp = device.GetModules().FindUid("SP::Admin").value();
+    auto session = join(device.Login(adminSp));
+    constexpr size_t iterations = 1000;
+
+    const auto get = AllocationsPerCall([&] { join(session.GetValue(adminSp, 1)); }, iterations);
+    const auto getRow = AllocationsPerCall([&] { join(session.GetObjectValues(adminSp)); }, iterations);
+    WARN(std::format("Get: {:.1f} allocations / call", get));
+    WARN(std::format("Get row: {:.1f} allocations / call", getRow));
+    CHECK(get <= maxAllocationsPerGet);
+    CHECK(getRow <= maxAllocationsPerGetRow);
+
+    join(session.End());
+}
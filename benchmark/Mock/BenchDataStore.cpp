@@ -0,0 +1,44 @@
+#include <EncryptedDevice/DataStore.hpp>
+#include <EncryptedDevice/EncryptedDevice.hpp>
+#include <MockDevice/MockDevice.hpp>
+
+#include <asyncpp/join.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <format>
+
+
+using namespace sedmgr;
+
+
+TEST_CASE("DataStore: get / put", "[DataStore]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    const auto lockingSp = device.GetModules().FindUid("SP::Locking").value();
+    auto session = join(device.Login(lockingSp));
+    auto store = join(DataStore::Load(session));
+    for (int i = 0; i < 32; ++i) {
+        store.Put(std::format("key{}", i), Bytes(64, std::byte(i)));
+    }
+    join(store.Commit());
+    const auto dataStore = UID(opal::eTable::DataStore);
+    uint8_t counter = 0;
+
+    BENCHMARK("Load") {
+        return join(DataStore::Load(session)).Size();
+    };
+    BENCHMARK("Get") {
+        return store.Get("key17")->size();
+    };
+    BENCHMARK("Put + Commit") {
+        store.Put("key17", Bytes(64, std::byte(++counter)));
+        join(store.Commit());
+    };
+    // For comparison, without the host copy and delta writes: 4 KiB of the
+    // table are read and written back for every change.
+    BENCHMARK("ReadBytes + WriteBytes") {
+        const auto bytes = join(session.ReadBytes(dataStore, 0, 4096));
+        join(session.WriteBytes(dataStore, 0, bytes));
+    };
+}
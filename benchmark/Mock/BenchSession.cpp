@@ -0,0 +1,60 @@
+#include <EncryptedDevice/EncryptedDevice.hpp>
+#include <MockDevice/MockDevice.hpp>
+
+#include <asyncpp/join.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+
+using namespace sedmgr;
+using namespace std::string_view_literals;
+
+
+TEST_CASE("Session: Get / Set loop", "[Session]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    const auto adminSp = device.GetModules().FindUid("SP::Admin").value();
+    auto session = join(device.Login(adminSp));
+
+    BENCHMARK("Get") {
+        return join(session.GetValue(adminSp, 1));
+    };
+    BENCHMARK("Set") {
+        join(session.SetValue(adminSp, 2, value_cast("Stan"sv)));
+    };
+    BENCHMARK("Get + Set") {
+        const auto value = join(session.GetValue(adminSp, 2));
+        join(session.SetValue(adminSp, 2, value));
+    };
+
+    join(session.End());
+}
+
+
+TEST_CASE("Session: login / logout", "[Session]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    const auto adminSp = device.GetModules().FindUid("SP::Admin").value();
+
+    BENCHMARK("Login + End") {
+        auto session = join(device.Login(adminSp));
+        join(session.End());
+    };
+}
+
+
+TEST_CASE("Session: busy recovery", "[Session]") {
+    const auto mock = std::make_shared<MockDevice>();
+    auto device = join(EncryptedDevice::Start(mock));
+    const auto lockingSp = device.GetModules().FindUid("SP::Locking").value();
+
+    BENCHMARK("StackReset + Login") {
+        join(device.StackReset());
+        auto session = join(device.Login(lockingSp));
+        join(session.End());
+    };
+    BENCHMARK("Restart + Login") {
+        auto restarted = join(EncryptedDevice::Start(mock));
+        auto session = join(restarted.Login(lockingSp));
+        join(session.End());
+    };
+}
@@ -0,0 +1,51 @@
+#include <Specification/Core/CoreModule.hpp>
+#include <Specification/Opal/OpalModule.hpp>
+#include <TrustedPeripheral/ModuleCollection.hpp>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+
+using namespace sedmgr;
+
+
+static ModuleCollection MakeModules() {
+    ModuleCollection modules;
+    modules.Load(CoreModule::Get());
+    modules.Load(Opal2Module::Get());
+    return modules;
+}
+
+
+TEST_CASE("ModuleCollection: FindName", "[ModuleCollection]") {
+    const auto modules = MakeModules();
+    const auto lockingSp = modules.FindUid("SP::Locking").value();
+    const auto table = UID(core::eTable::Table);
+    const auto globalRange = modules.FindUid("Locking::GlobalRange", lockingSp).value();
+
+    BENCHMARK("core table") {
+        return modules.FindName(table);
+    };
+    BENCHMARK("SP-specific object") {
+        return modules.FindName(globalRange, lockingSp);
+    };
+    BENCHMARK("missing") {
+        return modules.FindName(0xFFFF'FFFF'FFFF'FFFF_uid);
+    };
+}
+
+
+TEST_CASE("ModuleCollection: FindUid", "[ModuleCollection]") {
+    const auto modules = MakeModules();
+    const auto lockingSp = modules.FindUid("SP::Locking").value();
+
+    BENCHMARK("core table") {
+        return modules.FindUid("Table");
+    };
+    BENCHMARK("SP-specific object") {
+        return modules.FindUid("Locking::GlobalRange", lockingSp);
+    };
+    BENCHMARK("missing") {
+        return modules.FindUid("INVALID_NAME");
+    };
+}
@@ -0,0 +1,26 @@
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch_session.hpp>
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+
+// Results are meant to be diffed between releases, so the XML reporter is the
+// default. Passing --reporter explicitly overrides it.
+int main(int argc, char* argv[]) {
+    std::vector<char*> args(argv, argv + argc);
+    const bool hasReporter = std::ranges::any_of(args, [](std::string_view arg) {
+        return arg == "-r" || arg.starts_with("--reporter");
+    });
+    char reporterFlag[] = "--reporter";
+    char reporterName[] = "xml";
+    if (!hasReporter) {
+        args.push_back(reporterFlag);
+        args.push_back(reporterName);
+    }
+
+    int result = Catch::Session().run(int(args.size()), args.data());
+
+    return result;
+}
@@ -0,0 +1,376 @@
+#include "DataStore.hpp"
+
+#include <Error/Exception.hpp>
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+
+namespace sedmgr {
+
+static constexpr std::array<std::byte, 4> magic = { std::byte('S'), std::byte('D'), std::byte('K'), std::byte('V') };
+static constexpr uint16_t version = 1;
+static constexpr uint32_t headerSize = 16;
+static constexpr uint32_t entryOverhead = 9;
+static constexpr size_t maxKeySize = 255;
+static constexpr size_t maxEntries = 65535;
+// Dirty ranges closer than this are written in one call, as the extra bytes
+// cost less than another round-trip.
+static constexpr uint32_t dirtyMergeGap = 64;
+static constexpr uint32_t tableRowsColumn = 7;
+
+
+static uint32_t ReadInteger(std::span<const std::byte> bytes, size_t offset, size_t size) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < size; ++i) {
+        value = (value << 8) | uint32_t(bytes[offset + i]);
+    }
+    return value;
+}
+
+
+static void WriteInteger(Bytes& bytes, uint32_t value, size_t size) {
+    for (size_t i = size; i > 0; --i) {
+        bytes.push_back(std::byte(value >> (8 * (i - 1))));
+    }
+}
+
+
+static InvalidFormatError CorruptStore(std::string_view reason) {
+    return InvalidFormatError(std::format("corrupt data store: {}", reason));
+}
+
+
+DataStore::DataStore(SimpleSession& session, UID table, Bytes image)
+    : m_session(&session),
+      m_table(table),
+      m_image(std::move(image)) {}
+
+
+asyncpp::task<DataStore> DataStore::Load(SimpleSession& session, UID table) {
+    const auto size = value_cast<uint32_t>(co_await session.GetValue(table.ToDescriptor(), tableRowsColumn));
+    if (size < headerSize) {
+        throw std::invalid_argument(std::format("table is too small for a data store: {} bytes", size));
+    }
+
+    DataStore store(session, table, Bytes(size));
+    const auto header = co_await session.ReadBytes(table, 0, headerSize);
+    std::ranges::copy(header, store.m_image.begin());
+    if (!store.ParseHeader()) {
+        store.Format();
+        co_return store;
+    }
+
+    // The free space between the index and the values is not read.
+    const auto index = co_await session.ReadBytes(table, headerSize, store.m_indexEnd - headerSize);
+    const auto values = co_await session.ReadBytes(table, store.m_heapBegin, size - store.m_heapBegin);
+    std::ranges::copy(index, store.m_image.begin() + headerSize);
+    std::ranges::copy(values, store.m_image.begin() + store.m_heapBegin);
+    store.ParseIndex();
+    co_return store;
+}
+
+
+std::optional<std::span<const std::byte>> DataStore::Get(std::string_view key) const {
+    const auto it = m_lookup.find(key);
+    if (it == m_lookup.end()) {
+        return std::nullopt;
+    }
+    const auto& entry = m_entries[it->second];
+    return std::span<const std::byte>(m_image).subspan(entry.offset, entry.length);
+}
+
+
+std::vector<std::string> DataStore::Keys() const {
+    std::vector<std::string> keys;
+    std::ranges::transform(m_lookup, std::back_inserter(keys), [](const auto& item) { return item.first; });
+    return keys;
+}
+
+
+size_t DataStore::Size() const {
+    return m_entries.size();
+}
+
+
+void DataStore::Put(std::string_view key, std::span<const std::byte> value) {
+    if (key.empty() || key.size() > maxKeySize) {
+        throw std::invalid_argument(std::format("data store keys must be 1 to {} bytes long", maxKeySize));
+    }
+    const auto it = m_lookup.find(key);
+    const bool isNew = it == m_lookup.end();
+    if (value.size() > m_image.size() || (isNew && m_entries.size() >= maxEntries)) {
+        throw InsufficientSpaceError("DataStore::Put");
+    }
+    const auto length = uint32_t(value.size());
+
+    // Values that fit in their current place are overwritten in place.
+    if (!isNew && value.size() <= m_entries[it->second].length) {
+        auto& entry = m_entries[it->second];
+        Store(entry.offset, value);
+        entry.length = length;
+        StoreIndex(it->second);
+        return;
+    }
+
+    const auto indexEnd = m_indexEnd + (isNew ? entryOverhead + uint32_t(key.size()) : 0);
+    auto offset = Allocate(length, indexEnd);
+    if (!offset) {
+        const auto replaced = isNew ? 0 : m_entries[it->second].length;
+        if (size_t(indexEnd) + GetLiveBytes() - replaced + length > m_image.size()) {
+            throw InsufficientSpaceError("DataStore::Put");
+        }
+        if (!isNew) {
+            m_entries[it->second].length = 0;
+        }
+        Compact();
+        offset = Allocate(length, indexEnd);
+    }
+
+    size_t index;
+    if (isNew) {
+        index = m_entries.size();
+        m_entries.push_back({ std::string(key), *offset, length });
+        m_lookup.emplace(key, index);
+    }
+    else {
+        index = it->second;
+        m_entries[index].offset = *offset;
+        m_entries[index].length = length;
+    }
+    Store(*offset, value);
+    m_indexEnd = indexEnd;
+    m_heapBegin = *offset;
+    StoreIndex(index);
+    StoreHeader();
+}
+
+
+bool DataStore::Erase(std::string_view key) {
+    const auto it = m_lookup.find(key);
+    if (it == m_lookup.end()) {
+        return false;
+    }
+    // The value is left in place, its space is reclaimed by compaction.
+    const auto index = it->second;
+    m_indexEnd -= entryOverhead + uint32_t(m_entries[index].key.size());
+    m_entries.erase(m_entries.begin() + index);
+    m_lookup.erase(it);
+    for (auto& [_, position] : m_lookup) {
+        position -= position > index ? 1 : 0;
+    }
+    if (m_entries.empty()) {
+        m_heapBegin = uint32_t(m_image.size());
+    }
+    StoreIndex(index);
+    StoreHeader();
+    return true;
+}
+
+
+size_t DataStore::GetDirtyBytes() const {
+    return std::accumulate(m_dirty.begin(), m_dirty.end(), size_t(0), [](size_t sum, const auto& range) {
+        return sum + (range.second - range.first);
+    });
+}
+
+
+asyncpp::task<void> DataStore::Commit() {
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (const auto& [first, last] : m_dirty) {
+        if (!ranges.empty() && first - ranges.back().second <= dirtyMergeGap) {
+            ranges.back().second = last;
+        }
+        else {
+            ranges.emplace_back(first, last);
+        }
+    }
+    // Values go first, then the index, and the header in a separate, final write,
+    // so a new entry only becomes visible once its index entry and value are in
+    // place. That doesn't make a commit atomic: values overwritten in place and
+    // values moved by compaction can still be torn by an interruption.
+    const auto image = std::span<const std::byte>(m_image);
+    bool isHeaderDirty = false;
+    for (auto it = ranges.rbegin(); it != ranges.rend(); ++it) {
+        const auto first = std::max(it->first, headerSize);
+        isHeaderDirty = isHeaderDirty || it->first < headerSize;
+        if (first < it->second) {
+            co_await m_session->WriteBytes(m_table, first, image.subspan(first, it->second - first));
+        }
+    }
+    if (isHeaderDirty) {
+        co_await m_session->WriteBytes(m_table, 0, image.first(headerSize));
+    }
+    m_dirty.clear();
+}
+
+
+bool DataStore::ParseHeader() {
+    const auto image = std::span<const std::byte>(m_image);
+    if (!std::ranges::equal(image.first(magic.size()), magic) || ReadInteger(image, 4, 2) != version) {
+        return false;
+    }
+    m_indexEnd = ReadInteger(image, 8, 4);
+    m_heapBegin = ReadInteger(image, 12, 4);
+    if (m_indexEnd < headerSize || m_indexEnd > m_heapBegin || m_heapBegin > m_image.size()) {
+        throw CorruptStore("index or values out of bounds");
+    }
+    m_unknownFirst = m_indexEnd;
+    m_unknownLast = m_heapBegin;
+    return true;
+}
+
+
+void DataStore::ParseIndex() {
+    const auto image = std::span<const std::byte>(m_image);
+    const auto count = ReadInteger(image, 6, 2);
+    size_t position = headerSize;
+    for (size_t index = 0; index < count; ++index) {
+        if (position + 1 > m_indexEnd || position + 1 + size_t(image[position]) + 8 > m_indexEnd) {
+            throw CorruptStore("index entry out of bounds");
+        }
+        const auto keySize = size_t(image[position]);
+        const auto keyBytes = image.subspan(position + 1, keySize);
+        Entry entry{
+            .key = std::string(reinterpret_cast<const char*>(keyBytes.data()), keyBytes.size()),
+            .offset = ReadInteger(image, position + 1 + keySize, 4),
+            .length = ReadInteger(image, position + 5 + keySize, 4),
+        };
+        if (entry.offset < m_heapBegin || size_t(entry.offset) + entry.length > m_image.size()) {
+            throw CorruptStore(std::format("value of '{}' out of bounds", entry.key));
+        }
+        if (!m_lookup.emplace(entry.key, index).second) {
+            throw CorruptStore(std::format("duplicate key '{}'", entry.key));
+        }
+        m_entries.push_back(std::move(entry));
+        position += entryOverhead + keySize;
+    }
+    if (position != m_indexEnd) {
+        throw CorruptStore("index size mismatch");
+    }
+}
+
+
+void DataStore::Format() {
+    m_entries.clear();
+    m_lookup.clear();
+    m_indexEnd = headerSize;
+    m_heapBegin = uint32_t(m_image.size());
+    m_unknownFirst = headerSize;
+    m_unknownLast = uint32_t(m_image.size());
+    StoreHeader();
+}
+
+
+std::optional<uint32_t> DataStore::Allocate(uint32_t length, uint32_t indexEnd) const {
+    if (m_heapBegin < indexEnd || m_heapBegin - indexEnd < length) {
+        return std::nullopt;
+    }
+    return m_heapBegin - length;
+}
+
+
+uint32_t DataStore::GetLiveBytes() const {
+    return std::accumulate(m_entries.begin(), m_entries.end(), uint32_t(0), [](uint32_t sum, const Entry& entry) {
+        return sum + entry.length;
+    });
+}
+
+
+void DataStore::Compact() {
+    std::vector<Bytes> values;
+    for (const auto& entry : m_entries) {
+        const auto value = std::span<const std::byte>(m_image).subspan(entry.offset, entry.length);
+        values.emplace_back(value.begin(), value.end());
+    }
+    auto offset = uint32_t(m_image.size());
+    for (size_t index = 0; index < m_entries.size(); ++index) {
+        offset -= m_entries[index].length;
+        m_entries[index].offset = offset;
+        Store(offset, values[index]);
+    }
+    m_heapBegin = offset;
+    StoreIndex(0);
+    StoreHeader();
+}
+
+
+void DataStore::Store(uint32_t offset, std::span<const std::byte> bytes) {
+    // Only the bytes that differ from the device are marked dirty. Bytes that
+    // were not read are always written.
+    const auto last = offset + uint32_t(bytes.size());
+    const auto differs = [&](uint32_t position) {
+        return m_image[position] != bytes[position - offset] || (m_unknownFirst <= position && position < m_unknownLast);
+    };
+    for (auto position = offset; position < last;) {
+        if (!differs(position)) {
+            ++position;
+            continue;
+        }
+        const auto first = position;
+        while (position < last && differs(position)) {
+            m_image[position] = bytes[position - offset];
+            ++position;
+        }
+        MarkDirty(first, position);
+    }
+    // The index and the values grow from the edges of the unknown part, which
+    // shrinks accordingly.
+    if (offset <= m_unknownFirst && m_unknownFirst < last) {
+        m_unknownFirst = std::min(last, m_unknownLast);
+    }
+    if (offset < m_unknownLast && m_unknownLast <= last) {
+        m_unknownLast = std::max(offset, m_unknownFirst);
+    }
+}
+
+
+void DataStore::StoreHeader() {
+    Bytes header(magic.begin(), magic.end());
+    WriteInteger(header, version, 2);
+    WriteInteger(header, uint32_t(m_entries.size()), 2);
+    WriteInteger(header, m_indexEnd, 4);
+    WriteInteger(header, m_heapBegin, 4);
+    Store(0, header);
+}
+
+
+void DataStore::StoreIndex(size_t firstEntry) {
+    uint32_t position = headerSize;
+    for (size_t index = 0; index < firstEntry; ++index) {
+        position += entryOverhead + uint32_t(m_entries[index].key.size());
+    }
+    Bytes index;
+    for (size_t i = firstEntry; i < m_entries.size(); ++i) {
+        const auto& entry = m_entries[i];
+        index.push_back(std::byte(entry.key.size()));
+        std::ranges::transform(entry.key, std::back_inserter(index), [](char c) { return std::byte(c); });
+        WriteInteger(index, entry.offset, 4);
+        WriteInteger(index, entry.length, 4);
+    }
+    Store(position, index);
+}
+
+
+void DataStore::MarkDirty(uint32_t first, uint32_t last) {
+    auto it = m_dirty.upper_bound(first);
+    if (it != m_dirty.begin()) {
+        const auto previous = std::prev(it);
+        if (previous->second >= first) {
+            first = previous->first;
+            last = std::max(last, previous->second);
+            m_dirty.erase(previous);
+        }
+    }
+    while (it != m_dirty.end() && it->first <= last) {
+        last = std::max(last, it->second);
+        it = m_dirty.erase(it);
+    }
+    m_dirty.emplace(first, last);
+}
+
+} // namespace sedmgr
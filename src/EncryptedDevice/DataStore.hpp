@@ -0,0 +1,85 @@
+#pragma once
+
+#include "EncryptedDevice.hpp"
+
+#include <Specification/Opal/OpalModule.hpp>
+
+#include <asyncpp/task.hpp>
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace sedmgr {
+
+// A key-value store for small per-drive metadata, kept in a byte table such as
+// Opal's DataStore. Load reads the store once, after which reads are served from
+// the host's copy. Changes only touch the host's copy until Commit, which writes
+// back the byte ranges that differ from the device. Commit is not atomic, an
+// interrupted one may leave values torn.
+//
+// The table starts with a header and an index of the keys. Values are allocated
+// downwards from the end of the table, and are only moved when the free space
+// in between runs out. All integers are big-endian.
+//   header: "SDKV", version (2), count (2), index end (4), heap begin (4)
+//   entry:  key length (1), key, value offset (4), value length (4)
+class DataStore {
+public:
+    DataStore(const DataStore&) = delete;
+    DataStore& operator=(const DataStore&) = delete;
+    DataStore(DataStore&&) = default;
+    DataStore& operator=(DataStore&&) = default;
+
+    // A table that doesn't hold a store yet is loaded as an empty store, which
+    // is written on the first Commit. The session must outlive the store.
+    static asyncpp::task<DataStore> Load(SimpleSession& session, UID table = UID(opal::eTable::DataStore));
+
+    // The value stays valid until the store is changed.
+    std::optional<std::span<const std::byte>> Get(std::string_view key) const;
+    std::vector<std::string> Keys() const;
+    size_t Size() const;
+    void Put(std::string_view key, std::span<const std::byte> value);
+    bool Erase(std::string_view key);
+
+    size_t GetDirtyBytes() const;
+    asyncpp::task<void> Commit();
+
+private:
+    struct Entry {
+        std::string key;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    DataStore(SimpleSession& session, UID table, Bytes image);
+    bool ParseHeader();
+    void ParseIndex();
+    void Format();
+    std::optional<uint32_t> Allocate(uint32_t length, uint32_t indexEnd) const;
+    uint32_t GetLiveBytes() const;
+    void Compact();
+    void Store(uint32_t offset, std::span<const std::byte> bytes);
+    void StoreHeader();
+    void StoreIndex(size_t firstEntry);
+    void MarkDirty(uint32_t first, uint32_t last);
+
+private:
+    SimpleSession* m_session;
+    UID m_table;
+    Bytes m_image;
+    std::vector<Entry> m_entries;
+    std::map<std::string, size_t, std::less<>> m_lookup;
+    uint32_t m_indexEnd = 0;
+    uint32_t m_heapBegin = 0;
+    // The part of the table that was not read, so its contents are not known.
+    uint32_t m_unknownFirst = 0;
+    uint32_t m_unknownLast = 0;
+    std::map<uint32_t, uint32_t> m_dirty;
+};
+
+} // namespace sedmgr
@@ -1,9 +1,17 @@
 #include "EncryptedDevice.hpp"
 
+#include <Error/Exception.hpp>
 #include <Specification/Core/CoreModule.hpp>
 
 #include <asyncpp/join.hpp>
-
+#include <asyncpp/sleep.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <limits>
 #include <stdexcept>
 
 
@@ -12,7 +20,7 @@ namespace sedmgr {
 static const std::unordered_map<std::string, uint32_t> hostProperties = {
     {"MaxPackets",        1    },
     { "MaxSubpackets",    1    },
-    { "MaxMethods",       1    },
+    { "MaxMethods",       16   },
     { "MaxComPacketSize", 65536},
     { "MaxIndTokenSize",  65536},
     { "MaxAggTokenSize",  65536},
@@ -22,17 +30,79 @@ static const std::unordered_map<std::string, uint32_t> hostProperties = {
     { "Asynchronous",     0    },
 };
 
+static constexpr uint32_t rowBatchSize = 64;
+// Room for the packet headers and the method call around the bytes of a Get or Set.
+static constexpr uint32_t byteCallOverhead = 256;
+
+
+static void RecordRecovery(Metrics& metrics, eRecoveryAction action) {
+    switch (action) {
+        case eRecoveryAction::FAIL: metrics.RecordRetryExhausted(); break;
+        case eRecoveryAction::RETRY: metrics.RecordRetry(); break;
+        case eRecoveryAction::RESTART_SESSION: metrics.RecordSessionRestart(); break;
+        case eRecoveryAction::STACK_RESET: metrics.RecordRecoveryReset(); break;
+    }
+}
+
+
+// Decides how to recover from a failed attempt, and rethrows the failure when
+// trying again won't help.
+static eRecoveryAction NextRecovery(RetryState& retry, std::exception_ptr failure, Metrics& metrics) {
+    const auto failureClass = RetryPolicy::Classify(failure);
+    const auto action = retry.Next(failureClass);
+    if (action != eRecoveryAction::FAIL) {
+        RecordRecovery(metrics, action);
+        return action;
+    }
+    if (failureClass != eFailureClass::PERMANENT && retry.GetFailures() > 1) {
+        RecordRecovery(metrics, action);
+    }
+    std::rethrow_exception(failure);
+}
+
+
+// The discovery results and the loaded modules don't change with a reset, and
+// the ComID survives as long as the TPer still considers it valid. Only the
+// communication properties, which go back to their defaults, are negotiated again.
+// Returns false if the ComID is gone, in which case the TPer has to be replaced.
+static asyncpp::task<bool> ResumeComId(TrustedPeripheral& tper, SessionManager& sessionManager) {
+    const auto comIdState = co_await tper.VerifyComId();
+    if (comIdState != eComIdState::ISSUED && comIdState != eComIdState::ASSOCIATED) {
+        co_return false;
+    }
+    co_await sessionManager.Properties(hostProperties);
+    co_return true;
+}
+
 
 SimpleSession::SimpleSession(std::shared_ptr<TrustedPeripheral> tper,
                              std::shared_ptr<Session> session,
-                             UID securityProvider)
+                             UID securityProvider,
+                             RetryPolicy retryPolicy)
     : m_tper(std::move(tper)),
       m_session(std::move(session)),
-      m_securityProvider(securityProvider) {}
+      m_sessionManager(m_session->GetSessionManager()),
+      m_securityProvider(securityProvider),
+      m_retryPolicy(retryPolicy) {}
 
 
 SimpleSession::~SimpleSession() {
-    join(End());
+    if (!m_session) {
+        return;
+    }
+    // Pending writes are flushed and the session ended on the drain queue. That
+    // can only log failed writes, call End to see them. Resetting the stack
+    // from there would flush the queue from one of its own jobs, so failures
+    // aren't retried.
+    try {
+        const auto drainQueue = m_tper->GetDrainQueue();
+        const auto closing = std::make_shared<SimpleSession>(std::move(*this));
+        closing->SetRetryPolicy(RetryPolicy::None());
+        drainQueue->Post([closing] { return closing->End(); });
+    }
+    catch (std::exception& ex) {
+        std::cerr << "error while closing session: " << ex.what() << std::endl;
+    }
 }
 
 
@@ -46,15 +116,22 @@ UID SimpleSession::GetSecurityProvider() const {
 
 
 asyncpp::task<void> SimpleSession::Authenticate(UID authority, std::optional<std::vector<std::byte>> password) {
-    co_return co_await m_session->base.Authenticate(authority, password);
+    co_await Flush();
+    co_await Retry([&] { return m_session->base.Authenticate(authority, password); });
+    m_authentications.push_back({ authority, std::move(password) });
 }
 
 
 asyncpp::task<void> SimpleSession::End() {
+    std::vector<ColumnWriteFailure> failures;
     if (m_session) {
+        failures = co_await TryFlush();
         co_await m_session->End();
     }
     m_session = nullptr;
+    if (!failures.empty()) {
+        failures.front().error.Throw("Set");
+    }
 }
 
 
@@ -67,12 +144,19 @@ asyncpp::stream<UID> SimpleSession::GetTableRows(UID table) {
         co_yield *desc->singleRow;
     }
     else {
+        // Rows are fetched in batches to avoid one round-trip per row.
         std::optional<UID> lastUid = std::nullopt;
-        while (const auto rowUid = co_await m_session->base.Next(table, lastUid)) {
-            if (*rowUid != UID(0)) {
-                co_yield *rowUid;
+        while (true) {
+            const auto rowUids = co_await m_session->base.Next(table, lastUid, rowBatchSize);
+            if (rowUids.empty()) {
+                break;
             }
-            lastUid = *rowUid;
+            for (const auto rowUid : rowUids) {
+                if (rowUid != UID(0)) {
+                    co_yield rowUid;
+                }
+            }
+            lastUid = rowUids.back();
         }
     }
 }
@@ -83,6 +167,7 @@ asyncpp::stream<Value> SimpleSession::GetObjectColumns(UID object) {
     if (!maybeTableDesc) {
         throw std::invalid_argument(std::format("could not find table description: {}", object.ToString()));
     }
+    co_await FlushObject(object);
     uint32_t index = 0;
     for (const auto& column : maybeTableDesc->columns) {
         co_yield co_await m_session->base.Get(object, index);
@@ -91,58 +176,325 @@ asyncpp::stream<Value> SimpleSession::GetObjectColumns(UID object) {
 }
 
 
+asyncpp::task<std::vector<Value>> SimpleSession::GetObjectValues(UID object) {
+    const auto maybeTableDesc = m_tper->GetModules().FindTable(object.ContainingTable());
+    if (!maybeTableDesc) {
+        throw std::invalid_argument(std::format("could not find table description: {}", object.ToString()));
+    }
+    co_await FlushObject(object);
+    co_return co_await Retry([&] { return m_session->base.Get(object, 0, uint32_t(maybeTableDesc->columns.size())); });
+}
+
+
+asyncpp::task<std::vector<Value>> SimpleSession::GetObjectValues(UID object, uint32_t startColumn, uint32_t endColumn) {
+    co_await FlushObject(object);
+    co_return co_await Retry([&] { return m_session->base.Get(object, startColumn, endColumn); });
+}
+
+
 asyncpp::task<Value> SimpleSession::GetValue(UID object, uint32_t column) {
-    co_return co_await m_session->base.Get(object, column);
+    co_await FlushObject(object);
+    co_return co_await Retry([&] { return m_session->base.Get(object, column); });
 }
 
 
 asyncpp::task<void> SimpleSession::SetValue(UID object, uint32_t column, Value value) {
-    co_await m_session->base.Set(object, column, value);
+    if (m_writeBehind) {
+        if (m_pendingWrite && m_pendingWrite->object != object) {
+            co_await Flush();
+        }
+        if (!m_pendingWrite) {
+            m_pendingWrite = PendingWrite{ object, {} };
+        }
+        m_pendingWrite->columns.insert_or_assign(column, std::move(value));
+        co_return;
+    }
+    co_await Flush();
+    co_await Retry([&] { return m_session->base.Set(object, column, value); });
+}
+
+
+asyncpp::task<MethodExpected<Value>> SimpleSession::TryGetValue(UID object, uint32_t column) {
+    if (m_pendingWrite && m_pendingWrite->object == object) {
+        auto failures = co_await TryFlush();
+        if (!failures.empty()) {
+            co_return MethodExpected<Value>(Unexpected(std::move(failures.front().error)));
+        }
+    }
+    co_return co_await m_session->base.TryGet(object, column);
+}
+
+
+asyncpp::task<MethodExpected<void>> SimpleSession::TrySetValue(UID object, uint32_t column, Value value) {
+    auto failures = co_await TryFlush();
+    if (!failures.empty()) {
+        co_return MethodExpected<void>(Unexpected(std::move(failures.front().error)));
+    }
+    co_return co_await m_session->base.TrySet(object, column, value);
+}
+
+
+asyncpp::task<std::vector<MethodExpected<std::vector<Value>>>> SimpleSession::TryGetObjectValues(std::vector<CellRange> ranges) {
+    co_await Flush();
+    co_return co_await m_session->base.TryGet(ranges);
+}
+
+
+asyncpp::task<Bytes> SimpleSession::ReadBytes(UID table, uint32_t offset, uint32_t length) {
+    co_await Flush();
+    const auto maxBytes = GetMaxBytesPerCall();
+    Bytes bytes;
+    bytes.reserve(length);
+    for (uint32_t first = 0; first < length;) {
+        const auto last = first + std::min(maxBytes, length - first);
+        const auto chunk = co_await Retry([&] { return m_session->base.GetBytes(table, offset + first, offset + last); });
+        bytes.insert(bytes.end(), chunk.begin(), chunk.end());
+        first = last;
+    }
+    co_return bytes;
+}
+
+
+asyncpp::task<void> SimpleSession::WriteBytes(UID table, uint32_t offset, std::span<const std::byte> bytes) {
+    co_await Flush();
+    const auto maxBytes = GetMaxBytesPerCall();
+    for (size_t first = 0; first < bytes.size();) {
+        const auto count = std::min<size_t>(maxBytes, bytes.size() - first);
+        co_await Retry([&] { return m_session->base.SetBytes(table, uint32_t(offset + first), bytes.subspan(first, count)); });
+        first += count;
+    }
+}
+
+
+void SimpleSession::SetWriteBehind(bool enabled) {
+    m_writeBehind = enabled;
+}
+
+
+void SimpleSession::SetCancellation(CancellationToken cancellation) {
+    if (m_session) {
+        m_session->SetCancellation(cancellation);
+    }
+    m_cancellation = std::move(cancellation);
+}
+
+
+void SimpleSession::SetRetryPolicy(RetryPolicy retryPolicy) {
+    m_retryPolicy = retryPolicy;
+}
+
+
+asyncpp::task<void> SimpleSession::Flush() {
+    const auto failures = co_await TryFlush();
+    if (!failures.empty()) {
+        failures.front().error.Throw("Set");
+    }
+}
+
+
+asyncpp::task<std::vector<SimpleSession::ColumnWriteFailure>> SimpleSession::TryFlush(bool isolateFailures) {
+    if (!m_pendingWrite) {
+        co_return std::vector<ColumnWriteFailure>{};
+    }
+    const auto pending = std::move(*m_pendingWrite);
+    m_pendingWrite = std::nullopt;
+
+    std::vector<uint32_t> columns;
+    std::vector<Value> values;
+    for (const auto& [column, value] : pending.columns) {
+        columns.push_back(column);
+        values.push_back(value);
+    }
+    const auto result = co_await m_session->base.TrySet(pending.object, columns, values);
+    if (result) {
+        co_return std::vector<ColumnWriteFailure>{};
+    }
+    std::vector<ColumnWriteFailure> failures;
+    if (!isolateFailures || columns.size() == 1 || result.error().exception) {
+        for (const auto column : columns) {
+            failures.push_back({ pending.object, column, result.error() });
+        }
+        co_return failures;
+    }
+
+    // The merged Set fails as a whole, so the columns are retried one by one
+    // to tell which of them the TPer rejects.
+    for (size_t i = 0; i < columns.size(); ++i) {
+        const auto columnResult = co_await m_session->base.TrySet(pending.object, columns[i], values[i]);
+        if (!columnResult) {
+            failures.push_back({ pending.object, columns[i], columnResult.error() });
+        }
+    }
+    co_return failures;
+}
+
+
+asyncpp::task<void> SimpleSession::FlushObject(UID object) {
+    if (m_pendingWrite && m_pendingWrite->object == object) {
+        co_await Flush();
+    }
+}
+
+
+uint32_t SimpleSession::GetMaxBytesPerCall() const {
+    const auto lookup = [](const SessionManager::PropertyMap& properties, const std::string& name) {
+        const auto it = properties.find(name);
+        return it != properties.end() && it->second != 0 ? it->second : std::numeric_limits<uint32_t>::max();
+    };
+    uint32_t limit = std::numeric_limits<uint32_t>::max();
+    for (const auto* properties : { &m_sessionManager->GetTPerProperties(), &m_sessionManager->GetHostProperties() }) {
+        limit = std::min({ limit, lookup(*properties, "MaxComPacketSize"), lookup(*properties, "MaxIndTokenSize") });
+    }
+    if (limit == std::numeric_limits<uint32_t>::max()) {
+        limit = hostProperties.at("MaxIndTokenSize");
+    }
+    // The bytes of a single token are limited by MaxIndTokenSize, the whole call by MaxComPacketSize.
+    return limit > 2 * byteCallOverhead ? limit - byteCallOverhead : byteCallOverhead;
+}
+
+
+template <class Attempt>
+auto SimpleSession::Retry(Attempt attempt) -> decltype(attempt()) {
+    RetryState retry(m_retryPolicy);
+    auto recovery = eRecoveryAction::RETRY;
+    while (true) {
+        std::exception_ptr failure;
+        try {
+            // A failed recovery counts as a failed attempt, so it's part of the try.
+            co_await Recover(recovery);
+            co_return co_await attempt();
+        }
+        catch (...) {
+            failure = std::current_exception();
+        }
+        recovery = NextRecovery(retry, failure, *m_tper->GetMetrics());
+        if (recovery != eRecoveryAction::STACK_RESET) {
+            co_await asyncpp::sleep_for(std::min(retry.Backoff(), m_cancellation.Remaining()));
+        }
+    }
+}
+
+
+asyncpp::task<void> SimpleSession::Recover(eRecoveryAction action) {
+    if (action == eRecoveryAction::STACK_RESET) {
+        // The stack reset aborts this session along with its siblings, so it's not
+        // ended separately. The siblings fail on their next call, see below.
+        co_await m_tper->StackReset();
+        if (!co_await ResumeComId(*m_tper, *m_sessionManager)) {
+            throw std::runtime_error("the ComID became invalid after resetting the stack, the device must be started again");
+        }
+    }
+    if (action == eRecoveryAction::RETRY && m_session) {
+        // A reset by another session closed this one on the TPer. Starting it
+        // again behind the caller's back would lose its state, like transactions.
+        if (m_session->IsReset()) {
+            throw std::runtime_error("the session was closed by a reset of the stack");
+        }
+        co_return;
+    }
+    // The old session is ended before starting the new one, as it may hold the SP.
+    m_session = nullptr;
+    auto session = std::make_shared<Session>(co_await Session::Start(m_sessionManager, m_securityProvider));
+    session->SetCancellation(m_cancellation);
+    for (const auto& [authority, password] : m_authentications) {
+        co_await session->base.Authenticate(authority, password);
+    }
+    m_session = std::move(session);
+}
+
+
+asyncpp::task<Transaction> SimpleSession::StartTransaction() {
+    co_await Flush();
+    co_return m_session->StartTransaction();
 }
 
 
 asyncpp::task<void> SimpleSession::GenMEK(UID lockingRange) {
+    co_await Flush();
     co_await m_session->base.GenKey(lockingRange);
 }
 
 
 asyncpp::task<void> SimpleSession::GenPIN(UID credentialObject, uint32_t length) {
+    co_await Flush();
     co_await m_session->base.GenKey(credentialObject, std::nullopt, length);
 }
 
 
 asyncpp::task<void> SimpleSession::Revert(UID securityProvider) {
+    co_await Flush();
     co_await m_session->opal.Revert(securityProvider);
     co_await End();
 }
 
 
 asyncpp::task<void> SimpleSession::Activate(UID securityProvider) {
+    co_await Flush();
     co_await m_session->opal.Activate(securityProvider);
 }
 
 
-EncryptedDevice::EncryptedDevice(std::shared_ptr<StorageDevice> device)
-    : EncryptedDevice(join(Start(device))) {}
+EncryptedDevice::EncryptedDevice(std::shared_ptr<StorageDevice> device, std::optional<std::filesystem::path> lockDirectory)
+    : EncryptedDevice(join(Start(device, nullptr, std::move(lockDirectory)))) {}
 
 
 EncryptedDevice::EncryptedDevice(std::shared_ptr<StorageDevice> device,
                                  std::shared_ptr<TrustedPeripheral> tper,
-                                 std::shared_ptr<SessionManager> sessionManager)
+                                 std::shared_ptr<SessionManager> sessionManager,
+                                 std::shared_ptr<DeviceLock> deviceLock)
     : m_device(device),
       m_tper(tper),
-      m_sessionManager(sessionManager) {}
+      m_sessionManager(sessionManager),
+      m_deviceLock(deviceLock) {}
 
 
-asyncpp::task<EncryptedDevice> EncryptedDevice::Start(std::shared_ptr<StorageDevice> device) {
-    const auto tper = std::make_shared<TrustedPeripheral>(device);
+asyncpp::task<EncryptedDevice> EncryptedDevice::Start(std::shared_ptr<StorageDevice> device,
+                                                      std::shared_ptr<Metrics> metrics,
+                                                      std::optional<std::filesystem::path> lockDirectory,
+                                                      CancellationToken lockCancellation) {
+    using namespace std::chrono_literals;
+
+    if (!metrics) {
+        metrics = std::make_shared<Metrics>();
+    }
+    std::shared_ptr<DeviceLock> deviceLock;
+    if (lockDirectory) {
+        // A stack reset still queued by a previous TPer of this process holds the
+        // lock, so it's run first instead of waiting for the worker to get to it.
+        co_await DrainQueue::ForDevice(*device)->Flush();
+        deviceLock = std::make_shared<DeviceLock>(device->GetDesc().serial, *lockDirectory);
+        const auto start = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds delay = 1ms;
+        while (!deviceLock->TryAcquire()) {
+            // Dropping the lock object takes this waiter off the queue.
+            if (lockCancellation.IsCancelled()) {
+                throw DeviceError(std::format("gave up waiting for the lock on drive '{}' after {} ms, another process is using it",
+                                              device->GetDesc().serial,
+                                              std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()));
+            }
+            co_await asyncpp::sleep_for(std::min(delay, lockCancellation.Remaining()));
+            delay = std::min<std::chrono::nanoseconds>(delay * 2, 50ms);
+        }
+        metrics->RecordLockWait(std::chrono::steady_clock::now() - start);
+    }
+    co_return co_await Connect(std::move(device), std::move(metrics), std::move(deviceLock));
+}
+
+
+asyncpp::task<EncryptedDevice> EncryptedDevice::Connect(std::shared_ptr<StorageDevice> device,
+                                                        std::shared_ptr<Metrics> metrics,
+                                                        std::shared_ptr<DeviceLock> deviceLock) {
+    // A stack reset left behind by a previous TPer on the device would otherwise
+    // hit this one, as statically allocated ComIDs are the same.
+    co_await DrainQueue::ForDevice(*device)->Flush();
+    const auto tper = std::make_shared<TrustedPeripheral>(device, std::move(metrics), deviceLock);
     const auto comIdState = co_await tper->VerifyComId();
     if (comIdState != eComIdState::ISSUED && comIdState != eComIdState::ASSOCIATED) {
         throw std::runtime_error("failed to acquire valid ComID");
     }
     const auto sessionManager = std::make_shared<SessionManager>(tper);
     auto [tperProps, hostProps] = co_await sessionManager->Properties(hostProperties);
-    co_return EncryptedDevice(device, tper, sessionManager);
+    co_return EncryptedDevice(device, tper, sessionManager, std::move(deviceLock));
 }
 
 
@@ -156,20 +508,67 @@ const ModuleCollection& EncryptedDevice::GetModules() const {
 }
 
 
+const Metrics& EncryptedDevice::GetMetrics() const {
+    return *m_tper->GetMetrics();
+}
+
+
 asyncpp::task<SimpleSession> EncryptedDevice::Login(UID securityProvider) {
-    const auto session = std::make_shared<Session>(co_await Session::Start(m_sessionManager, securityProvider));
-    co_return SimpleSession(m_tper, session, securityProvider);
+    RetryState retry(m_retryPolicy);
+    auto recovery = eRecoveryAction::RETRY;
+    while (true) {
+        std::exception_ptr failure;
+        try {
+            // There's no session of our own to restart, the next attempt starts one anyway.
+            if (recovery == eRecoveryAction::STACK_RESET) {
+                co_await StackReset();
+            }
+            const auto session = std::make_shared<Session>(co_await Session::Start(m_sessionManager, securityProvider));
+            session->SetCancellation(m_cancellation);
+            co_return SimpleSession(m_tper, session, securityProvider, m_retryPolicy);
+        }
+        catch (...) {
+            failure = std::current_exception();
+        }
+        recovery = NextRecovery(retry, failure, *m_tper->GetMetrics());
+        if (recovery != eRecoveryAction::STACK_RESET) {
+            co_await asyncpp::sleep_for(std::min(retry.Backoff(), m_cancellation.Remaining()));
+        }
+    }
+}
+
+
+void EncryptedDevice::SetCancellation(CancellationToken cancellation) {
+    m_sessionManager->SetCancellation(cancellation);
+    m_cancellation = std::move(cancellation);
+}
+
+void EncryptedDevice::SetRetryPolicy(RetryPolicy retryPolicy) {
+    m_retryPolicy = retryPolicy;
 }
 
+
 asyncpp::task<void> EncryptedDevice::StackReset() {
     co_await m_tper->StackReset();
-    *this = co_await Start(m_device);
+    co_await Resume();
 }
 
 
 asyncpp::task<void> EncryptedDevice::Reset() {
     co_await m_tper->Reset();
-    *this = co_await Start(m_device);
+    co_await Resume();
+}
+
+
+asyncpp::task<void> EncryptedDevice::Resume() {
+    if (!co_await ResumeComId(*m_tper, *m_sessionManager)) {
+        // The new TPer takes over the lock this one holds.
+        auto cancellation = std::move(m_cancellation);
+        const auto retryPolicy = m_retryPolicy;
+        *this = co_await Connect(m_device, m_tper->GetMetrics(), m_deviceLock);
+        SetCancellation(std::move(cancellation));
+        m_retryPolicy = retryPolicy;
+    }
 }
 
-} // namespace sedmgr
\ No newline at end of file
+} // namespace sedmgr
@@ -1,36 +1,94 @@
 #pragma once
 
+#include <Specification/Common/TableRow.hpp>
+#include <StorageDevice/DeviceLock.hpp>
 #include <StorageDevice/NvmeDevice.hpp>
+#include <TrustedPeripheral/RetryPolicy.hpp>
 #include <TrustedPeripheral/Session.hpp>
 #include <TrustedPeripheral/SessionManager.hpp>
 #include <TrustedPeripheral/TrustedPeripheral.hpp>
 
 #include <asyncpp/stream.hpp>
 
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <map>
+#include <span>
+
 
 namespace sedmgr {
 
 class SimpleSession {
+public:
+    struct ColumnWriteFailure {
+        UID object;
+        uint32_t column;
+        MethodError error;
+    };
+
 public:
     SimpleSession(std::shared_ptr<TrustedPeripheral> tper,
                   std::shared_ptr<Session> session,
-                  UID securityProvider);
+                  UID securityProvider,
+                  RetryPolicy retryPolicy = RetryPolicy::None());
 
     SimpleSession(const SimpleSession&) = delete;
     SimpleSession& operator=(const SimpleSession&) = delete;
     SimpleSession(SimpleSession&&) = default;
-    SimpleSession& operator=(SimpleSession&&) = default;
+    // Assigning over a session would drop its pending writes without ending it.
+    // End it or destroy it instead, see below.
+    SimpleSession& operator=(SimpleSession&&) = delete;
     ~SimpleSession();
 
     const ModuleCollection& GetModules() const;
     UID GetSecurityProvider() const;
     asyncpp::task<void> Authenticate(UID authority, std::optional<std::vector<std::byte>> password = {});
+    // Flushes pending writes and ends the session, reporting failures. Destroying
+    // the session does the same on the device's drain queue, without waiting.
     asyncpp::task<void> End();
 
     asyncpp::stream<UID> GetTableRows(UID table);
     asyncpp::stream<Value> GetObjectColumns(UID object);
+    asyncpp::task<std::vector<Value>> GetObjectValues(UID object);
+    // Gets columns [startColumn, endColumn) in a single call.
+    asyncpp::task<std::vector<Value>> GetObjectValues(UID object, uint32_t startColumn, uint32_t endColumn);
+    // Gets the given fields of a typed row, such as &core::LockingRow::readLocked,
+    // with a single Get that spans their columns. Without fields, all the columns
+    // the row maps are fetched.
+    template <TableRow Row, class... Fields>
+    asyncpp::task<Row> GetRow(UID object, Fields... fields);
     asyncpp::task<Value> GetValue(UID object, uint32_t column);
     asyncpp::task<void> SetValue(UID object, uint32_t column, Value value);
+    asyncpp::task<MethodExpected<Value>> TryGetValue(UID object, uint32_t column);
+    asyncpp::task<MethodExpected<void>> TrySetValue(UID object, uint32_t column, Value value);
+    // Reads all the ranges with as few packets as the TPer allows. Each range
+    // succeeds or fails on its own, and nothing is retried.
+    asyncpp::task<std::vector<MethodExpected<std::vector<Value>>>> TryGetObjectValues(std::vector<CellRange> ranges);
+    // Transfers rows of a byte table, split into as many calls as the packet
+    // size limits require. Each call is retried on its own.
+    asyncpp::task<Bytes> ReadBytes(UID table, uint32_t offset, uint32_t length);
+    asyncpp::task<void> WriteBytes(UID table, uint32_t offset, std::span<const std::byte> bytes);
+
+    // With write-behind, consecutive SetValues to the same object are merged into a
+    // single Set. They are sent when another object is set, when the object is read,
+    // before any other method, and on Flush or End.
+    void SetWriteBehind(bool enabled);
+    // Bounds every method call made after it's set. Once it expires, calls fail
+    // with CancelledError. If that happens while a response is due, the stack is
+    // reset, which aborts the session. End still closes the session either way.
+    void SetCancellation(CancellationToken cancellation);
+    // Applies to Authenticate, GetObjectValues, GetValue and SetValue. A restarted
+    // session repeats the authentications made so far. Methods with side effects
+    // on the device, like GenMEK, are never retried.
+    void SetRetryPolicy(RetryPolicy retryPolicy);
+    asyncpp::task<void> Flush();
+    // A failed merged Set fails for all of its columns. With isolateFailures, the
+    // columns are then set one by one to tell which of them the TPer rejects. That
+    // repeats the failing writes, so it's only worth it when the answer matters.
+    asyncpp::task<std::vector<ColumnWriteFailure>> TryFlush(bool isolateFailures = false);
+    // Flushes pending writes first, so that they're not reordered after the transaction.
+    asyncpp::task<Transaction> StartTransaction();
 
     asyncpp::task<void> GenMEK(UID lockingRange);
     asyncpp::task<void> GenPIN(UID credentialObject, uint32_t length);
@@ -38,37 +96,98 @@ public:
     asyncpp::task<void> Activate(UID securityProvider);
 
 private:
+    asyncpp::task<void> FlushObject(UID object);
+    uint32_t GetMaxBytesPerCall() const;
+    template <class Attempt>
+    auto Retry(Attempt attempt) -> decltype(attempt());
+    asyncpp::task<void> Recover(eRecoveryAction action);
+
+private:
+    struct PendingWrite {
+        UID object;
+        std::map<uint32_t, Value> columns;
+    };
+
+    struct Authentication {
+        UID authority;
+        std::optional<std::vector<std::byte>> password;
+    };
+
     std::shared_ptr<TrustedPeripheral> m_tper;
     std::shared_ptr<Session> m_session;
+    std::shared_ptr<SessionManager> m_sessionManager;
     UID m_securityProvider;
+    bool m_writeBehind = false;
+    std::optional<PendingWrite> m_pendingWrite;
+    RetryPolicy m_retryPolicy;
+    CancellationToken m_cancellation;
+    std::vector<Authentication> m_authentications;
 };
 
 
 class EncryptedDevice {
 public:
-    EncryptedDevice(std::shared_ptr<StorageDevice> device);
+    EncryptedDevice(std::shared_ptr<StorageDevice> device, std::optional<std::filesystem::path> lockDirectory = {});
     EncryptedDevice(const EncryptedDevice&) = delete;
     EncryptedDevice& operator=(const EncryptedDevice&) = delete;
     EncryptedDevice(EncryptedDevice&&) = default;
     EncryptedDevice& operator=(EncryptedDevice&&) = default;
 
-    static asyncpp::task<EncryptedDevice> Start(std::shared_ptr<StorageDevice> device);
+    // With a lock directory, waits for its turn on the DeviceLock of the drive
+    // before talking to it, and throws DeviceError if lockCancellation expires
+    // first. The lock is held until this object, its sessions and the stack reset
+    // its TPer leaves on the drain queue are all gone.
+    static asyncpp::task<EncryptedDevice> Start(std::shared_ptr<StorageDevice> device,
+                                                std::shared_ptr<Metrics> metrics = nullptr,
+                                                std::optional<std::filesystem::path> lockDirectory = {},
+                                                CancellationToken lockCancellation = {});
     const TPerDesc& GetDesc() const;
     const ModuleCollection& GetModules() const;
+    const Metrics& GetMetrics() const;
 
     asyncpp::task<SimpleSession> Login(UID securityProvider);
+    // Bounds Login and the calls of the sessions it returns, see SimpleSession.
+    void SetCancellation(CancellationToken cancellation);
+    // Applies to Login, which may reset the stack if the policy allows, and is
+    // passed on to the sessions it returns. By default, nothing is retried.
+    void SetRetryPolicy(RetryPolicy retryPolicy);
     asyncpp::task<void> StackReset();
     asyncpp::task<void> Reset();
 
 private:
     EncryptedDevice(std::shared_ptr<StorageDevice> device,
                     std::shared_ptr<TrustedPeripheral> tper,
-                    std::shared_ptr<SessionManager> sessionManager);
+                    std::shared_ptr<SessionManager> sessionManager,
+                    std::shared_ptr<DeviceLock> deviceLock);
+    static asyncpp::task<EncryptedDevice> Connect(std::shared_ptr<StorageDevice> device,
+                                                  std::shared_ptr<Metrics> metrics,
+                                                  std::shared_ptr<DeviceLock> deviceLock);
+    asyncpp::task<void> Resume();
 
 private:
     std::shared_ptr<StorageDevice> m_device;
     std::shared_ptr<TrustedPeripheral> m_tper;
     std::shared_ptr<SessionManager> m_sessionManager;
+    std::shared_ptr<DeviceLock> m_deviceLock;
+    CancellationToken m_cancellation;
+    RetryPolicy m_retryPolicy = RetryPolicy::None();
 };
 
+
+template <TableRow Row, class... Fields>
+asyncpp::task<Row> SimpleSession::GetRow(UID object, Fields... fields) {
+    if constexpr (sizeof...(Fields) == 0) {
+        co_return co_await std::apply([&](const auto&... columns) { return GetRow<Row>(object, columns.member...); }, Row::Columns());
+    }
+    else {
+        const std::array columns = { GetRowColumn<Row>(fields)... };
+        const auto [startColumn, lastColumn] = std::ranges::minmax(columns);
+        const auto values = co_await GetObjectValues(object, startColumn, lastColumn + 1);
+        Row row;
+        size_t index = 0;
+        (DecodeRowField(row.*fields, values[columns[index++] - startColumn]), ...);
+        co_return row;
+    }
+}
+
 } // namespace sedmgr
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "LockingRanges.hpp"
+
+#include <Specification/Core/Defs/TableRows.hpp>
+
+#include <format>
+#include <stdexcept>
+
+
+namespace sedmgr {
+
+std::vector<LockingRangeExtent> PlanLockingRanges(const std::optional<GeometryFeatureDesc>& geometry,
+                                                  uint64_t numLbas,
+                                                  size_t count) {
+    if (count == 0) {
+        throw std::invalid_argument("at least one locking range is required");
+    }
+    const uint64_t granularity = geometry && geometry->alignmentGranularity != 0 ? geometry->alignmentGranularity : 1;
+    const uint64_t lowestAligned = geometry ? geometry->lowestAlignedLba % granularity : 0;
+
+    // Aligned LBAs are lowestAligned + k * granularity.
+    const uint64_t firstAligned = lowestAligned;
+    const uint64_t numUnits = numLbas > firstAligned ? (numLbas - firstAligned) / granularity : 0;
+    if (numUnits < count) {
+        throw std::invalid_argument(std::format("cannot fit {} locking ranges aligned to {} blocks into {} blocks", count, granularity, numLbas));
+    }
+
+    std::vector<LockingRangeExtent> extents;
+    uint64_t rangeStart = firstAligned;
+    for (size_t index = 0; index < count; ++index) {
+        const uint64_t units = numUnits / count + (index < numUnits % count ? 1 : 0);
+        extents.push_back({ .rangeStart = rangeStart, .rangeLength = units * granularity });
+        rangeStart += units * granularity;
+    }
+    return extents;
+}
+
+
+asyncpp::task<void> ApplyLockingRanges(SimpleSession& session, std::span<const LockingRangeExtent> extents) {
+    std::vector<UID> ranges;
+    for (size_t index = 0; index < extents.size(); ++index) {
+        const auto name = std::format("Locking::Range{}", index + 1);
+        const auto range = session.GetModules().FindUid(name, session.GetSecurityProvider());
+        if (!range) {
+            throw std::invalid_argument(std::format("could not find locking range: {}", name));
+        }
+        ranges.push_back(*range);
+    }
+
+    auto transaction = co_await session.StartTransaction();
+    for (size_t index = 0; index < extents.size(); ++index) {
+        transaction.Set(ranges[index],
+                        { ColumnOf<&core::LockingRow::rangeStart>, ColumnOf<&core::LockingRow::rangeLength> },
+                        { Value(extents[index].rangeStart), Value(extents[index].rangeLength) });
+    }
+    co_await transaction.Commit();
+}
+
+} // namespace sedmgr
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "EncryptedDevice.hpp"
+
+#include <TrustedPeripheral/Discovery.hpp>
+
+#include <asyncpp/task.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace sedmgr {
+
+struct LockingRangeExtent {
+    uint64_t rangeStart;
+    uint64_t rangeLength;
+
+    bool operator==(const LockingRangeExtent&) const = default;
+};
+
+
+// Splits a namespace of numLbas logical blocks into count contiguous locking
+// ranges of nearly equal size. Range boundaries fall on the alignment
+// granularity of the geometry, the unaligned blocks at either end are only
+// covered by the global range.
+std::vector<LockingRangeExtent> PlanLockingRanges(const std::optional<GeometryFeatureDesc>& geometry,
+                                                  uint64_t numLbas,
+                                                  size_t count);
+
+// Writes the extents to Locking::Range1 onwards in a single transaction, so the
+// Sets are batched into as few packets as the TPer allows.
+asyncpp::task<void> ApplyLockingRanges(SimpleSession& session, std::span<const LockingRangeExtent> extents);
+
+} // namespace sedmgr
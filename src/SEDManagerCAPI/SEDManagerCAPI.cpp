@@ -1,10 +1,35 @@
+#include <Messaging/TokenStream.hpp>
 #include <Messaging/Value.hpp>
 #include <MockDevice/MockDevice.hpp>
 
 #include <EncryptedDevice/EncryptedDevice.hpp>
 #include <EncryptedDevice/ValueToJSON.hpp>
+#include <asyncpp/join.hpp>
+#include <asyncpp/mutex.hpp>
 #include <asyncpp/thread_pool.hpp>
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <concepts>
+#include <deque>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <variant>
+
+
+#ifdef __linux__
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+#endif
+
 
 #ifdef _WIN32
     #define SEDMANAGER_EXPORT __declspec(dllexport)
@@ -16,24 +41,42 @@
 using namespace sedmgr;
 
 
-static asyncpp::thread_pool threadPool(1);
-
-
 //------------------------------------------------------------------------------
-// Error handling
+// Executor
 //------------------------------------------------------------------------------
 
 
-static std::exception_ptr lastException;
+static std::mutex threadPoolMutex;
+static std::unique_ptr<asyncpp::thread_pool> threadPool;
+static size_t threadPoolSize = std::max(1u, std::thread::hardware_concurrency());
 
 
-void SetLastException() {
-    lastException = std::current_exception();
+static asyncpp::thread_pool& GetThreadPool() {
+    std::lock_guard lk(threadPoolMutex);
+    if (!threadPool) {
+        threadPool = std::make_unique<asyncpp::thread_pool>(threadPoolSize);
+    }
+    return *threadPool;
 }
 
 
-std::exception_ptr GetLastException() {
-    return lastException;
+extern "C"
+{
+    // Must be called before the first asynchronous operation is started.
+    SEDMANAGER_EXPORT bool CSetThreadPoolSize(size_t numThreads) {
+        std::lock_guard lk(threadPoolMutex);
+        if (threadPool || numThreads == 0) {
+            return false;
+        }
+        threadPoolSize = numThreads;
+        return true;
+    }
+
+
+    SEDMANAGER_EXPORT size_t CGetThreadPoolSize() {
+        std::lock_guard lk(threadPoolMutex);
+        return threadPoolSize;
+    }
 }
 
 
@@ -50,6 +93,11 @@ struct CString {
 };
 
 
+struct CBytes {
+    std::vector<std::byte> object;
+};
+
+
 struct CValue {
     Value object;
 };
@@ -65,27 +113,54 @@ struct CStorageDevice {
 };
 
 
+// Operations on the same device are serialized by its strand, operations on
+// different devices run in parallel on the thread pool. Sessions share the
+// strand of the device they were opened on.
+using Strand = std::shared_ptr<asyncpp::mutex>;
+
+
+// Synchronous calls read state that an operation in flight may replace, like
+// EncryptedDevice::Resume reconnecting, so they block until they get the strand.
+template <class Func>
+static auto WithStrand(const Strand& strand, Func func) -> std::invoke_result_t<Func&> {
+    return asyncpp::join([](const Strand& strand, Func& func) -> asyncpp::task<std::invoke_result_t<Func&>> {
+        asyncpp::unique_lock lk = co_await *strand;
+        co_return func();
+    }(strand, func));
+}
+
+
 struct CEncryptedDevice {
-    CEncryptedDevice(EncryptedDevice object) : object(std::make_shared<EncryptedDevice>(std::move(object))) {}
+    CEncryptedDevice(EncryptedDevice object, Strand strand)
+        : object(std::make_shared<EncryptedDevice>(std::move(object))), strand(std::move(strand)) {}
     std::shared_ptr<EncryptedDevice> object;
+    Strand strand;
 };
 
 
 struct CSession {
-    CSession(SimpleSession object) : object(std::make_shared<SimpleSession>(std::move(object))) {}
+    CSession(SimpleSession object, Strand strand)
+        : object(std::make_shared<SimpleSession>(std::move(object))), strand(std::move(strand)) {}
     std::shared_ptr<SimpleSession> object;
+    Strand strand;
 };
 
 
+// The host may destroy a future or a stream while its operation is running.
+// The operation therefore shares what it touches instead of using the handle.
 template <class T>
 struct CFuture {
     asyncpp::task<T> object;
+    Strand strand = std::make_shared<asyncpp::mutex>();
+    std::shared_ptr<std::exception_ptr> exception = std::make_shared<std::exception_ptr>();
 };
 
 
 template <class T>
 struct CStream {
-    asyncpp::stream<T> object;
+    std::shared_ptr<asyncpp::stream<T>> object;
+    Strand strand = std::make_shared<asyncpp::mutex>();
+    std::shared_ptr<std::exception_ptr> exception = std::make_shared<std::exception_ptr>();
 };
 
 
@@ -95,29 +170,146 @@ using CFutureSession = CFuture<SimpleSession>;
 using CFutureValue = CFuture<Value>;
 using CFutureString = CFuture<std::string>;
 using CFutureUID = CFuture<UID>;
+using CFutureBytes = CFuture<std::vector<std::byte>>;
 
 
 using CStreamUID = CStream<UID>;
 using CStreamString = CStream<std::string>;
 
 
+struct CUIDBatch {
+    std::vector<CUID> object;
+};
+
+
+// Plain C layout, filled in by CCompletionQueue_Drain.
+struct CCompletion {
+    uint64_t tag;
+    bool success;
+    void* object; // Result of futures that return an object, owned by the host.
+    CUID uid; // Result of UID futures.
+};
+
+
+// Completed futures are collected here instead of calling back on a worker
+// thread. On Linux, the eventfd is readable whenever the queue is not empty,
+// so hosts can wait on it in their own event loop and drain in bulk. Results
+// are owned by the queue until drained, and freed if they never are.
+class CompletionQueue {
+public:
+    using Deleter = void (*)(void*);
+
+    CompletionQueue() {
+#ifdef __linux__
+        m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "failed to create eventfd");
+        }
+#endif
+    }
+
+    CompletionQueue(const CompletionQueue&) = delete;
+    CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+    ~CompletionQueue() {
+        for (const auto& [completion, deleter] : m_completed) {
+            if (completion.object && deleter) {
+                deleter(completion.object);
+            }
+        }
+#ifdef __linux__
+        close(m_fd);
+#endif
+    }
+
+    int GetFd() const {
+        return m_fd;
+    }
+
+    void Push(CCompletion completion, Deleter deleter = nullptr) {
+        std::lock_guard lk(m_mutex);
+        m_completed.emplace_back(completion, deleter);
+        if (m_completed.size() == 1) {
+            Signal(true);
+        }
+    }
+
+    size_t Drain(std::span<CCompletion> out) {
+        std::lock_guard lk(m_mutex);
+        const auto count = std::min(out.size(), m_completed.size());
+        std::ranges::copy(m_completed | std::views::take(count) | std::views::keys, out.begin());
+        m_completed.erase(m_completed.begin(), m_completed.begin() + count);
+        if (count != 0 && m_completed.empty()) {
+            Signal(false);
+        }
+        return count;
+    }
+
+private:
+    void Signal(bool readable) {
+#ifdef __linux__
+        uint64_t counter = 1;
+        const auto result = readable ? write(m_fd, &counter, sizeof(counter)) : read(m_fd, &counter, sizeof(counter));
+        (void)result;
+#endif
+    }
+
+private:
+    std::mutex m_mutex;
+    std::deque<std::pair<CCompletion, Deleter>> m_completed;
+    int m_fd = -1;
+};
+
+
+struct CCompletionQueue {
+    std::shared_ptr<CompletionQueue> object;
+};
+
+
 //------------------------------------------------------------------------------
 // Error handling
 //------------------------------------------------------------------------------
 
+// Only valid for synchronous calls, asynchronous failures are stored in the
+// future or stream that failed.
+static thread_local std::exception_ptr lastException;
+
+
+void SetLastException() {
+    lastException = std::current_exception();
+}
+
+
+std::exception_ptr GetLastException() {
+    return lastException;
+}
+
+
+static std::string DescribeException(std::exception_ptr exception) {
+    try {
+        std::rethrow_exception(exception);
+    }
+    catch (std::exception& ex) {
+        return ex.what();
+    }
+    catch (...) {
+        return "unknown error";
+    }
+}
+
+
+static CString* GetExceptionMessage(std::exception_ptr exception) {
+    if (exception) {
+        return new CString{ DescribeException(exception) };
+    }
+    return nullptr;
+}
+
+
 extern "C"
 {
     SEDMANAGER_EXPORT CString* CGetLastException_Message() {
-        const auto lastException = GetLastException();
-        if (lastException) {
-            try {
-                std::rethrow_exception(lastException);
-            }
-            catch (std::exception& ex) {
-                return new CString{ ex.what() };
-            }
-        }
-        return nullptr;
+        return GetExceptionMessage(GetLastException());
     }
 }
 
@@ -145,6 +337,27 @@ extern "C"
     }
 }
 
+//------------------------------------------------------------------------------
+// CBytes
+//------------------------------------------------------------------------------
+
+extern "C"
+{
+    SEDMANAGER_EXPORT void CBytes_Destroy(CBytes* self) {
+        delete self;
+    }
+
+
+    SEDMANAGER_EXPORT const std::byte* CBytes_GetData(CBytes* self) {
+        return self->object.data();
+    }
+
+
+    SEDMANAGER_EXPORT size_t CBytes_GetLength(CBytes* self) {
+        return self->object.size();
+    }
+}
+
 //------------------------------------------------------------------------------
 // CValue
 //------------------------------------------------------------------------------
@@ -286,6 +499,38 @@ extern "C"
     SEDMANAGER_EXPORT void CValue_SetNamed(CValue* self, const CValue* name, const CValue* value) {
         self->object = Named{ name->object, value->object };
     }
+
+
+    // Packs the whole value into its TCG token stream encoding so that it
+    // crosses the FFI boundary in one call. Empty values become an empty buffer.
+    SEDMANAGER_EXPORT CBytes* CValue_Serialize(CValue* self) {
+        try {
+            if (!self->object.HasValue()) {
+                return new CBytes{};
+            }
+            return new CBytes{ Serialize(TokenStream{ Tokenize(self->object) }) };
+        }
+        catch (...) {
+            SetLastException();
+            return nullptr;
+        }
+    }
+
+
+    SEDMANAGER_EXPORT CValue* CValue_Deserialize(const std::byte* data, size_t length) {
+        try {
+            const auto stream = DeSerialize(Serialized<TokenStream>{ std::span(data, length) });
+            auto [value, rest] = DeTokenize(Tokenized<Value>{ stream.stream });
+            if (!rest.empty()) {
+                throw std::invalid_argument("unexpected tokens after value");
+            }
+            return new CValue{ std::move(value) };
+        }
+        catch (...) {
+            SetLastException();
+            return nullptr;
+        }
+    }
 }
 
 
@@ -427,7 +672,9 @@ extern "C"
 extern "C"
 {
     SEDMANAGER_EXPORT CFutureEncryptedDevice* CEncryptedDevice_Create(CStorageDevice* storageDevice) {
-        return new CFutureEncryptedDevice{ EncryptedDevice::Start(storageDevice->object) };
+        // The host can't cancel the future, so a drive held by a stuck process must not hang it forever.
+        constexpr auto lockTimeout = std::chrono::seconds(30);
+        return new CFutureEncryptedDevice{ EncryptedDevice::Start(storageDevice->object, nullptr, DeviceLock::DefaultDirectory(), CancellationToken::After(lockTimeout)) };
     }
 
 
@@ -437,55 +684,57 @@ extern "C"
 
 
     SEDMANAGER_EXPORT CFutureSession* CEncryptedDevice_Login(CEncryptedDevice* self, CUID securityProvider) {
-        return new CFutureSession{ self->object->Login(UID(securityProvider)) };
+        return new CFutureSession{ self->object->Login(UID(securityProvider)), self->strand };
     }
 
 
     SEDMANAGER_EXPORT CFutureVoid* CEncryptedDevice_StackReset(CEncryptedDevice* self) {
-        return new CFutureVoid{ self->object->StackReset() };
+        return new CFutureVoid{ self->object->StackReset(), self->strand };
     }
 
 
     SEDMANAGER_EXPORT CFutureVoid* CEncryptedDevice_Reset(CEncryptedDevice* self) {
-        return new CFutureVoid{ self->object->Reset() };
+        return new CFutureVoid{ self->object->Reset(), self->strand };
     }
 
 
     SEDMANAGER_EXPORT CFutureString* CEncryptedDevice_FindName(CEncryptedDevice* self,
                                                                CUID uid,
                                                                CUID securityProvider) {
-        const auto& modules = self->object->GetModules();
         const auto maybeSp = securityProvider != 0 ? std::optional(UID(securityProvider)) : std::nullopt;
-        const auto maybeName = modules.FindName(UID(uid), maybeSp);
-        return new CFutureString{ [](auto maybeName) -> asyncpp::task<std::string> {
+        return new CFutureString{ [](std::shared_ptr<EncryptedDevice> device, UID uid, std::optional<UID> maybeSp) -> asyncpp::task<std::string> {
+            const auto maybeName = device->GetModules().FindName(uid, maybeSp);
             if (!maybeName) {
                 throw std::invalid_argument("could not find name for UID");
             }
             co_return *maybeName;
-        }(maybeName) };
+        }(self->object, UID(uid), maybeSp),
+                                  self->strand };
     }
 
 
     SEDMANAGER_EXPORT CFutureUID* CEncryptedDevice_FindUID(CEncryptedDevice* self,
                                                            CString* name,
                                                            CUID securityProvider) {
-        const auto& modules = self->object->GetModules();
         const auto maybeSp = securityProvider != 0 ? std::optional(UID(securityProvider)) : std::nullopt;
-        const auto maybeUid = modules.FindUid(name->object, maybeSp);
-        return new CFutureUID{ [](auto maybeUid) -> asyncpp::task<UID> {
+        return new CFutureUID{ [](std::shared_ptr<EncryptedDevice> device, std::string name, std::optional<UID> maybeSp) -> asyncpp::task<UID> {
+            const auto maybeUid = device->GetModules().FindUid(name, maybeSp);
             if (!maybeUid) {
                 throw std::invalid_argument("could not find UID for name");
             }
             co_return *maybeUid;
-        }(maybeUid) };
+        }(self->object, name->object, maybeSp),
+                               self->strand };
     }
 
 
     SEDMANAGER_EXPORT CString* CEncryptedDevice_RenderValue(CEncryptedDevice* self, CValue* value, CType* type, CUID securityProvider) {
         try {
             const auto maybeSecurityProvider = securityProvider != 0 ? std::optional(UID(securityProvider)) : std::nullopt;
-            const auto nameConverter = [&](UID uid) { return self->object->GetModules().FindName(uid, maybeSecurityProvider); };
-            auto str = ValueToJSON(value->object, type->object, nameConverter).dump(2);
+            auto str = WithStrand(self->strand, [&] {
+                const auto nameConverter = [&](UID uid) { return self->object->GetModules().FindName(uid, maybeSecurityProvider); };
+                return ValueToJSON(value->object, type->object, nameConverter).dump(2);
+            });
             return new CString{ std::move(str) };
         }
         catch (...) {
@@ -498,8 +747,10 @@ extern "C"
     SEDMANAGER_EXPORT CValue* CEncryptedDevice_ParseValue(CEncryptedDevice* self, CString* str, CType* type, CUID securityProvider) {
         try {
             const auto maybeSecurityProvider = securityProvider != 0 ? std::optional(UID(securityProvider)) : std::nullopt;
-            const auto nameConverter = [&](std::string_view name) { return self->object->GetModules().FindUid(name, maybeSecurityProvider); };
-            auto value = JSONToValue(nlohmann::json::parse(str->object), type->object, nameConverter);
+            auto value = WithStrand(self->strand, [&] {
+                const auto nameConverter = [&](std::string_view name) { return self->object->GetModules().FindUid(name, maybeSecurityProvider); };
+                return JSONToValue(nlohmann::json::parse(str->object), type->object, nameConverter);
+            });
             return new CValue{ std::move(value) };
         }
         catch (...) {
@@ -507,12 +758,162 @@ extern "C"
             return nullptr;
         }
     }
+
+
+    SEDMANAGER_EXPORT CString* CEncryptedDevice_GetMetrics(CEncryptedDevice* self) {
+        try {
+            const auto summaryToJSON = [](const Histogram::Summary& summary) {
+                return nlohmann::json{
+                    { "count", summary.count },
+                    { "min",   summary.min   },
+                    { "mean",  summary.mean  },
+                    { "p50",   summary.p50   },
+                    { "p90",   summary.p90   },
+                    { "p99",   summary.p99   },
+                    { "max",   summary.max   },
+                };
+            };
+            nlohmann::json methods = nlohmann::json::object();
+            const auto snapshot = WithStrand(self->strand, [&] {
+                auto snapshot = self->object->GetMetrics().Snapshot();
+                for (const auto& [methodId, summary] : snapshot.methodLatency) {
+                    const auto name = self->object->GetModules().FindName(methodId);
+                    methods[name.value_or(methodId.ToString())] = summaryToJSON(summary);
+                }
+                return snapshot;
+            });
+            const nlohmann::json json = {
+                { "ifSendCount",      snapshot.ifSendCount                     },
+                { "ifRecvCount",      snapshot.ifRecvCount                     },
+                { "bytesSent",        snapshot.bytesSent                       },
+                { "bytesReceived",    snapshot.bytesReceived                   },
+                { "exchangeCount",    snapshot.exchangeCount                   },
+                { "pollCount",        snapshot.pollCount                       },
+                { "retryCount",       snapshot.retryCount                      },
+                { "sessionRestartCount", snapshot.sessionRestartCount          },
+                { "recoveryResetCount", snapshot.recoveryResetCount            },
+                { "retryExhaustedCount", snapshot.retryExhaustedCount          },
+                { "exchangeLatency",  summaryToJSON(snapshot.exchangeLatency)  },
+                { "pollsPerExchange", summaryToJSON(snapshot.pollsPerExchange) },
+                { "lockWait",         summaryToJSON(snapshot.lockWait)         },
+                { "methodLatency",    std::move(methods)                       },
+                { "endSessionLatency", summaryToJSON(snapshot.endSessionLatency) },
+            };
+            return new CString{ json.dump() };
+        }
+        catch (...) {
+            SetLastException();
+            return nullptr;
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
 // CSession
 //------------------------------------------------------------------------------
 
+// Layout of a table snapshot, all integers are little-endian:
+//   u32 row count, u32 column count
+//   for each row: u64 row UID, then for each column:
+//     u8 cell status, u32 content length, content bytes
+// The content is the value rendered to JSON, nothing for empty cells, and the
+// error message for cells that could not be read.
+enum class eSnapshotCell : uint8_t {
+    VALUE = 0,
+    EMPTY = 1,
+    FAILURE = 2,
+};
+
+
+template <std::unsigned_integral T>
+static void AppendLittleEndian(std::vector<std::byte>& buffer, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        buffer.push_back(std::byte((value >> (8 * i)) & 0xFF));
+    }
+}
+
+
+static void AppendSnapshotCell(std::vector<std::byte>& buffer, eSnapshotCell status, std::string_view content) {
+    const auto bytes = std::as_bytes(std::span(content));
+    buffer.push_back(std::byte(status));
+    AppendLittleEndian(buffer, uint32_t(bytes.size()));
+    buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+}
+
+
+static asyncpp::task<std::vector<std::byte>> GetTableSnapshot(std::shared_ptr<SimpleSession> session, UID table) {
+    const auto& modules = session->GetModules();
+    const auto maybeTableDesc = modules.FindTable(table);
+    if (!maybeTableDesc) {
+        throw std::invalid_argument(std::format("could not find table description: {}", table.ToString()));
+    }
+    const auto& columns = maybeTableDesc->columns;
+    const auto securityProvider = session->GetSecurityProvider();
+    const auto nameConverter = [&](UID uid) { return modules.FindName(uid, securityProvider); };
+
+    std::vector<UID> rows;
+    auto rowStream = session->GetTableRows(table);
+    while (const auto row = co_await rowStream) {
+        rows.push_back(*row);
+    }
+
+    std::vector<std::byte> buffer;
+    AppendLittleEndian(buffer, uint32_t(rows.size()));
+    AppendLittleEndian(buffer, uint32_t(columns.size()));
+    for (const auto row : rows) {
+        std::vector<Value> values(columns.size());
+        std::vector<std::exception_ptr> failures(columns.size());
+        bool wholeRowFailed = false;
+        try {
+            values = co_await session->GetObjectValues(row);
+        }
+        catch (...) {
+            wholeRowFailed = true;
+        }
+        // Access control may deny the whole row even when some cells are readable.
+        if (wholeRowFailed) {
+            for (uint32_t column = 0; column < columns.size(); ++column) {
+                try {
+                    values[column] = co_await session->GetValue(row, column);
+                }
+                catch (...) {
+                    failures[column] = std::current_exception();
+                }
+            }
+        }
+
+        AppendLittleEndian(buffer, row.value);
+        for (size_t column = 0; column < columns.size(); ++column) {
+            if (failures[column]) {
+                AppendSnapshotCell(buffer, eSnapshotCell::FAILURE, DescribeException(failures[column]));
+            }
+            else if (!values[column].HasValue()) {
+                AppendSnapshotCell(buffer, eSnapshotCell::EMPTY, {});
+            }
+            else {
+                try {
+                    const auto rendered = ValueToJSON(values[column], columns[column].type, nameConverter).dump(2);
+                    AppendSnapshotCell(buffer, eSnapshotCell::VALUE, rendered);
+                }
+                catch (...) {
+                    AppendSnapshotCell(buffer, eSnapshotCell::FAILURE, DescribeException(std::current_exception()));
+                }
+            }
+        }
+    }
+    co_return buffer;
+}
+
+
+static asyncpp::task<void> SetValues(std::shared_ptr<SimpleSession> session,
+                                     std::vector<std::tuple<UID, uint32_t, Value>> updates) {
+    auto transaction = co_await session->StartTransaction();
+    for (auto& [object, column, value] : updates) {
+        transaction.Set(object, column, std::move(value));
+    }
+    co_await transaction.Commit();
+}
+
 
 extern "C"
 {
@@ -522,7 +923,7 @@ extern "C"
 
 
     SEDMANAGER_EXPORT CFutureVoid* CSession_End(CSession* self) {
-        return new CFutureVoid{ self->object->End() };
+        return new CFutureVoid{ self->object->End(), self->strand };
     }
 
 
@@ -533,25 +934,23 @@ extern "C"
 
     SEDMANAGER_EXPORT CFutureVoid* CSession_Authenticate(CSession* self, CUID authority, std::byte* password, size_t passwordLength) {
         const auto _password = password ? std::optional(std::vector(password, password + passwordLength)) : std::nullopt;
-        return new CFutureVoid{ self->object->Authenticate(UID(authority), std::move(_password)) };
+        return new CFutureVoid{ self->object->Authenticate(UID(authority), std::move(_password)), self->strand };
     }
 
 
     SEDMANAGER_EXPORT CStreamUID* CSession_GetTableRows(CSession* self, CUID table) {
-        return new CStreamUID{ self->object->GetTableRows(UID(table)) };
+        return new CStreamUID{ std::make_shared<asyncpp::stream<UID>>(self->object->GetTableRows(UID(table))), self->strand };
     }
 
 
     SEDMANAGER_EXPORT size_t CSession_GetColumnCount(CSession* self, CUID table) {
-        const auto& modules = self->object->GetModules();
-        const auto maybeDesc = modules.FindTable(UID(table));
+        const auto maybeDesc = WithStrand(self->strand, [&] { return self->object->GetModules().FindTable(UID(table)); });
         return maybeDesc ? maybeDesc->columns.size() : 0;
     }
 
 
     SEDMANAGER_EXPORT CString* CSession_GetColumnName(CSession* self, CUID table, uint32_t column) {
-        const auto& modules = self->object->GetModules();
-        const auto maybeDesc = modules.FindTable(UID(table));
+        const auto maybeDesc = WithStrand(self->strand, [&] { return self->object->GetModules().FindTable(UID(table)); });
         if (maybeDesc && column < maybeDesc->columns.size()) {
             return new CString(maybeDesc->columns[column].name);
         }
@@ -560,8 +959,7 @@ extern "C"
 
 
     SEDMANAGER_EXPORT CType* CSession_GetColumnType(CSession* self, CUID table, uint32_t column) {
-        const auto& modules = self->object->GetModules();
-        const auto maybeDesc = modules.FindTable(UID(table));
+        const auto maybeDesc = WithStrand(self->strand, [&] { return self->object->GetModules().FindTable(UID(table)); });
         if (maybeDesc && column < maybeDesc->columns.size()) {
             return new CType(maybeDesc->columns[column].type);
         }
@@ -570,32 +968,52 @@ extern "C"
 
 
     SEDMANAGER_EXPORT CFutureValue* CSession_GetValue(CSession* self, CUID object, uint32_t column) {
-        return new CFutureValue{ self->object->GetValue(UID(object), column) };
+        return new CFutureValue{ self->object->GetValue(UID(object), column), self->strand };
     }
 
 
     SEDMANAGER_EXPORT CFutureVoid* CSession_SetValue(CSession* self, CUID object, uint32_t column, CValue* value) {
-        return new CFutureVoid{ self->object->SetValue(UID(object), column, value->object) };
+        return new CFutureVoid{ self->object->SetValue(UID(object), column, value->object), self->strand };
+    }
+
+
+    SEDMANAGER_EXPORT CFutureBytes* CSession_GetTableSnapshot(CSession* self, CUID table) {
+        return new CFutureBytes{ GetTableSnapshot(self->object, UID(table)), self->strand };
+    }
+
+
+    // All updates are applied in a single transaction.
+    SEDMANAGER_EXPORT CFutureVoid* CSession_SetValues(CSession* self,
+                                                      const CUID* objects,
+                                                      const uint32_t* columns,
+                                                      const CValue* const* values,
+                                                      size_t count) {
+        std::vector<std::tuple<UID, uint32_t, Value>> updates;
+        updates.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            updates.emplace_back(UID(objects[i]), columns[i], values[i]->object);
+        }
+        return new CFutureVoid{ SetValues(self->object, std::move(updates)), self->strand };
     }
 
 
     SEDMANAGER_EXPORT CFutureVoid* CSession_GenMEK(CSession* self, CUID lockingRange) {
-        return new CFutureVoid{ self->object->GenMEK(UID(lockingRange)) };
+        return new CFutureVoid{ self->object->GenMEK(UID(lockingRange)), self->strand };
     }
 
 
     SEDMANAGER_EXPORT CFutureVoid* CSession_GenPIN(CSession* self, CUID credentialObject, uint32_t length) {
-        return new CFutureVoid{ self->object->GenPIN(UID(credentialObject), length) };
+        return new CFutureVoid{ self->object->GenPIN(UID(credentialObject), length), self->strand };
     }
 
 
     SEDMANAGER_EXPORT CFutureVoid* CSession_Revert(CSession* self, CUID securityProvider) {
-        return new CFutureVoid{ self->object->Revert(UID(securityProvider)) };
+        return new CFutureVoid{ self->object->Revert(UID(securityProvider)), self->strand };
     }
 
 
     SEDMANAGER_EXPORT CFutureVoid* CSession_Activate(CSession* self, CUID securityProvider) {
-        return new CFutureVoid{ self->object->Activate(UID(securityProvider)) };
+        return new CFutureVoid{ self->object->Activate(UID(securityProvider)), self->strand };
     }
 }
 
@@ -610,31 +1028,86 @@ void CFuture_Destroy(CFuture<Ty>* self) {
 }
 
 
-template <class Ty, class Wrapper>
-void CFuture_Start(CFuture<Ty>* self, void (*callback)(bool, Wrapper)) {
-    launch([](auto task, auto callback) -> asyncpp::task<void> {
-        try {
-            if constexpr (std::is_void_v<Ty>) {
-                co_await task;
-                callback(true, nullptr);
-            }
-            else {
-                auto result = co_await task;
-                using WrapperBase = std::remove_pointer_t<Wrapper>;
-                if constexpr (std::is_pointer_v<Wrapper> && !std::is_pointer_v<Ty>) {
-                    callback(true, new WrapperBase(std::move(result)));
+template <class Wrapper, class Ty>
+Wrapper MakeWrapper(Ty&& result, const Strand& strand) {
+    using WrapperBase = std::remove_pointer_t<Wrapper>;
+    if constexpr (std::is_pointer_v<Wrapper> && std::is_constructible_v<WrapperBase, Ty, Strand>) {
+        return new WrapperBase(std::forward<Ty>(result), strand);
+    }
+    else if constexpr (std::is_pointer_v<Wrapper> && !std::is_pointer_v<std::decay_t<Ty>>) {
+        return new WrapperBase(std::forward<Ty>(result));
+    }
+    else {
+        return WrapperBase(std::forward<Ty>(result));
+    }
+}
+
+
+template <class Ty, class Wrapper, class Callback>
+void CFuture_Run(CFuture<Ty>* self, Callback callback) {
+    launch([](Strand strand, std::shared_ptr<std::exception_ptr> exception, auto task, Callback callback) -> asyncpp::task<void> {
+        using Result = std::conditional_t<std::is_void_v<Ty>, std::monostate, Ty>;
+        std::optional<Result> result;
+        {
+            asyncpp::unique_lock lk = co_await *strand;
+            try {
+                if constexpr (std::is_void_v<Ty>) {
+                    co_await task;
+                    result.emplace();
                 }
                 else {
-                    callback(true, WrapperBase(std::move(result)));
+                    result.emplace(co_await task);
                 }
             }
+            catch (...) {
+                SetLastException();
+                *exception = std::current_exception();
+            }
         }
-        catch (...) {
-            SetLastException();
+        if (!result) {
             callback(false, Wrapper{});
         }
-    }(std::move(self->object), callback),
-           threadPool);
+        else if constexpr (std::is_void_v<Ty>) {
+            callback(true, nullptr);
+        }
+        else {
+            callback(true, MakeWrapper<Wrapper>(std::move(*result), strand));
+        }
+    }(self->strand, self->exception, std::move(self->object), std::move(callback)),
+           GetThreadPool());
+}
+
+
+template <class Ty, class Wrapper>
+void CFuture_Start(CFuture<Ty>* self, void (*callback)(bool, Wrapper)) {
+    CFuture_Run<Ty, Wrapper>(self, callback);
+}
+
+
+// The operation shares the queue, so both the future and the queue may be
+// destroyed by the host before it completes.
+template <class Ty, class Wrapper>
+void CFuture_Submit(CFuture<Ty>* self, CCompletionQueue* queue, uint64_t tag) {
+    CFuture_Run<Ty, Wrapper>(self, [queue = queue->object, tag](bool success, Wrapper result) {
+        CCompletion completion{ .tag = tag, .success = success, .object = nullptr, .uid = 0 };
+        if constexpr (std::is_same_v<Wrapper, void*>) {
+            queue->Push(completion);
+        }
+        else if constexpr (std::is_pointer_v<Wrapper>) {
+            completion.object = result;
+            queue->Push(completion, [](void* object) { delete static_cast<Wrapper>(object); });
+        }
+        else {
+            completion.uid = result;
+            queue->Push(completion);
+        }
+    });
+}
+
+
+template <class Ty>
+CString* CFuture_GetException_Message(CFuture<Ty>* self) {
+    return GetExceptionMessage(*self->exception);
 }
 
 
@@ -646,28 +1119,80 @@ void CStream_Destroy(CStream<Ty>* self) {
 
 template <class Ty, class Wrapper>
 void CStream_Advance(CStream<Ty>* self, void (*callback)(bool, bool, Wrapper)) {
-    launch([](auto& stream, auto callback) -> asyncpp::task<void> {
-        try {
-            auto result = co_await stream;
-            if (result) {
-                using WrapperBase = std::remove_pointer_t<Wrapper>;
-                if constexpr (std::is_pointer_v<Wrapper> && !std::is_pointer_v<Ty>) {
-                    callback(true, true, new WrapperBase(std::move(*result)));
-                }
-                else {
-                    callback(true, true, WrapperBase(std::move(*result)));
+    launch([](std::shared_ptr<asyncpp::stream<Ty>> stream, Strand strand, std::shared_ptr<std::exception_ptr> exception, auto callback) -> asyncpp::task<void> {
+        std::optional<Ty> item;
+        bool failed = false;
+        {
+            asyncpp::unique_lock lk = co_await *strand;
+            try {
+                auto result = co_await *stream;
+                if (result) {
+                    item.emplace(std::move(*result));
                 }
             }
-            else {
-                callback(false, false, Wrapper{});
+            catch (...) {
+                SetLastException();
+                *exception = std::current_exception();
+                failed = true;
             }
         }
-        catch (...) {
-            SetLastException();
+        if (failed) {
             callback(true, false, Wrapper{});
         }
-    }(self->object, callback),
-           threadPool);
+        else if (item) {
+            callback(true, true, MakeWrapper<Wrapper>(std::move(*item), strand));
+        }
+        else {
+            callback(false, false, Wrapper{});
+        }
+    }(self->object, self->strand, self->exception, callback),
+           GetThreadPool());
+}
+
+
+// Delivers up to maxCount elements in one callback. Elements read before a
+// failure are still delivered, the failure is reported by the next call.
+template <class Ty, class Batch>
+void CStream_AdvanceN(CStream<Ty>* self, size_t maxCount, void (*callback)(bool, bool, Batch*)) {
+    launch([](std::shared_ptr<asyncpp::stream<Ty>> stream, Strand strand, std::shared_ptr<std::exception_ptr> exception, size_t maxCount, auto callback) -> asyncpp::task<void> {
+        auto batch = std::make_unique<Batch>();
+        bool failed = false;
+        {
+            asyncpp::unique_lock lk = co_await *strand;
+            // Set by a previous call, which may have been running until now.
+            failed = *exception != nullptr;
+            try {
+                while (!failed && batch->object.size() < maxCount) {
+                    auto result = co_await *stream;
+                    if (!result) {
+                        break;
+                    }
+                    batch->object.emplace_back(*result);
+                }
+            }
+            catch (...) {
+                SetLastException();
+                *exception = std::current_exception();
+                failed = batch->object.empty();
+            }
+        }
+        if (failed) {
+            callback(true, false, nullptr);
+        }
+        else if (!batch->object.empty()) {
+            callback(true, true, batch.release());
+        }
+        else {
+            callback(false, false, nullptr);
+        }
+    }(self->object, self->strand, self->exception, maxCount, callback),
+           GetThreadPool());
+}
+
+
+template <class Ty>
+CString* CStream_GetException_Message(CStream<Ty>* self) {
+    return GetExceptionMessage(*self->exception);
 }
 
 
@@ -683,6 +1208,16 @@ extern "C"
     }
 
 
+    SEDMANAGER_EXPORT CString* CFutureVoid_GetException_Message(CFutureVoid* self) {
+        return CFuture_GetException_Message(self);
+    }
+
+
+    SEDMANAGER_EXPORT void CFutureVoid_Submit(CFutureVoid* self, CCompletionQueue* queue, uint64_t tag) {
+        CFuture_Submit<void, void*>(self, queue, tag);
+    }
+
+
     SEDMANAGER_EXPORT void CFutureString_Destroy(CFutureString* self) {
         CFuture_Destroy(self);
     }
@@ -693,6 +1228,16 @@ extern "C"
     }
 
 
+    SEDMANAGER_EXPORT CString* CFutureString_GetException_Message(CFutureString* self) {
+        return CFuture_GetException_Message(self);
+    }
+
+
+    SEDMANAGER_EXPORT void CFutureString_Submit(CFutureString* self, CCompletionQueue* queue, uint64_t tag) {
+        CFuture_Submit<std::string, CString*>(self, queue, tag);
+    }
+
+
     SEDMANAGER_EXPORT void CFutureValue_Destroy(CFutureValue* self) {
         CFuture_Destroy(self);
     }
@@ -703,6 +1248,16 @@ extern "C"
     }
 
 
+    SEDMANAGER_EXPORT CString* CFutureValue_GetException_Message(CFutureValue* self) {
+        return CFuture_GetException_Message(self);
+    }
+
+
+    SEDMANAGER_EXPORT void CFutureValue_Submit(CFutureValue* self, CCompletionQueue* queue, uint64_t tag) {
+        CFuture_Submit<Value, CValue*>(self, queue, tag);
+    }
+
+
     SEDMANAGER_EXPORT void CFutureUID_Destroy(CFutureUID* self) {
         CFuture_Destroy(self);
     }
@@ -713,6 +1268,36 @@ extern "C"
     }
 
 
+    SEDMANAGER_EXPORT CString* CFutureUID_GetException_Message(CFutureUID* self) {
+        return CFuture_GetException_Message(self);
+    }
+
+
+    SEDMANAGER_EXPORT void CFutureUID_Submit(CFutureUID* self, CCompletionQueue* queue, uint64_t tag) {
+        CFuture_Submit<UID, CUID>(self, queue, tag);
+    }
+
+
+    SEDMANAGER_EXPORT void CFutureBytes_Destroy(CFutureBytes* self) {
+        CFuture_Destroy(self);
+    }
+
+
+    SEDMANAGER_EXPORT void CFutureBytes_Start(CFutureBytes* self, void (*callback)(bool, CBytes*)) {
+        CFuture_Start(self, callback);
+    }
+
+
+    SEDMANAGER_EXPORT CString* CFutureBytes_GetException_Message(CFutureBytes* self) {
+        return CFuture_GetException_Message(self);
+    }
+
+
+    SEDMANAGER_EXPORT void CFutureBytes_Submit(CFutureBytes* self, CCompletionQueue* queue, uint64_t tag) {
+        CFuture_Submit<std::vector<std::byte>, CBytes*>(self, queue, tag);
+    }
+
+
     SEDMANAGER_EXPORT void CFutureEncryptedDevice_Destroy(CFutureEncryptedDevice* self) {
         CFuture_Destroy(self);
     }
@@ -723,6 +1308,16 @@ extern "C"
     }
 
 
+    SEDMANAGER_EXPORT CString* CFutureEncryptedDevice_GetException_Message(CFutureEncryptedDevice* self) {
+        return CFuture_GetException_Message(self);
+    }
+
+
+    SEDMANAGER_EXPORT void CFutureEncryptedDevice_Submit(CFutureEncryptedDevice* self, CCompletionQueue* queue, uint64_t tag) {
+        CFuture_Submit<EncryptedDevice, CEncryptedDevice*>(self, queue, tag);
+    }
+
+
     SEDMANAGER_EXPORT void CFutureSession_Destroy(CFutureSession* self) {
         CFuture_Destroy(self);
     }
@@ -733,6 +1328,16 @@ extern "C"
     }
 
 
+    SEDMANAGER_EXPORT CString* CFutureSession_GetException_Message(CFutureSession* self) {
+        return CFuture_GetException_Message(self);
+    }
+
+
+    SEDMANAGER_EXPORT void CFutureSession_Submit(CFutureSession* self, CCompletionQueue* queue, uint64_t tag) {
+        CFuture_Submit<SimpleSession, CSession*>(self, queue, tag);
+    }
+
+
     SEDMANAGER_EXPORT void CStreamUID_Destroy(CStreamUID* self) {
         CStream_Destroy(self);
     }
@@ -743,6 +1348,16 @@ extern "C"
     }
 
 
+    SEDMANAGER_EXPORT void CStreamUID_AdvanceN(CStreamUID* self, size_t maxCount, void (*callback)(bool, bool, CUIDBatch*)) {
+        CStream_AdvanceN(self, maxCount, callback);
+    }
+
+
+    SEDMANAGER_EXPORT CString* CStreamUID_GetException_Message(CStreamUID* self) {
+        return CStream_GetException_Message(self);
+    }
+
+
     SEDMANAGER_EXPORT void CStreamString_Destroy(CStreamString* self) {
         CStream_Destroy(self);
     }
@@ -751,4 +1366,60 @@ extern "C"
     SEDMANAGER_EXPORT void CStreamString_Advance(CStreamString* self, void (*callback)(bool, bool, CString*)) {
         CStream_Advance(self, callback);
     }
+
+
+    SEDMANAGER_EXPORT CString* CStreamString_GetException_Message(CStreamString* self) {
+        return CStream_GetException_Message(self);
+    }
+
+
+    SEDMANAGER_EXPORT void CUIDBatch_Destroy(CUIDBatch* self) {
+        delete self;
+    }
+
+
+    SEDMANAGER_EXPORT const CUID* CUIDBatch_GetData(CUIDBatch* self) {
+        return self->object.data();
+    }
+
+
+    SEDMANAGER_EXPORT size_t CUIDBatch_GetLength(CUIDBatch* self) {
+        return self->object.size();
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Completion queue
+//------------------------------------------------------------------------------
+
+extern "C"
+{
+    SEDMANAGER_EXPORT CCompletionQueue* CCompletionQueue_Create() {
+        try {
+            return new CCompletionQueue{ std::make_shared<CompletionQueue>() };
+        }
+        catch (...) {
+            SetLastException();
+            return nullptr;
+        }
+    }
+
+
+    // Futures that are still pending keep the queue alive. Results that were
+    // never drained are freed with it.
+    SEDMANAGER_EXPORT void CCompletionQueue_Destroy(CCompletionQueue* self) {
+        delete self;
+    }
+
+
+    // Returns -1 on platforms without eventfd, where the host has to poll.
+    SEDMANAGER_EXPORT int CCompletionQueue_GetFd(CCompletionQueue* self) {
+        return self->object->GetFd();
+    }
+
+
+    SEDMANAGER_EXPORT size_t CCompletionQueue_Drain(CCompletionQueue* self, CCompletion* completions, size_t capacity) {
+        return self->object->Drain(std::span(completions, capacity));
+    }
 }
\ No newline at end of file
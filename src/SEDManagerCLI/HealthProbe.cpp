@@ -0,0 +1,138 @@
+#include "HealthProbe.hpp"
+
+#include "Utility.hpp"
+
+#include <StorageDevice/StorageDevice.hpp>
+#include <TrustedPeripheral/Probe.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <format>
+#include <iostream>
+#include <sstream>
+
+
+using namespace sedmgr;
+
+
+namespace {
+
+struct ProbedDevice {
+    std::string path;
+    ProbeResult result;
+};
+
+
+std::vector<std::string> GetSSCNames(const TPerDesc& desc) {
+    std::vector<std::string> names;
+    for (const auto& sscDesc : desc.sscDescs) {
+        names.emplace_back(std::visit([](auto& d) { return d.featureName; }, sscDesc));
+    }
+    return names;
+}
+
+
+std::string FormatJSON(const std::vector<ProbedDevice>& devices) {
+    nlohmann::json items = nlohmann::json::array();
+    for (const auto& [path, result] : devices) {
+        nlohmann::json item = {
+            { "path",       path                                                                      },
+            { "durationUs", std::chrono::duration_cast<std::chrono::microseconds>(result.duration).count() },
+        };
+        if (result.error) {
+            item["error"] = *result.error;
+        }
+        if (result.desc) {
+            item["ssc"] = GetSSCNames(*result.desc);
+            if (const auto& locking = result.desc->lockingDesc) {
+                item["locking"] = {
+                    { "locked",         locking->locked         },
+                    { "lockingEnabled", locking->lockingEnabled },
+                    { "mbrDone",        locking->mbrDone        },
+                };
+            }
+        }
+        items.push_back(std::move(item));
+    }
+    return items.dump();
+}
+
+
+std::string EscapeLabel(std::string_view value) {
+    std::string escaped;
+    for (const auto c : value) {
+        switch (c) {
+            case '\\': escaped += "\\\\"; break;
+            case '"': escaped += "\\\""; break;
+            case '\n': escaped += "\\n"; break;
+            default: escaped += c;
+        }
+    }
+    return escaped;
+}
+
+
+std::string FormatPrometheus(const std::vector<ProbedDevice>& devices) {
+    std::stringstream ss;
+    const auto metric = [&](std::string_view name, std::string_view help, auto&& value) {
+        ss << std::format("# HELP {} {}\n# TYPE {} gauge\n", name, help, name);
+        for (const auto& [path, result] : devices) {
+            if (const auto sample = value(result)) {
+                ss << std::format("{}{{device=\"{}\"}} {}\n", name, EscapeLabel(path), *sample);
+            }
+        }
+    };
+    const auto lockingFlag = [](bool LockingFeatureDesc::*flag) {
+        return [flag](const ProbeResult& result) -> std::optional<int> {
+            if (!result.desc || !result.desc->lockingDesc) {
+                return std::nullopt;
+            }
+            return int((*result.desc->lockingDesc).*flag);
+        };
+    };
+
+    metric("sedmanager_probe_up", "Whether Level 0 discovery succeeded.", [](const ProbeResult& result) -> std::optional<int> {
+        return int(bool(result.desc));
+    });
+    metric("sedmanager_probe_duration_seconds", "Time taken by Level 0 discovery.", [](const ProbeResult& result) -> std::optional<double> {
+        return std::chrono::duration<double>(result.duration).count();
+    });
+    metric("sedmanager_locking_enabled", "Whether locking is enabled.", lockingFlag(&LockingFeatureDesc::lockingEnabled));
+    metric("sedmanager_locked", "Whether any locking range is locked.", lockingFlag(&LockingFeatureDesc::locked));
+    metric("sedmanager_mbr_done", "Whether the shadow MBR is done.", lockingFlag(&LockingFeatureDesc::mbrDone));
+
+    ss << "# HELP sedmanager_ssc_info The security subsystem classes the device supports.\n"
+       << "# TYPE sedmanager_ssc_info gauge\n";
+    for (const auto& [path, result] : devices) {
+        if (result.desc) {
+            for (const auto& name : GetSSCNames(*result.desc)) {
+                ss << std::format("sedmanager_ssc_info{{device=\"{}\",ssc=\"{}\"}} 1\n", EscapeLabel(path), EscapeLabel(name));
+            }
+        }
+    }
+    return ss.str();
+}
+
+} // namespace
+
+
+HealthProbe::HealthProbe(eFormat format) : m_format(format) {}
+
+
+int HealthProbe::Run() {
+    std::vector<StorageDeviceLabel> deviceLabels;
+    for (auto& deviceLabel : EnumerateStorageDevices()) {
+        if (deviceLabel.interface == eStorageDeviceInterface::NVME) {
+            deviceLabels.push_back(std::move(deviceLabel));
+        }
+    }
+
+    const auto results = ProbeDevices(deviceLabels);
+    std::vector<ProbedDevice> devices;
+    for (size_t i = 0; i < results.size(); ++i) {
+        devices.push_back({ deviceLabels[i].path, results[i] });
+    }
+
+    std::cout << (m_format == eFormat::JSON ? FormatJSON(devices) + "\n" : FormatPrometheus(devices)) << std::flush;
+    return 0;
+}
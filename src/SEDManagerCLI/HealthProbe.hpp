@@ -0,0 +1,17 @@
+#pragma once
+
+
+class HealthProbe {
+public:
+    enum class eFormat {
+        JSON,
+        PROMETHEUS,
+    };
+
+    explicit HealthProbe(eFormat format);
+
+    int Run();
+
+private:
+    eFormat m_format;
+};
@@ -3,9 +3,16 @@
 #include "Utility.hpp"
 
 #include <CLI/App.hpp>
+#include <EncryptedDevice/LockingRanges.hpp>
 #include <EncryptedDevice/ValueToJSON.hpp>
+#include <Specification/Core/Defs/TableRows.hpp>
 #include <asyncpp/join.hpp>
 
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <fstream>
 #include <iostream>
 #include <ostream>
 #include <utility>
@@ -43,10 +50,13 @@ Interactive::Interactive(EncryptedDevice& manager) : m_manager(manager) {
     RegisterCallbackSet();
     RegisterCallbackPasswd();
     RegisterCallbackGenMEK();
+    RegisterCallbackPlanRanges();
     RegisterCallbackGenPIN();
     RegisterCallbackActivate();
     RegisterCallbackRevert();
 
+    RegisterCallbackStats();
+
     RegisterCallbackStackReset();
     RegisterCallbackReset();
 }
@@ -84,6 +94,229 @@ int Interactive::Run() {
 }
 
 
+int Interactive::RunScript(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::invalid_argument(std::format("cannot open script: {}", path.string()));
+    }
+    const auto commands = ParseScript(file);
+    std::vector<ScriptResult> results(commands.size());
+
+    // Reads between two other commands don't depend on each other, so they are
+    // sent together. Everything else runs on its own, in the order of the script.
+    bool failed = false;
+    size_t first = 0;
+    while (first < commands.size() && !m_finished) {
+        size_t last = first;
+        while (last < commands.size() && IsScriptRead(commands[last])) {
+            ++last;
+        }
+        if (last != first) {
+            RunScriptReads(std::span(commands).subspan(first, last - first), std::span(results).subspan(first, last - first));
+            for (size_t index = first; index < last; ++index) {
+                std::cout << rang::fg::cyan << "> " << commands[index].line << rang::style::reset << std::endl;
+                std::cout << results[index].output;
+                PrintScriptResult(results[index]);
+            }
+        }
+        else {
+            std::cout << rang::fg::cyan << "> " << commands[first].line << rang::style::reset << std::endl;
+            results[first] = RunScriptCommand(commands[first]);
+            PrintScriptResult(results[first]);
+            last = first + 1;
+        }
+        for (size_t index = first; index < last; ++index) {
+            failed = failed || results[index].error;
+        }
+        first = last;
+    }
+    return failed ? -1 : 0;
+}
+
+
+auto Interactive::ParseScript(std::istream& script) const -> std::vector<ScriptCommand> {
+    std::vector<ScriptCommand> commands;
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(script, line); ++lineNumber) {
+        const auto tokens = CLI::detail::split_up(line);
+        if (tokens.empty() || tokens.front().starts_with('#')) {
+            continue;
+        }
+        try {
+            (void)m_cli.get_subcommand(tokens.front());
+        }
+        catch (CLI::OptionNotFound&) {
+            throw std::invalid_argument(std::format("line {}: unknown command '{}'", lineNumber, tokens.front()));
+        }
+        commands.push_back({ .lineNumber = lineNumber, .line = line, .tokens = tokens });
+    }
+    return commands;
+}
+
+
+bool Interactive::IsScriptRead(const ScriptCommand& command) {
+    const auto& tokens = command.tokens;
+    if (std::ranges::any_of(tokens, [](const auto& token) { return token.starts_with('-'); })) {
+        return false;
+    }
+    if (tokens[0] == "rows" || tokens[0] == "columns") {
+        return tokens.size() == 2;
+    }
+    if (tokens[0] == "get") {
+        return tokens.size() == 2 || (tokens.size() == 3 && ParseColumnNumber(tokens[2]));
+    }
+    return false;
+}
+
+
+std::optional<int32_t> Interactive::ParseColumnNumber(std::string_view token) {
+    int32_t column = 0;
+    const auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), column);
+    if (ec != std::errc{} || ptr != token.data() + token.size()) {
+        return std::nullopt;
+    }
+    return column;
+}
+
+
+void Interactive::RunScriptReads(std::span<const ScriptCommand> commands, std::span<ScriptResult> results) {
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingGet {
+        size_t index;
+        UID row;
+        int32_t column;
+        TableDesc tableDesc;
+    };
+
+    // Names are resolved and the table descriptions looked up on the host first,
+    // then all gets go out in as few packets as the TPer allows.
+    std::vector<PendingGet> gets;
+    std::vector<CellRange> ranges;
+    std::vector<std::pair<size_t, UID>> rowListings;
+    for (size_t index = 0; index < commands.size(); ++index) {
+        const auto& tokens = commands[index].tokens;
+        const auto startTime = Clock::now();
+        try {
+            const auto sp = m_session.value().GetSecurityProvider();
+            if (tokens[0] == "get") {
+                const auto column = tokens.size() > 2 ? *ParseColumnNumber(tokens[2]) : -1;
+                const auto parsed = Unwrap(ParseGetSet(tokens[1], column), "cannot find object");
+                const auto tableUid = std::get<0>(parsed);
+                const auto rowUid = std::get<1>(parsed);
+                auto tableDesc = Unwrap(m_manager.GetModules().FindTable(tableUid), "could not find table description");
+                if (!(column < std::ssize(tableDesc.columns))) {
+                    throw std::invalid_argument("column index is out of bounds.");
+                }
+                ranges.push_back(column < 0 ? CellRange{ rowUid, 0, uint32_t(tableDesc.columns.size()) }
+                                            : CellRange{ rowUid, uint32_t(column), uint32_t(column) + 1 });
+                gets.push_back({ index, rowUid, column, std::move(tableDesc) });
+            }
+            else if (tokens[0] == "rows") {
+                rowListings.emplace_back(index, Unwrap(ParseObjectRef(m_session.value().GetModules(), tokens[1], sp), "cannot find table"));
+            }
+            else {
+                results[index].output = FormatColumns(Unwrap(ParseObjectRef(m_session.value().GetModules(), tokens[1], sp), "cannot find table"));
+            }
+        }
+        catch (std::exception& ex) {
+            results[index].error = ex.what();
+        }
+        results[index].elapsed = Clock::now() - startTime;
+    }
+
+    if (!ranges.empty()) {
+        const auto startTime = Clock::now();
+        std::vector<MethodExpected<std::vector<Value>>> values;
+        std::optional<std::string> batchError;
+        try {
+            values = join(m_session.value().TryGetObjectValues(ranges));
+        }
+        catch (std::exception& ex) {
+            batchError = ex.what();
+        }
+        const auto elapsed = Clock::now() - startTime;
+
+        for (size_t getIndex = 0; getIndex < gets.size(); ++getIndex) {
+            const auto& get = gets[getIndex];
+            auto& result = results[get.index];
+            result.elapsed += elapsed;
+            result.batchSize = gets.size();
+            if (batchError) {
+                result.error = batchError;
+                continue;
+            }
+            const auto& value = values[getIndex];
+            try {
+                if (get.column < 0) {
+                    if (value) {
+                        result.output = FormatObject(get.tableDesc, [&](size_t column) { return (*value)[column]; }) + "\n";
+                    }
+                    else {
+                        // Access control may deny the whole row even when some cells are readable.
+                        const auto fallbackTime = Clock::now();
+                        const auto columnValues = m_session.value().GetObjectColumns(get.row);
+                        result.output = FormatObject(get.tableDesc, [&](size_t) { return *join(columnValues); }) + "\n";
+                        result.elapsed += Clock::now() - fallbackTime;
+                    }
+                }
+                else {
+                    if (!value) {
+                        value.error().Throw("Get");
+                    }
+                    result.output = FormatCell(value->front(), get.tableDesc.columns[get.column].type) + "\n";
+                }
+            }
+            catch (std::exception& ex) {
+                result.error = ex.what();
+            }
+        }
+    }
+
+    // Listing rows takes several Next calls that depend on each other.
+    for (const auto& [index, table] : rowListings) {
+        const auto startTime = Clock::now();
+        try {
+            results[index].output = FormatRows(table);
+        }
+        catch (std::exception& ex) {
+            results[index].error = ex.what();
+        }
+        results[index].elapsed += Clock::now() - startTime;
+    }
+}
+
+
+auto Interactive::RunScriptCommand(const ScriptCommand& command) -> ScriptResult {
+    ScriptResult result;
+    const auto startTime = std::chrono::steady_clock::now();
+    try {
+        m_cli.parse(command.line, false);
+    }
+    catch (CLI::CallForHelp&) {
+        PrintHelp(command.line);
+    }
+    catch (std::exception& ex) {
+        result.error = ex.what();
+    }
+    result.elapsed = std::chrono::steady_clock::now() - startTime;
+    return result;
+}
+
+
+void Interactive::PrintScriptResult(const ScriptResult& result) const {
+    if (result.error) {
+        std::cout << rang::fg::red << "Error: " << rang::style::reset << *result.error << std::endl;
+    }
+    const auto milliseconds = std::chrono::duration<double, std::milli>(result.elapsed).count();
+    std::cout << rang::style::dim << std::format("({:.2f} ms", milliseconds);
+    if (result.batchSize > 1) {
+        std::cout << std::format(", 1 of {} gets batched", result.batchSize);
+    }
+    std::cout << ")" << rang::style::reset << std::endl;
+}
+
+
 void Interactive::ClearCurrents() {
     m_session = {};
     m_currentAuthorities.clear();
@@ -152,6 +385,62 @@ void Interactive::PrintHelp(const std::string& command) const {
 }
 
 
+std::string Interactive::FormatRows(UID table) {
+    auto rowStream = m_session.value().GetTableRows(table);
+
+    const std::vector<std::string> columnNames = { "UID", "Name" };
+    std::vector<std::vector<std::string>> rows;
+    while (const auto row = join(rowStream)) {
+        rows.push_back({ row->ToString(), m_manager.GetModules().FindName(*row, m_session.value().GetSecurityProvider()).value_or("") });
+    }
+    return FormatTable(columnNames, rows);
+}
+
+
+std::string Interactive::FormatColumns(UID table) const {
+    const auto tableDesc = Unwrap(m_manager.GetModules().FindTable(table), "cannot find table description");
+
+    size_t columnNumber = 0;
+    const std::vector<std::string> columnNames = { "Number", "Name", "IsUnique", "Type" };
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& column : tableDesc.columns) {
+        rows.push_back({ std::to_string(columnNumber++), column.name, column.isUnique ? "yes" : "", GetTypeStr(column.type) });
+    }
+    return FormatTable(columnNames, rows);
+}
+
+
+std::string Interactive::FormatObject(const TableDesc& tableDesc, const std::function<Value(size_t)>& getColumn) const {
+    const auto nameConverter = [this](UID uid) { return m_manager.GetModules().FindName(uid, m_session.value().GetSecurityProvider()); };
+    const std::vector<std::string> outColumns = { "Column", "Value" };
+    std::vector<std::vector<std::string>> outData;
+    size_t idx = 0;
+    for (const auto& columnDesc : tableDesc.columns) {
+        const auto label = std::format("{}: {}", idx, columnDesc.name);
+        try {
+            const auto value = getColumn(idx);
+            auto valueStr = value.HasValue() ? ValueToJSON(value, columnDesc.type, nameConverter).dump() : "<empty>";
+            if (valueStr.size() > 55) {
+                valueStr.resize(51);
+                valueStr += " ...";
+            }
+            outData.push_back({ label, valueStr });
+        }
+        catch (std::exception& ex) {
+            outData.push_back({ label, std::string("error: ") + ex.what() });
+        }
+        ++idx;
+    }
+    return FormatTable(outColumns, outData);
+}
+
+
+std::string Interactive::FormatCell(const Value& value, const Type& type) const {
+    const auto nameConverter = [this](UID uid) { return m_manager.GetModules().FindName(uid, m_session.value().GetSecurityProvider()); };
+    return value.HasValue() ? ValueToJSON(value, type, nameConverter).dump(4) : "<empty>";
+}
+
+
 void Interactive::RegisterCallbackExit() {
     auto cmdExit = m_cli.add_subcommand("exit", "Exit the application.");
     cmdExit->callback([&] {
@@ -175,7 +464,7 @@ void Interactive::RegisterCallbackStart() {
     cmd->add_option("sp", spName, "The name or UID (in hex) of the security provider.")->required();
     cmd->callback([this] {
         const auto spUid = Unwrap(ParseObjectRef(m_manager.GetModules(), "SP::" + spName), "cannot find security provider");
-        m_session = join(m_manager.Login(spUid));
+        m_session.emplace(join(m_manager.Login(spUid)));
     });
 }
 
@@ -248,6 +537,16 @@ void Interactive::RegisterCallbackInfo() {
                 std::cout << "\nLocking description:" << std::endl;
                 std::cout << FormatTable(columns, rows);
             }
+            if (desc.geometryDesc) {
+                rows = {
+                    {"Alignment required",     desc.geometryDesc->alignmentRequired ? "yes" : "no"     },
+                    { "Logical block size",    std::to_string(desc.geometryDesc->logicalBlockSize)    },
+                    { "Alignment granularity", std::to_string(desc.geometryDesc->alignmentGranularity)},
+                    { "Lowest aligned LBA",    std::to_string(desc.geometryDesc->lowestAlignedLba)    },
+                };
+                std::cout << "\nGeometry description:" << std::endl;
+                std::cout << FormatTable(columns, rows);
+            }
             for (const auto& sscDesc : desc.sscDescs) {
                 const auto visitor = [&](auto& d) {
                     rows = {
@@ -300,14 +599,7 @@ void Interactive::RegisterCallbackRows() {
     cmdRows->add_option("table", tableName, "The table to list the rows of.")->required();
     cmdRows->callback([this] {
         const auto tableUid = Unwrap(ParseObjectRef(m_session.value().GetModules(), tableName, m_session.value().GetSecurityProvider()), "cannot find table");
-        auto rowStream = m_session.value().GetTableRows(tableUid);
-
-        const std::vector<std::string> columnNames = { "UID", "Name" };
-        std::vector<std::vector<std::string>> rows;
-        while (const auto row = join(rowStream)) {
-            rows.push_back({ row->ToString(), m_manager.GetModules().FindName(*row, m_session.value().GetSecurityProvider()).value_or("") });
-        }
-        std::cout << FormatTable(columnNames, rows);
+        std::cout << FormatRows(tableUid);
     });
 }
 
@@ -319,15 +611,7 @@ void Interactive::RegisterCallbackColumns() {
     cmdColumns->add_option("table", tableName, "The table to list the columns of.")->required();
     cmdColumns->callback([this] {
         const auto tableUid = Unwrap(ParseObjectRef(m_session.value().GetModules(), tableName, m_session.value().GetSecurityProvider()), "cannot find table");
-        const auto tableDesc = Unwrap(m_manager.GetModules().FindTable(tableUid), "cannot find table description");
-
-        size_t columnNumber = 0;
-        const std::vector<std::string> columnNames = { "Number", "Name", "IsUnique", "Type" };
-        std::vector<std::vector<std::string>> rows;
-        for (const auto& column : tableDesc.columns) {
-            rows.push_back({ std::to_string(columnNumber++), column.name, column.isUnique ? "yes" : "", GetTypeStr(column.type) });
-        }
-        std::cout << FormatTable(columnNames, rows);
+        std::cout << FormatColumns(tableUid);
     });
 }
 
@@ -347,38 +631,17 @@ void Interactive::RegisterCallbackGet() {
             return;
         }
         const auto& [tableUid, rowUid, column] = *parsed;
-        const auto nameConverter = [this](UID uid) { return m_manager.GetModules().FindName(uid, m_session.value().GetSecurityProvider()); };
         const auto tableDesc = Unwrap(m_manager.GetModules().FindTable(tableUid), "could not find table description");
         if (column < 0) {
             const auto columnValues = m_session.value().GetObjectColumns(rowUid);
-            const std::vector<std::string> outColumns = { "Column", "Value" };
-            std::vector<std::vector<std::string>> outData;
-            size_t idx = 0;
-            for (const auto& columnDesc : tableDesc.columns) {
-                const auto label = std::format("{}: {}", idx, columnDesc.name);
-                try {
-                    const auto value = *join(columnValues);
-                    auto valueStr = value.HasValue() ? ValueToJSON(value, columnDesc.type, nameConverter).dump() : "<empty>";
-                    if (valueStr.size() > 55) {
-                        valueStr.resize(51);
-                        valueStr += " ...";
-                    }
-                    outData.push_back({ label, valueStr });
-                }
-                catch (std::exception& ex) {
-                    outData.push_back({ label, std::string("error: ") + ex.what() });
-                }
-                ++idx;
-            }
-            std::cout << FormatTable(outColumns, outData) << std::endl;
+            std::cout << FormatObject(tableDesc, [&](size_t) { return *join(columnValues); }) << std::endl;
         }
         else {
             if (!(column < std::ssize(tableDesc.columns))) {
                 throw std::invalid_argument("column index is out of bounds.");
             }
             const auto value = join(m_session.value().GetValue(rowUid, column));
-            const auto columnType = tableDesc.columns[column].type;
-            std::cout << (value.HasValue() ? ValueToJSON(value, columnType, nameConverter).dump(4) : "<empty>") << std::endl;
+            std::cout << FormatCell(value, tableDesc.columns[column].type) << std::endl;
         }
     });
 }
@@ -425,7 +688,8 @@ void Interactive::RegisterCallbackPasswd() {
         const auto authTable = Unwrap(ParseObjectRef(m_manager.GetModules(), "Authority", m_session.value().GetSecurityProvider()), "cannot find Authority table");
         const auto cPinTable = Unwrap(ParseObjectRef(m_manager.GetModules(), "C_PIN", m_session.value().GetSecurityProvider()), "cannot find C_PIN table");
         const auto authUid = Unwrap(ParseObjectRef(m_manager.GetModules(), "Authority::" + authName, m_session.value().GetSecurityProvider()), "cannot find authority");
-        const auto credentialUid = value_cast<UID>(join(m_session.value().GetValue(authUid, 10)));
+        const auto authority = join(m_session.value().GetRow<core::AuthorityRow>(authUid, &core::AuthorityRow::credential));
+        const auto credentialUid = Unwrap(authority.credential, "authority has no credential");
         const std::vector<std::byte> password = GetPassword("New password: ");
         const std::vector<std::byte> passwordAgain = GetPassword("Retype password: ");
         if (password != passwordAgain) {
@@ -447,6 +711,30 @@ void Interactive::RegisterCallbackGenMEK() {
 }
 
 
+void Interactive::RegisterCallbackPlanRanges() {
+    static uint64_t numLbas;
+    static size_t count;
+    auto cmd = m_cli.add_subcommand("plan-ranges", "Lays out locking ranges over the namespace, aligned to the drive's geometry.");
+    cmd->add_option("lbas", numLbas, "The number of logical blocks in the namespace.")->required();
+    cmd->add_option("count", count, "The number of locking ranges.")->required();
+    const auto apply = cmd->add_flag("--apply", "Write the ranges to Locking::Range1 onwards.");
+    cmd->callback([&] {
+        const auto extents = PlanLockingRanges(m_manager.GetDesc().geometryDesc, numLbas, count);
+        const std::vector<std::string> columns = { "Range", "RangeStart", "RangeLength" };
+        std::vector<std::vector<std::string>> rows;
+        for (size_t index = 0; index < extents.size(); ++index) {
+            rows.push_back({ std::format("Locking::Range{}", index + 1),
+                             std::to_string(extents[index].rangeStart),
+                             std::to_string(extents[index].rangeLength) });
+        }
+        std::cout << FormatTable(columns, rows);
+        if (*apply) {
+            join(ApplyLockingRanges(m_session.value(), extents));
+        }
+    });
+}
+
+
 void Interactive::RegisterCallbackGenPIN() {
     static std::string credentialObj;
     static uint32_t length = 32;
@@ -482,6 +770,61 @@ void Interactive::RegisterCallbackRevert() {
 }
 
 
+void Interactive::RegisterCallbackStats() {
+    auto cmd = m_cli.add_subcommand("stats", "Print communication statistics and method latencies.");
+    cmd->callback([this] {
+        const auto snapshot = m_manager.GetMetrics().Snapshot();
+        const auto formatLatency = [](uint64_t ns) { return std::format("{:.1f}", double(ns) / 1000.0); };
+
+        std::vector<std::string> columns = { "Counter", "Value" };
+        std::vector<std::vector<std::string>> rows = {
+            {"IF-SEND calls",        std::to_string(snapshot.ifSendCount)                  },
+            { "IF-RECV calls",       std::to_string(snapshot.ifRecvCount)                  },
+            { "Bytes sent",          std::to_string(snapshot.bytesSent)                    },
+            { "Bytes received",      std::to_string(snapshot.bytesReceived)                },
+            { "Packet exchanges",    std::to_string(snapshot.exchangeCount)                },
+            { "Polls",               std::to_string(snapshot.pollCount)                    },
+            { "Max polls / exchange", std::to_string(snapshot.pollsPerExchange.max)        },
+            { "Exchange p50 (us)",   formatLatency(snapshot.exchangeLatency.p50)           },
+            { "Exchange p99 (us)",   formatLatency(snapshot.exchangeLatency.p99)           },
+            { "Device lock waits",   std::to_string(snapshot.lockWait.count)               },
+            { "Lock wait max (us)",  formatLatency(snapshot.lockWait.max)                  },
+            { "Retries",             std::to_string(snapshot.retryCount)                   },
+            { "Session restarts",    std::to_string(snapshot.sessionRestartCount)          },
+            { "Recovery resets",     std::to_string(snapshot.recoveryResetCount)           },
+            { "Retries exhausted",   std::to_string(snapshot.retryExhaustedCount)          },
+        };
+        std::cout << FormatTable(columns, rows) << std::endl;
+
+        columns = { "Method", "Count", "Min (us)", "p50 (us)", "p90 (us)", "p99 (us)", "Max (us)" };
+        rows.clear();
+        for (const auto& [methodId, latency] : snapshot.methodLatency) {
+            rows.push_back({
+                m_manager.GetModules().FindName(methodId).value_or(methodId.ToString()),
+                std::to_string(latency.count),
+                formatLatency(latency.min),
+                formatLatency(latency.p50),
+                formatLatency(latency.p90),
+                formatLatency(latency.p99),
+                formatLatency(latency.max),
+            });
+        }
+        if (const auto& latency = snapshot.endSessionLatency; latency.count != 0) {
+            rows.push_back({
+                "END_OF_SESSION",
+                std::to_string(latency.count),
+                formatLatency(latency.min),
+                formatLatency(latency.p50),
+                formatLatency(latency.p90),
+                formatLatency(latency.p99),
+                formatLatency(latency.max),
+            });
+        }
+        std::cout << FormatTable(columns, rows) << std::endl;
+    });
+}
+
+
 void Interactive::RegisterCallbackStackReset() {
     auto cmd = m_cli.add_subcommand("stack-reset", "Reset the current communication stream.");
     cmd->callback([this] {
@@ -3,8 +3,15 @@
 #include <CLI/CLI.hpp>
 #include <EncryptedDevice/EncryptedDevice.hpp>
 
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <istream>
 #include <optional>
+#include <span>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
 
 class Interactive {
@@ -18,8 +25,23 @@ public:
     std::optional<sedmgr::UID> GetCurrentSecurityProvider() const;
     std::unordered_set<sedmgr::UID> GetCurrentAuthorities() const;
     int Run();
+    // Runs the commands of the file, echoing each before its output and timing.
+    int RunScript(const std::filesystem::path& path);
 
 private:
+    struct ScriptCommand {
+        size_t lineNumber;
+        std::string line;
+        std::vector<std::string> tokens;
+    };
+
+    struct ScriptResult {
+        std::string output;
+        std::optional<std::string> error;
+        std::chrono::nanoseconds elapsed = {};
+        size_t batchSize = 1;
+    };
+
     void RegisterCallbackExit();
     void RegisterCallbackHelp();
 
@@ -35,13 +57,28 @@ private:
     void RegisterCallbackSet();
     void RegisterCallbackPasswd();
     void RegisterCallbackGenMEK();
+    void RegisterCallbackPlanRanges();
     void RegisterCallbackGenPIN();
     void RegisterCallbackActivate();
     void RegisterCallbackRevert();
 
+    void RegisterCallbackStats();
+
     void RegisterCallbackStackReset();
     void RegisterCallbackReset();
 
+    std::vector<ScriptCommand> ParseScript(std::istream& script) const;
+    static bool IsScriptRead(const ScriptCommand& command);
+    static std::optional<int32_t> ParseColumnNumber(std::string_view token);
+    void RunScriptReads(std::span<const ScriptCommand> commands, std::span<ScriptResult> results);
+    ScriptResult RunScriptCommand(const ScriptCommand& command);
+    void PrintScriptResult(const ScriptResult& result) const;
+
+    std::string FormatRows(sedmgr::UID table);
+    std::string FormatColumns(sedmgr::UID table) const;
+    std::string FormatObject(const sedmgr::TableDesc& tableDesc, const std::function<sedmgr::Value(size_t)>& getColumn) const;
+    std::string FormatCell(const sedmgr::Value& value, const sedmgr::Type& type) const;
+
     void ClearCurrents();
     auto ParseGetSet(std::string rowName, int32_t column) const -> std::optional<std::tuple<sedmgr::UID, sedmgr::UID, int32_t>>;
     void PrintCaret() const;
@@ -3,18 +3,36 @@
 #include "Utility.hpp"
 
 #include <Messaging/Native.hpp>
+#include <Specification/Core/Defs/TableRows.hpp>
+#include <StorageDevice/DeviceWatcher.hpp>
 #include <StorageDevice/StorageDevice.hpp>
 
 #include <EncryptedDevice/EncryptedDevice.hpp>
 #include <asyncpp/join.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <thread>
+
 
 using namespace sedmgr;
 
 
 namespace {
 
-void UnlockDevice(std::shared_ptr<StorageDevice> device);
+using Clock = std::chrono::steady_clock;
+
+void UnlockDevice(std::shared_ptr<StorageDevice> device,
+                  std::string_view name = {},
+                  std::optional<Clock::time_point> attachedAt = std::nullopt);
+std::shared_ptr<StorageDevice> OpenAttachedDevice(const StorageDeviceLabel& deviceLabel);
+
+std::atomic_bool stopRequested = false;
+
+extern "C" void RequestStop(int) {
+    stopRequested = true;
+}
 
 } // namespace
 
@@ -23,15 +41,16 @@ PBA::PBA() {}
 
 
 int PBA::Run() {
-    const auto deviceLabels = EnumerateStorageDevices();
+    // The names come from sysfs, so the drives need not be identified.
+    const auto devices = EnumerateStorageDeviceInfo();
 
-    for (auto& deviceLabel : deviceLabels) {
+    for (auto& deviceInfo : devices) {
         std::shared_ptr<StorageDevice> device;
-        if (deviceLabel.interface == eStorageDeviceInterface::NVME) {
-            device = std::make_shared<NvmeDevice>(deviceLabel.path);
+        if (deviceInfo.label.interface == eStorageDeviceInterface::NVME) {
+            device = std::make_shared<NvmeDevice>(deviceInfo.label.path);
         }
         if (device) {
-            UnlockDevice(device);
+            UnlockDevice(device, deviceInfo.desc.name);
         }
     }
 
@@ -39,12 +58,41 @@ int PBA::Run() {
 }
 
 
+int PBA::Watch(const std::filesystem::path& directory) {
+    // The watcher is created first so that no drive attached meanwhile is missed.
+    DeviceWatcher watcher(directory);
+    Run();
+
+    // Interrupting ends the watch once the drive at hand is done.
+    stopRequested = false;
+    const auto previousInterrupt = std::signal(SIGINT, RequestStop);
+    const auto previousTerminate = std::signal(SIGTERM, RequestStop);
+
+    std::cout << std::format("Waiting for drives in '{}'... Press Ctrl+C to stop.", directory.string()) << std::endl;
+    while (!stopRequested) {
+        const auto deviceLabels = watcher.Wait(std::chrono::seconds(1));
+        // Drives that appeared together were attached at the same time, no
+        // matter how long the prompts for the ones before take.
+        const auto attachedAt = Clock::now();
+        for (const auto& deviceLabel : deviceLabels) {
+            if (const auto device = OpenAttachedDevice(deviceLabel)) {
+                UnlockDevice(device, {}, attachedAt);
+            }
+        }
+    }
+
+    std::signal(SIGINT, previousInterrupt);
+    std::signal(SIGTERM, previousTerminate);
+    return 0;
+}
+
+
 namespace {
 
 
 std::optional<EncryptedDevice> ConnectDevice(std::shared_ptr<StorageDevice> device) {
     try {
-        return EncryptedDevice(device);
+        return EncryptedDevice(device, DeviceLock::DefaultDirectory());
     }
     catch (std::exception&) {
         return std::nullopt;
@@ -73,14 +121,12 @@ std::string GetDeviceName(std::shared_ptr<StorageDevice> device) {
 SimpleSession StartLockingSession(EncryptedDevice& manager) {
     const auto lockingSpUid = Unwrap(manager.GetModules().FindUid("SP::Locking"), "could not find Locking SP");
 
-    try {
-        return join(manager.Login(lockingSpUid));
-    }
-    catch (SecurityProviderBusyError& ex) {
-        // Do a stack reset and retry, maybe a previous session was not terminated properly.
-        join(manager.StackReset());
-        return join(manager.Login(lockingSpUid));
-    }
+    // If it's busy, reset the stack right away, maybe a previous session was not terminated properly.
+    // The session itself doesn't retry, a wrong password must not reset the stack.
+    manager.SetRetryPolicy(RetryPolicy{ .maxAttempts = 2, .retriesBeforeStackReset = 0, .allowStackReset = true, .contentionOnly = true });
+    auto session = join(manager.Login(lockingSpUid));
+    session.SetRetryPolicy(RetryPolicy::None());
+    return session;
 }
 
 
@@ -108,15 +154,14 @@ std::optional<UID> FindAuthority(SimpleSession& manager, std::string_view name)
     const auto authorityTableUid = Unwrap(manager.GetModules().FindUid("Authority"), "could not find Authority table");
     const auto authorityUids = manager.GetTableRows(authorityTableUid);
     while (const auto authority = join(authorityUids)) {
-        try {
-            const auto commonName = UnwrapCommonName(join(manager.GetValue(*authority, 2)));
-            if (commonName && *commonName == name) {
-                return *authority;
-            }
-        }
-        catch (std::exception&) {
+        const auto value = join(manager.TryGetValue(*authority, ColumnOf<&core::AuthorityRow::commonName>));
+        if (!value) {
             continue;
         }
+        const auto commonName = UnwrapCommonName(*value);
+        if (commonName && *commonName == name) {
+            return *authority;
+        }
     }
     return std::nullopt;
 }
@@ -166,43 +211,69 @@ bool TryLoginUser(SimpleSession& session, UID authority) {
 }
 
 
-void TryUnlockRanges(SimpleSession& manager) {
+std::pair<bool, bool> TryUnlock(SimpleSession& manager, UID lockingRange) {
+    constexpr auto readLockedColumn = ColumnOf<&core::LockingRow::readLocked>;
+    constexpr auto writeLockedColumn = ColumnOf<&core::LockingRow::writeLocked>;
+
+    // With write-behind enabled, both columns go out in a single Set. Only if
+    // that fails are they set one by one, to tell which of them we may unlock.
+    join(manager.SetValue(lockingRange, readLockedColumn, false));
+    join(manager.SetValue(lockingRange, writeLockedColumn, false));
+    const auto failures = join(manager.TryFlush(true));
+
+    bool rdUnlocked = true;
+    bool wrUnlocked = true;
+    for (const auto& failure : failures) {
+        if (!failure.error.Is(eMethodStatus::NOT_AUTHORIZED)) {
+            failure.error.Throw("Set");
+        }
+        // Not being authorized for a range is expected.
+        (failure.column == readLockedColumn ? rdUnlocked : wrUnlocked) = false;
+    }
+    return { rdUnlocked, wrUnlocked };
+}
+
+
+// Turns on write-behind until it goes out of scope, also by an exception.
+class ScopedWriteBehind {
+public:
+    explicit ScopedWriteBehind(SimpleSession& session) : m_session(session) { m_session.SetWriteBehind(true); }
+    ScopedWriteBehind(const ScopedWriteBehind&) = delete;
+    ScopedWriteBehind& operator=(const ScopedWriteBehind&) = delete;
+    ~ScopedWriteBehind() { m_session.SetWriteBehind(false); }
+
+private:
+    SimpleSession& m_session;
+};
+
+
+bool TryUnlockRanges(SimpleSession& manager) {
     const auto lockingSp = Unwrap(manager.GetModules().FindUid("SP::Locking"), "could not find Locking SP");
     const auto lockingTableUid = Unwrap(manager.GetModules().FindUid("Locking"), "could not find Locking table");
     auto lockingRangeUids = manager.GetTableRows(lockingTableUid);
 
+    bool anyUnlocked = false;
+    const ScopedWriteBehind writeBehind(manager);
     while (const auto lockingRange = join(lockingRangeUids)) {
         const auto name = FormatObjectRef(manager.GetModules(), *lockingRange, lockingSp);
-        const auto commonName = UnwrapCommonName(join(manager.GetValue(*lockingRange, 2)));
+        const auto maybeCommonName = join(manager.TryGetValue(*lockingRange, ColumnOf<&core::LockingRow::commonName>));
+        const auto commonName = maybeCommonName ? UnwrapCommonName(*maybeCommonName) : std::nullopt;
 
-        bool rdUnlocked = false;
-        bool wrUnlocked = false;
-        try {
-            join(manager.SetValue(*lockingRange, 7, false));
-            rdUnlocked = true;
-        }
-        catch (NotAuthorizedError& ex) {
-            // Expected.
-        }
-        try {
-            join(manager.SetValue(*lockingRange, 8, false));
-            wrUnlocked = true;
-        }
-        catch (NotAuthorizedError& ex) {
-            // Expected.
-        }
+        const auto [rdUnlocked, wrUnlocked] = TryUnlock(manager, *lockingRange);
         if (rdUnlocked || wrUnlocked) {
+            anyUnlocked = true;
             std::cout << std::format("Unlocked ({}{}) {}!", rdUnlocked ? "R" : "", wrUnlocked ? "W" : "", FormatName(name, commonName))
                       << std::endl;
         }
     }
+    return anyUnlocked;
 }
 
 
 void TryDoMBR(SimpleSession& session) {
     const auto mbrControlTableUid = Unwrap(session.GetModules().FindUid("MBRControl"), "could not find MBRControl table");
     try {
-        join(session.SetValue(mbrControlTableUid, 2, 1));
+        join(session.SetValue(mbrControlTableUid, ColumnOf<&core::MBRControlRow::done>, 1));
         std::cout << "MBR Done!" << std::endl;
     }
     catch (std::exception&) {
@@ -212,7 +283,40 @@ void TryDoMBR(SimpleSession& session) {
 }
 
 
-void UnlockDevice(std::shared_ptr<StorageDevice> device) {
+std::string FormatDuration(Clock::duration duration) {
+    return std::format("{} ms", std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+}
+
+
+std::string FormatElapsed(Clock::time_point since) {
+    return FormatDuration(Clock::now() - since);
+}
+
+
+std::shared_ptr<StorageDevice> OpenAttachedDevice(const StorageDeviceLabel& deviceLabel) {
+    constexpr auto maxTries = 50;
+    constexpr auto retryDelay = std::chrono::milliseconds(10);
+
+    if (deviceLabel.interface != eStorageDeviceInterface::NVME) {
+        return nullptr;
+    }
+    // udev may still be setting up the node when it appears.
+    for (auto i = 0; i < maxTries; ++i) {
+        try {
+            return std::make_shared<NvmeDevice>(deviceLabel.path);
+        }
+        catch (std::exception&) {
+            std::this_thread::sleep_for(retryDelay);
+        }
+    }
+    std::cout << std::format("Could not open '{}'.", deviceLabel.path) << std::endl;
+    return nullptr;
+}
+
+
+void UnlockDevice(std::shared_ptr<StorageDevice> device,
+                  std::string_view name,
+                  std::optional<Clock::time_point> attachedAt) {
     std::optional<EncryptedDevice> maybeEncryptedDevice = ConnectDevice(device);
     if (!maybeEncryptedDevice) {
         // Device does not support TCG specifications.
@@ -227,10 +331,14 @@ void UnlockDevice(std::shared_ptr<StorageDevice> device) {
         return;
     }
 
-    std::cout << std::format("Unlock '{}':", GetDeviceName(device)) << std::endl;
+    std::cout << std::format("Unlock '{}':", name.empty() ? GetDeviceName(device) : std::string(name)) << std::endl;
 
     try {
         auto session = StartLockingSession(encryptedDevice);
+        if (attachedAt) {
+            std::cout << std::format("Ready {} after attaching.", FormatElapsed(*attachedAt)) << std::endl;
+        }
+        const auto promptStart = Clock::now();
         const auto user = TryGetUser(session);
         if (!user) {
             return;
@@ -239,8 +347,15 @@ void UnlockDevice(std::shared_ptr<StorageDevice> device) {
         if (!success) {
             return;
         }
-        TryUnlockRanges(session);
+        const auto promptTime = Clock::now() - promptStart;
+        const auto unlocked = TryUnlockRanges(session);
         TryDoMBR(session);
+        if (unlocked && attachedAt) {
+            std::cout << std::format("Unlocked {} after attaching, {} of which at the login prompts.",
+                                     FormatElapsed(*attachedAt),
+                                     FormatDuration(promptTime))
+                      << std::endl;
+        }
     }
     catch (std::exception& ex) {
         std::cout << "Error: " << ex.what() << std::endl;
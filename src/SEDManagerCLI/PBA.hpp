@@ -1,5 +1,6 @@
 #pragma once
 
+#include <filesystem>
 
 class PBA {
 public:
@@ -10,6 +11,9 @@ public:
     PBA& operator=(PBA&&) = delete;
 
     int Run();
+    // Unlocks the drives present, then keeps unlocking drives as their nodes
+    // appear in the directory, until SIGINT or SIGTERM.
+    int Watch(const std::filesystem::path& directory);
 
 private:
     bool m_finished = false;
@@ -1,3 +1,4 @@
+#include "HealthProbe.hpp"
 #include "Interactive.hpp"
 #include "PBA.hpp"
 
@@ -17,16 +18,29 @@ public:
     MainApp() {
         m_guided = m_cli.add_option("-g,--guided", m_guidedName, "Guided sessions walk you through the configuration process step by step.");
         m_interactive = m_cli.add_flag("-i,--interactive", "Interactive sessions allow you to manually inspect and configure tables.");
+        m_script = m_cli.add_option("--script", m_scriptPath, "Run the interactive commands in the file, batching the reads between other commands.");
         m_pba = m_cli.add_flag("--pba", "Perform pre-boot authentication by finding locked devices and asking for passwords to unlock.");
+        m_probe = m_cli.add_option("--probe", m_probeFormat, "Print the locking state of all drives as 'json' or 'prometheus' metrics, using only Level 0 discovery.");
+        m_watch = m_cli.add_option("--watch", m_watchDirectory, "With --pba, keep running and unlock drives as their device nodes appear in the directory.");
 
         m_guided->excludes(m_interactive);
         m_guided->excludes(m_pba);
         m_interactive->excludes(m_pba);
+        m_script->excludes(m_guided);
+        m_script->excludes(m_pba);
+        m_script->excludes(m_probe);
+        m_probe->excludes(m_guided);
+        m_probe->excludes(m_interactive);
+        m_probe->excludes(m_pba);
+        m_probe->check(CLI::IsMember({ "json", "prometheus" }));
+        m_watch->expected(0, 1);
+        m_watch->needs(m_pba);
 
         m_device = m_cli.add_option("device", m_devicePath, "The path to the device you want to configure.");
         m_guided->default_val(std::string{});
         m_guided->needs(m_device);
         m_interactive->needs(m_device);
+        m_script->needs(m_device);
     }
     MainApp(const MainApp&) = delete;
     MainApp(MainApp&) = delete;
@@ -41,19 +55,26 @@ public:
                 std::cout << "No guided sessions available yet." << std::endl;
                 return 0;
             }
+            else if (*m_probe) {
+                HealthProbe probe(m_probeFormat == "json" ? HealthProbe::eFormat::JSON : HealthProbe::eFormat::PROMETHEUS);
+                return probe.Run();
+            }
             else if (*m_pba) {
                 PBA session;
+                if (*m_watch) {
+                    return session.Watch(m_watchDirectory.empty() ? "/dev" : m_watchDirectory);
+                }
                 return session.Run();
             }
-            else if (*m_interactive) {
+            else if (*m_interactive || *m_script) {
                 const auto device = std::make_shared<NvmeDevice>(m_devicePath);
                 const auto identity = device->IdentifyController();
                 std::cout << rang::fg::yellow << "Drive: "
                           << rang::fg::reset << identity.modelNumber
                           << rang::style::reset << std::endl;
-                EncryptedDevice manager(device);
+                EncryptedDevice manager(device, DeviceLock::DefaultDirectory());
                 Interactive session(manager);
-                return session.Run();
+                return *m_script ? session.RunScript(m_scriptPath) : session.Run();
             }
             else {
                 throw CLI::CallForHelp();
@@ -72,10 +93,16 @@ private:
     CLI::App m_cli;
     std::string m_guidedName;
     std::string m_devicePath;
+    std::string m_watchDirectory;
+    std::string m_probeFormat;
+    std::string m_scriptPath;
     CLI::Option* m_guided;
     CLI::Option* m_interactive;
     CLI::Option* m_device;
     CLI::Option* m_pba;
+    CLI::Option* m_watch;
+    CLI::Option* m_probe;
+    CLI::Option* m_script;
 };
 
 
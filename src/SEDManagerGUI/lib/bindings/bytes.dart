@@ -0,0 +1,25 @@
+import "dart:ffi";
+import "dart:typed_data";
+import "package:sed_manager_gui/bindings/errors.dart";
+import "sedmanager_capi.dart";
+
+class BytesWrapper implements Finalizable {
+  BytesWrapper(this._handle) {
+    if (_handle == nullptr) {
+      throw SEDException(getLastErrorMessage());
+    }
+    _finalizer.attach(this, _handle.cast(), detach: this);
+  }
+
+  static final _capi = SEDManagerCAPI();
+  static final _finalizer = NativeFinalizer(_capi.bytesDestroyAddress.cast());
+  final Pointer<CBytes> _handle;
+
+  Uint8List toUint8List() {
+    final length = _capi.bytesGetLength(_handle);
+    if (length == 0) {
+      return Uint8List(0);
+    }
+    return Uint8List.fromList(_capi.bytesGetData(_handle).asTypedList(length));
+  }
+}
@@ -6,6 +6,7 @@ import 'package:ffi/ffi.dart';
 import 'future.dart';
 import 'storage_device.dart';
 import 'string.dart';
+import 'table_snapshot.dart';
 import 'value.dart';
 import 'type.dart';
 import 'sedmanager_capi.dart';
@@ -61,6 +62,33 @@ class Session implements Finalizable {
     return futureWrapper.toDartFuture();
   }
 
+  Future<TableSnapshot> getTableSnapshot(UID table) async {
+    final futurePtr = _capi.sessionGetTableSnapshot(_handle, table);
+    final futureWrapper = FutureWrapperBytes(futurePtr);
+    return TableSnapshot.decode(await futureWrapper.toDartFuture());
+  }
+
+  Future<void> setValues(List<(UID, int, Value)> updates) {
+    final count = updates.length;
+    final objects = malloc.allocate<Uint64>(sizeOf<Uint64>() * count);
+    final columns = malloc.allocate<Uint32>(sizeOf<Uint32>() * count);
+    final values = malloc.allocate<Pointer<CValue>>(sizeOf<Pointer<CValue>>() * count);
+    try {
+      for (int i = 0; i < count; ++i) {
+        objects[i] = updates[i].$1;
+        columns[i] = updates[i].$2;
+        values[i] = updates[i].$3.handle();
+      }
+      final futurePtr = _capi.sessionSetValues(_handle, objects, columns, values, count);
+      final futureWrapper = FutureWrapperVoid(futurePtr);
+      return futureWrapper.toDartFuture();
+    } finally {
+      malloc.free(objects);
+      malloc.free(columns);
+      malloc.free(values);
+    }
+  }
+
   Future<void> authenticate(UID authority, String? password) {
     final bytes = password?.toNativeUtf8();
     final futurePtr = _capi.sessionAuthenticate(
@@ -1,4 +1,6 @@
 import "dart:async";
+import "dart:typed_data";
+import "bytes.dart";
 import "encrypted_device.dart";
 import "string.dart";
 import "errors.dart";
@@ -14,18 +16,20 @@ class FutureWrapperVoid implements Finalizable {
   static final _capi = SEDManagerCAPI();
   static const _suffix = "Void";
   static final _destroyAddress = _capi.lookupFutureDestroy<Void>(_suffix);
+  static final _getExceptionFunc = _capi.lookupFutureGetExceptionMessage<Void>(_suffix);
   static final _startFunc = _capi.lookupFutureStart<Void, Pointer<Void>>(_suffix);
   static final _finalizer = NativeFinalizer(_destroyAddress.cast());
   Pointer<CFuture<Void>> _handle;
 
   Future<void> toDartFuture() {
     assert(_handle != nullptr);
+    final handle = _handle;
     final completer = Completer<void>();
 
     late final NativeCallable<Void Function(Bool, Pointer<Void>)> callable;
     void callback(bool success, Pointer<Void> result) {
       if (!success) {
-        completer.completeError(SEDException(getLastErrorMessage()));
+        completer.completeError(SEDException(_exceptionMessage(handle)));
       } else {
         completer.complete();
       }
@@ -38,6 +42,10 @@ class FutureWrapperVoid implements Finalizable {
     _handle = nullptr;
     return completer.future;
   }
+
+  String _exceptionMessage(Pointer<CFuture<Void>> handle) {
+    return StringWrapper(_getExceptionFunc(handle)).toDartString();
+  }
 }
 
 class FutureWrapperString implements Finalizable {
@@ -48,18 +56,20 @@ class FutureWrapperString implements Finalizable {
   static final _capi = SEDManagerCAPI();
   static const _suffix = "String";
   static final _destroyAddress = _capi.lookupFutureDestroy<CString>(_suffix);
+  static final _getExceptionFunc = _capi.lookupFutureGetExceptionMessage<CString>(_suffix);
   static final _startFunc = _capi.lookupFutureStart<CString, Pointer<CString>>(_suffix);
   static final _finalizer = NativeFinalizer(_destroyAddress.cast());
   Pointer<CFuture<CString>> _handle;
 
   Future<String> toDartFuture() {
     assert(_handle != nullptr);
+    final handle = _handle;
     final completer = Completer<String>();
 
     late final NativeCallable<Void Function(Bool, Pointer<CString>)> callable;
     void callback(bool success, Pointer<CString> result) {
       if (!success) {
-        completer.completeError(SEDException(getLastErrorMessage()));
+        completer.completeError(SEDException(_exceptionMessage(handle)));
       } else {
         completer.complete(StringWrapper(result).toDartString());
       }
@@ -72,6 +82,10 @@ class FutureWrapperString implements Finalizable {
     _handle = nullptr;
     return completer.future;
   }
+
+  String _exceptionMessage(Pointer<CFuture<CString>> handle) {
+    return StringWrapper(_getExceptionFunc(handle)).toDartString();
+  }
 }
 
 class FutureWrapperEncryptedDevice implements Finalizable {
@@ -82,18 +96,20 @@ class FutureWrapperEncryptedDevice implements Finalizable {
   static final _capi = SEDManagerCAPI();
   static const _suffix = "EncryptedDevice";
   static final _destroyAddress = _capi.lookupFutureDestroy<CEncryptedDevice>(_suffix);
+  static final _getExceptionFunc = _capi.lookupFutureGetExceptionMessage<CEncryptedDevice>(_suffix);
   static final _startFunc = _capi.lookupFutureStart<CEncryptedDevice, Pointer<CEncryptedDevice>>(_suffix);
   static final _finalizer = NativeFinalizer(_destroyAddress.cast());
   Pointer<CFuture<CEncryptedDevice>> _handle;
 
   Future<EncryptedDevice> toDartFuture() {
     assert(_handle != nullptr);
+    final handle = _handle;
     final completer = Completer<EncryptedDevice>();
 
     late final NativeCallable<Void Function(Bool, Pointer<CEncryptedDevice>)> callable;
     void callback(bool success, Pointer<CEncryptedDevice> result) {
       if (!success) {
-        completer.completeError(SEDException(getLastErrorMessage()));
+        completer.completeError(SEDException(_exceptionMessage(handle)));
       } else {
         completer.complete(EncryptedDevice(result));
       }
@@ -106,6 +122,10 @@ class FutureWrapperEncryptedDevice implements Finalizable {
     _handle = nullptr;
     return completer.future;
   }
+
+  String _exceptionMessage(Pointer<CFuture<CEncryptedDevice>> handle) {
+    return StringWrapper(_getExceptionFunc(handle)).toDartString();
+  }
 }
 
 class FutureWrapperSession implements Finalizable {
@@ -116,18 +136,20 @@ class FutureWrapperSession implements Finalizable {
   static final _capi = SEDManagerCAPI();
   static const _suffix = "Session";
   static final _destroyAddress = _capi.lookupFutureDestroy<CSession>(_suffix);
+  static final _getExceptionFunc = _capi.lookupFutureGetExceptionMessage<CSession>(_suffix);
   static final _startFunc = _capi.lookupFutureStart<CSession, Pointer<CSession>>(_suffix);
   static final _finalizer = NativeFinalizer(_destroyAddress.cast());
   Pointer<CFuture<CSession>> _handle;
 
   Future<Session> toDartFuture() {
     assert(_handle != nullptr);
+    final handle = _handle;
     final completer = Completer<Session>();
 
     late final NativeCallable<Void Function(Bool, Pointer<CSession>)> callable;
     void callback(bool success, Pointer<CSession> result) {
       if (!success) {
-        completer.completeError(SEDException(getLastErrorMessage()));
+        completer.completeError(SEDException(_exceptionMessage(handle)));
       } else {
         completer.complete(Session(result));
       }
@@ -140,6 +162,10 @@ class FutureWrapperSession implements Finalizable {
     _handle = nullptr;
     return completer.future;
   }
+
+  String _exceptionMessage(Pointer<CFuture<CSession>> handle) {
+    return StringWrapper(_getExceptionFunc(handle)).toDartString();
+  }
 }
 
 class FutureWrapperUID implements Finalizable {
@@ -150,18 +176,20 @@ class FutureWrapperUID implements Finalizable {
   static final _capi = SEDManagerCAPI();
   static const _suffix = "UID";
   static final _destroyAddress = _capi.lookupFutureDestroy<CUID>(_suffix);
+  static final _getExceptionFunc = _capi.lookupFutureGetExceptionMessage<CUID>(_suffix);
   static final _startFunc = _capi.lookupFutureStart<CUID, CUID>(_suffix);
   static final _finalizer = NativeFinalizer(_destroyAddress.cast());
   Pointer<CFuture<CUID>> _handle;
 
   Future<UID> toDartFuture() {
     assert(_handle != nullptr);
+    final handle = _handle;
     final completer = Completer<UID>();
 
     late final NativeCallable<Void Function(Bool, CUID)> callable;
     void callback(bool success, UID result) {
       if (!success) {
-        completer.completeError(SEDException(getLastErrorMessage()));
+        completer.completeError(SEDException(_exceptionMessage(handle)));
       } else {
         completer.complete(result);
       }
@@ -174,6 +202,10 @@ class FutureWrapperUID implements Finalizable {
     _handle = nullptr;
     return completer.future;
   }
+
+  String _exceptionMessage(Pointer<CFuture<CUID>> handle) {
+    return StringWrapper(_getExceptionFunc(handle)).toDartString();
+  }
 }
 
 class FutureWrapperValue implements Finalizable {
@@ -184,18 +216,20 @@ class FutureWrapperValue implements Finalizable {
   static final _capi = SEDManagerCAPI();
   static const _suffix = "Value";
   static final _destroyAddress = _capi.lookupFutureDestroy<CValue>(_suffix);
+  static final _getExceptionFunc = _capi.lookupFutureGetExceptionMessage<CValue>(_suffix);
   static final _startFunc = _capi.lookupFutureStart<CValue, Pointer<CValue>>(_suffix);
   static final _finalizer = NativeFinalizer(_destroyAddress.cast());
   Pointer<CFuture<CValue>> _handle;
 
   Future<Value> toDartFuture() {
     assert(_handle != nullptr);
+    final handle = _handle;
     final completer = Completer<Value>();
 
     late final NativeCallable<Void Function(Bool, Pointer<CValue>)> callable;
     void callback(bool success, Pointer<CValue> result) {
       if (!success) {
-        completer.completeError(SEDException(getLastErrorMessage()));
+        completer.completeError(SEDException(_exceptionMessage(handle)));
       } else {
         completer.complete(Value(result));
       }
@@ -208,6 +242,50 @@ class FutureWrapperValue implements Finalizable {
     _handle = nullptr;
     return completer.future;
   }
+
+  String _exceptionMessage(Pointer<CFuture<CValue>> handle) {
+    return StringWrapper(_getExceptionFunc(handle)).toDartString();
+  }
+}
+
+class FutureWrapperBytes implements Finalizable {
+  FutureWrapperBytes(this._handle) {
+    _finalizer.attach(this, _handle.cast(), detach: this);
+  }
+
+  static final _capi = SEDManagerCAPI();
+  static const _suffix = "Bytes";
+  static final _destroyAddress = _capi.lookupFutureDestroy<CBytes>(_suffix);
+  static final _getExceptionFunc = _capi.lookupFutureGetExceptionMessage<CBytes>(_suffix);
+  static final _startFunc = _capi.lookupFutureStart<CBytes, Pointer<CBytes>>(_suffix);
+  static final _finalizer = NativeFinalizer(_destroyAddress.cast());
+  Pointer<CFuture<CBytes>> _handle;
+
+  Future<Uint8List> toDartFuture() {
+    assert(_handle != nullptr);
+    final handle = _handle;
+    final completer = Completer<Uint8List>();
+
+    late final NativeCallable<Void Function(Bool, Pointer<CBytes>)> callable;
+    void callback(bool success, Pointer<CBytes> result) {
+      if (!success) {
+        completer.completeError(SEDException(_exceptionMessage(handle)));
+      } else {
+        completer.complete(BytesWrapper(result).toUint8List());
+      }
+      callable.close();
+    }
+
+    callable = NativeCallable<Void Function(Bool, Pointer<CBytes>)>.listener(callback);
+
+    _startFunc(_handle, callable.nativeFunction);
+    _handle = nullptr;
+    return completer.future;
+  }
+
+  String _exceptionMessage(Pointer<CFuture<CBytes>> handle) {
+    return StringWrapper(_getExceptionFunc(handle)).toDartString();
+  }
 }
 
 class StreamWrapperUID implements Finalizable {
@@ -217,47 +295,59 @@ class StreamWrapperUID implements Finalizable {
 
   static final _capi = SEDManagerCAPI();
   static const _suffix = "UID";
+  static const _batchSize = 64;
   static final _destroyAddress = _capi.lookupStreamDestroy<CUID>(_suffix);
-  static final _startFunc = _capi.lookupStreamAdvance<CUID, CUID>(_suffix);
+  static final _getExceptionFunc = _capi.lookupStreamGetExceptionMessage<CUID>(_suffix);
+  static final _advanceFunc = _capi.streamUIDAdvanceN;
   static final _finalizer = NativeFinalizer(_destroyAddress.cast());
   Pointer<CStream<CUID>> _handle;
 
   Stream<UID> toDartStream() {
     assert(_handle != nullptr);
 
+    final handle = _handle;
     return () async* {
-      UID? value;
       while (true) {
-        final completer = Completer<UID?>();
+        final completer = Completer<List<UID>?>();
 
-        late final NativeCallable<Void Function(Bool, Bool, CUID)> callable;
-        void callback(bool valid, bool success, UID result) {
+        late final NativeCallable<Void Function(Bool, Bool, Pointer<CUIDBatch>)> callable;
+        void callback(bool valid, bool success, Pointer<CUIDBatch> batch) {
           if (valid) {
             if (success) {
-              completer.complete(result);
+              completer.complete(_takeBatch(batch));
             } else {
-              final message = getLastErrorMessage();
-              completer.completeError(SEDException(message));
+              completer.completeError(SEDException(_exceptionMessage(handle)));
             }
           } else {
             completer.complete(null);
-            callable.close();
           }
+          callable.close();
         }
 
-        callable = NativeCallable<Void Function(Bool, Bool, CUID)>.listener(callback);
+        callable = NativeCallable<Void Function(Bool, Bool, Pointer<CUIDBatch>)>.listener(callback);
 
-        _startFunc(_handle, callable.nativeFunction);
-        value = await completer.future;
+        _advanceFunc(_handle, _batchSize, callable.nativeFunction);
+        final values = await completer.future;
 
-        if (value != null) {
-          yield value;
+        if (values != null) {
+          yield* Stream.fromIterable(values);
         } else {
           break;
         }
       }
     }();
   }
+
+  static List<UID> _takeBatch(Pointer<CUIDBatch> batch) {
+    final length = _capi.uidBatchGetLength(batch);
+    final values = List<UID>.of(_capi.uidBatchGetData(batch).asTypedList(length));
+    _capi.uidBatchDestroy(batch);
+    return values;
+  }
+
+  String _exceptionMessage(Pointer<CStream<CUID>> handle) {
+    return StringWrapper(_getExceptionFunc(handle)).toDartString();
+  }
 }
 
 class StreamWrapperString implements Finalizable {
@@ -268,6 +358,7 @@ class StreamWrapperString implements Finalizable {
   static final _capi = SEDManagerCAPI();
   static const _suffix = "String";
   static final _destroyAddress = _capi.lookupStreamDestroy<Pointer<CString>>(_suffix);
+  static final _getExceptionFunc = _capi.lookupStreamGetExceptionMessage<CString>(_suffix);
   static final _startFunc = _capi.lookupStreamAdvance<CString, Pointer<CString>>(_suffix);
   static final _finalizer = NativeFinalizer(_destroyAddress.cast());
   Pointer<CStream<CString>> _handle;
@@ -275,6 +366,7 @@ class StreamWrapperString implements Finalizable {
   Stream<String> toDartStream() {
     assert(_handle != nullptr);
 
+    final handle = _handle;
     return () async* {
       String? value;
       while (true) {
@@ -286,7 +378,7 @@ class StreamWrapperString implements Finalizable {
             if (success) {
               completer.complete(StringWrapper(result).toDartString());
             } else {
-              completer.completeError(SEDException(getLastErrorMessage()));
+              completer.completeError(SEDException(_exceptionMessage(handle)));
             }
           } else {
             completer.complete(null);
@@ -307,4 +399,8 @@ class StreamWrapperString implements Finalizable {
       }
     }();
   }
+
+  String _exceptionMessage(Pointer<CStream<CString>> handle) {
+    return StringWrapper(_getExceptionFunc(handle)).toDartString();
+  }
 }
@@ -12,6 +12,8 @@ typedef CUID = Uint64;
 
 final class CString extends Opaque {}
 
+final class CBytes extends Opaque {}
+
 final class CValue extends Opaque {}
 
 final class CType extends Opaque {}
@@ -26,6 +28,8 @@ final class CFuture<T> extends Opaque {}
 
 final class CStream<T> extends Opaque {}
 
+final class CUIDBatch extends Opaque {}
+
 typedef CFutureVoid = CFuture<Void>;
 
 typedef CFutureEncryptedDevice = CFuture<CEncryptedDevice>;
@@ -33,6 +37,7 @@ typedef CFutureSession = CFuture<CSession>;
 typedef CFutureValue = CFuture<CValue>;
 typedef CFutureString = CFuture<CString>;
 typedef CFutureUID = CFuture<CUID>;
+typedef CFutureBytes = CFuture<CBytes>;
 typedef CStreamUid = CStream<CUID>;
 typedef CStreamString = CStream<CString>;
 typedef CFutureCallback<T> = NativeFunction<Void Function(Bool, T)>;
@@ -61,6 +66,20 @@ class SEDManagerCAPI {
     isLeaf: true,
   );
 
+  //----------------------------------------------------------------------------
+  // Executor
+  //----------------------------------------------------------------------------
+
+  final setThreadPoolSize = dylib.lookupFunction<Bool Function(Size), bool Function(int)>(
+    "CSetThreadPoolSize",
+    isLeaf: true,
+  );
+
+  final getThreadPoolSize = dylib.lookupFunction<Size Function(), int Function()>(
+    "CGetThreadPoolSize",
+    isLeaf: true,
+  );
+
   //----------------------------------------------------------------------------
   // CString
   //----------------------------------------------------------------------------
@@ -85,6 +104,23 @@ class SEDManagerCAPI {
     isLeaf: true,
   );
 
+  //----------------------------------------------------------------------------
+  // CBytes
+  //----------------------------------------------------------------------------
+
+  final bytesDestroyAddress = dylib.lookup<NativeFunction<Void Function(Pointer<CBytes>)>>("CBytes_Destroy");
+
+  final bytesGetData =
+      dylib.lookupFunction<Pointer<Uint8> Function(Pointer<CBytes>), Pointer<Uint8> Function(Pointer<CBytes>)>(
+    "CBytes_GetData",
+    isLeaf: true,
+  );
+
+  final bytesGetLength = dylib.lookupFunction<Size Function(Pointer<CBytes>), int Function(Pointer<CBytes>)>(
+    "CBytes_GetLength",
+    isLeaf: true,
+  );
+
   //----------------------------------------------------------------------------
   // CValue
   //----------------------------------------------------------------------------
@@ -196,6 +232,18 @@ class SEDManagerCAPI {
     isLeaf: true,
   );
 
+  final valueSerialize = dylib.lookupFunction<Pointer<CBytes> Function(Pointer<CValue>),
+      Pointer<CBytes> Function(Pointer<CValue>)>(
+    "CValue_Serialize",
+    isLeaf: true,
+  );
+
+  final valueDeserialize = dylib.lookupFunction<Pointer<CValue> Function(Pointer<Uint8>, Size),
+      Pointer<CValue> Function(Pointer<Uint8>, int)>(
+    "CValue_Deserialize",
+    isLeaf: true,
+  );
+
   //----------------------------------------------------------------------------
   // CValue
   //----------------------------------------------------------------------------
@@ -315,6 +363,12 @@ class SEDManagerCAPI {
     isLeaf: true,
   );
 
+  final encryptedDeviceGetMetrics = dylib.lookupFunction<Pointer<CString> Function(Pointer<CEncryptedDevice>),
+      Pointer<CString> Function(Pointer<CEncryptedDevice>)>(
+    "CEncryptedDevice_GetMetrics",
+    isLeaf: true,
+  );
+
   //----------------------------------------------------------------------------
   // CSession
   //----------------------------------------------------------------------------
@@ -378,6 +432,19 @@ class SEDManagerCAPI {
     isLeaf: true,
   );
 
+  final sessionGetTableSnapshot = dylib.lookupFunction<Pointer<CFutureBytes> Function(Pointer<CSession>, CUID),
+      Pointer<CFutureBytes> Function(Pointer<CSession>, int)>(
+    "CSession_GetTableSnapshot",
+    isLeaf: true,
+  );
+
+  final sessionSetValues = dylib.lookupFunction<
+      Pointer<CFutureVoid> Function(Pointer<CSession>, Pointer<CUID>, Pointer<Uint32>, Pointer<Pointer<CValue>>, Size),
+      Pointer<CFutureVoid> Function(Pointer<CSession>, Pointer<CUID>, Pointer<Uint32>, Pointer<Pointer<CValue>>, int)>(
+    "CSession_SetValues",
+    isLeaf: true,
+  );
+
   final sessionGenMEK = dylib.lookupFunction<Pointer<CFutureVoid> Function(Pointer<CSession>, CUID),
       Pointer<CFutureVoid> Function(Pointer<CSession>, int)>(
     "CSession_GenMEK",
@@ -414,6 +481,13 @@ class SEDManagerCAPI {
     return function;
   }
 
+  Pointer<CString> Function(Pointer<CFuture<T>>) lookupFutureGetExceptionMessage<T extends NativeType>(String suffix) {
+    return dylib.lookupFunction<Pointer<CString> Function(Pointer<CFuture<T>>), Pointer<CString> Function(Pointer<CFuture<T>>)>(
+      "CFuture${suffix}_GetException_Message",
+      isLeaf: true,
+    );
+  }
+
   Pointer<NativeFunction<Void Function(Pointer<CStream<T>>)>> lookupStreamDestroy<T extends NativeType>(String suffix) {
     final address = dylib.lookup<NativeFunction<Void Function(Pointer<CStream<T>>)>>("CStream${suffix}_Destroy");
     return address;
@@ -427,4 +501,34 @@ class SEDManagerCAPI {
         .asFunction<void Function(Pointer<CStream<StreamType>>, Pointer<CStreamCallback<ResultType>>)>(isLeaf: false);
     return function;
   }
+
+  final streamUIDAdvanceN = dylib.lookupFunction<
+      Void Function(Pointer<CStreamUid>, Size, Pointer<CStreamCallback<Pointer<CUIDBatch>>>),
+      void Function(Pointer<CStreamUid>, int, Pointer<CStreamCallback<Pointer<CUIDBatch>>>)>(
+    "CStreamUID_AdvanceN",
+    isLeaf: false,
+  );
+
+  final uidBatchDestroy = dylib.lookupFunction<Void Function(Pointer<CUIDBatch>), void Function(Pointer<CUIDBatch>)>(
+    "CUIDBatch_Destroy",
+    isLeaf: true,
+  );
+
+  final uidBatchGetData = dylib.lookupFunction<Pointer<CUID> Function(Pointer<CUIDBatch>),
+      Pointer<CUID> Function(Pointer<CUIDBatch>)>(
+    "CUIDBatch_GetData",
+    isLeaf: true,
+  );
+
+  final uidBatchGetLength = dylib.lookupFunction<Size Function(Pointer<CUIDBatch>), int Function(Pointer<CUIDBatch>)>(
+    "CUIDBatch_GetLength",
+    isLeaf: true,
+  );
+
+  Pointer<CString> Function(Pointer<CStream<T>>) lookupStreamGetExceptionMessage<T extends NativeType>(String suffix) {
+    return dylib.lookupFunction<Pointer<CString> Function(Pointer<CStream<T>>), Pointer<CString> Function(Pointer<CStream<T>>)>(
+      "CStream${suffix}_GetException_Message",
+      isLeaf: true,
+    );
+  }
 }
@@ -0,0 +1,53 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'encrypted_device.dart' show UID;
+
+enum TableSnapshotCellStatus { value, empty, failure }
+
+class TableSnapshotCell {
+  const TableSnapshotCell(this.status, this.content);
+
+  final TableSnapshotCellStatus status;
+
+  /// The value rendered to JSON, or the error message for failed cells.
+  final String content;
+}
+
+class TableSnapshot {
+  TableSnapshot(this.rows, this.columnCount, this._cells);
+
+  /// Decodes the packed buffer returned by CSession_GetTableSnapshot.
+  factory TableSnapshot.decode(Uint8List buffer) {
+    final data = ByteData.sublistView(buffer);
+    var offset = 0;
+
+    final rowCount = data.getUint32(offset, Endian.little);
+    final columnCount = data.getUint32(offset + 4, Endian.little);
+    offset += 8;
+
+    final rows = <UID>[];
+    final cells = <TableSnapshotCell>[];
+    for (int row = 0; row < rowCount; ++row) {
+      rows.add(data.getUint64(offset, Endian.little));
+      offset += 8;
+      for (int column = 0; column < columnCount; ++column) {
+        final status = TableSnapshotCellStatus.values[data.getUint8(offset)];
+        final length = data.getUint32(offset + 1, Endian.little);
+        offset += 5;
+        final content = utf8.decode(Uint8List.sublistView(buffer, offset, offset + length));
+        offset += length;
+        cells.add(TableSnapshotCell(status, content));
+      }
+    }
+    return TableSnapshot(rows, columnCount, cells);
+  }
+
+  final List<UID> rows;
+  final int columnCount;
+  final List<TableSnapshotCell> _cells;
+
+  TableSnapshotCell cell(int row, int column) {
+    return _cells[row * columnCount + column];
+  }
+}
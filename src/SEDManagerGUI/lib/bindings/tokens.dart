@@ -0,0 +1,134 @@
+import 'dart:typed_data';
+
+import 'errors.dart';
+
+/// A named value, the decoded form of a StartName ... EndName token group.
+class NamedValue {
+  const NamedValue(this.name, this.value);
+
+  final Object? name;
+  final Object? value;
+
+  @override
+  String toString() {
+    return "$name = $value";
+  }
+}
+
+/// A control token that is not part of a list or named value, e.g. Call.
+class Command {
+  const Command(this.tag);
+
+  final int tag;
+
+  @override
+  String toString() {
+    return "Command(0x${tag.toRadixString(16)})";
+  }
+}
+
+const _startList = 0xF0;
+const _endList = 0xF1;
+const _startName = 0xF2;
+const _endName = 0xF3;
+
+/// Decodes the TCG token stream produced by CValue_Serialize.
+///
+/// Integers become [int], byte sequences [Uint8List] views into [tokens],
+/// lists [List], named values [NamedValue] and other control tokens [Command].
+/// An empty buffer decodes to null.
+Object? decodeTokens(Uint8List tokens) {
+  if (tokens.isEmpty) {
+    return null;
+  }
+  final reader = _TokenReader(tokens);
+  final value = reader.readValue();
+  if (!reader.atEnd) {
+    throw SEDException("unexpected tokens after value");
+  }
+  return value;
+}
+
+class _TokenReader {
+  _TokenReader(this._buffer) : _data = ByteData.sublistView(_buffer);
+
+  final Uint8List _buffer;
+  final ByteData _data;
+  int _offset = 0;
+
+  bool get atEnd => _offset >= _buffer.length;
+
+  int _readByte() {
+    if (atEnd) {
+      throw SEDException("token stream ended unexpectedly");
+    }
+    return _data.getUint8(_offset++);
+  }
+
+  int _peekByte() {
+    if (atEnd) {
+      throw SEDException("token stream ended unexpectedly");
+    }
+    return _data.getUint8(_offset);
+  }
+
+  Object? readValue() {
+    final header = _readByte();
+    if (header & 0x80 == 0x00) {
+      final isSigned = (header >> 6) & 1 == 1;
+      final bits = header & 0x3F;
+      return isSigned && (bits & 0x20) != 0 ? bits - 0x40 : bits;
+    }
+    if (header & 0xC0 == 0x80) {
+      return _readAtom((header >> 5) & 1 == 1, (header >> 4) & 1 == 1, header & 0x0F);
+    }
+    if (header & 0xE0 == 0xC0) {
+      final length = ((header & 0x07) << 8) | _readByte();
+      return _readAtom((header >> 4) & 1 == 1, (header >> 3) & 1 == 1, length);
+    }
+    if (header & 0xF8 == 0xE0) {
+      final length = (_readByte() << 16) | (_readByte() << 8) | _readByte();
+      return _readAtom((header >> 1) & 1 == 1, header & 1 == 1, length);
+    }
+    switch (header) {
+      case _startList:
+        final list = <Object?>[];
+        while (_peekByte() != _endList) {
+          list.add(readValue());
+        }
+        _readByte();
+        return list;
+      case _startName:
+        final name = readValue();
+        final value = readValue();
+        if (_readByte() != _endName) {
+          throw SEDException("named value not terminated properly");
+        }
+        return NamedValue(name, value);
+      default:
+        return Command(header);
+    }
+  }
+
+  Object _readAtom(bool isByte, bool isSigned, int length) {
+    if (_offset + length > _buffer.length) {
+      throw SEDException("token stream ended unexpectedly");
+    }
+    final bytes = Uint8List.sublistView(_buffer, _offset, _offset + length);
+    _offset += length;
+    if (isByte) {
+      return bytes;
+    }
+    if (length > 8) {
+      throw SEDException("integer is too wide");
+    }
+    var value = 0;
+    for (final byte in bytes) {
+      value = (value << 8) | byte;
+    }
+    if (isSigned && length > 0 && length < 8 && (bytes[0] & 0x80) != 0) {
+      value -= 1 << (8 * length);
+    }
+    return value;
+  }
+}
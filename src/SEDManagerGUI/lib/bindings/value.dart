@@ -2,8 +2,10 @@ import "dart:ffi";
 import "dart:typed_data";
 import "package:ffi/ffi.dart";
 
+import "bytes.dart";
 import "errors.dart";
 import "sedmanager_capi.dart";
+import "tokens.dart";
 
 class Value implements Finalizable {
   Value(this._handle) {
@@ -78,6 +80,24 @@ class Value implements Finalizable {
     _capi.valueSetNamed(_handle, name.handle(), value.handle());
   }
 
+  /// Creates a value from its TCG token stream encoding in a single call.
+  /// Throws an [SEDException] if the tokens don't encode exactly one value.
+  factory Value.fromTokens(Uint8List tokens) {
+    // Allocating zero bytes may fail, even though an empty stream is just invalid.
+    final ptr = malloc.allocate<Uint8>(tokens.isEmpty ? 1 : tokens.length);
+    final Pointer<CValue> handle;
+    try {
+      ptr.asTypedList(tokens.length).setAll(0, tokens);
+      handle = _capi.valueDeserialize(ptr, tokens.length);
+    } finally {
+      malloc.free(ptr);
+    }
+    if (handle == nullptr) {
+      throw SEDException(getLastErrorMessage());
+    }
+    return Value(handle);
+  }
+
   static final _capi = SEDManagerCAPI();
   static final _finalizer = NativeFinalizer(_capi.valueDestroyAddress.cast());
   final Pointer<CValue> _handle;
@@ -110,6 +130,16 @@ class Value implements Finalizable {
     throw SEDException("value is not an integer");
   }
 
+  /// The TCG token stream encoding of the value, empty if the value is empty.
+  Uint8List toTokens() {
+    return BytesWrapper(_capi.valueSerialize(_handle)).toUint8List();
+  }
+
+  /// Converts the value into plain Dart objects without per-node FFI calls.
+  Object? decode() {
+    return decodeTokens(toTokens());
+  }
+
   Pointer<CValue> handle() {
     return _handle;
   }
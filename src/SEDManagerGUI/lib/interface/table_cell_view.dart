@@ -1,6 +1,8 @@
 import 'dart:async';
 import 'package:flutter/material.dart';
 import 'package:sed_manager_gui/bindings/encrypted_device.dart';
+import 'package:sed_manager_gui/bindings/errors.dart';
+import 'package:sed_manager_gui/bindings/table_snapshot.dart';
 import 'package:sed_manager_gui/interface/components/snapshot_builder.dart';
 import 'package:table_sticky_headers/table_sticky_headers.dart';
 import 'package:sed_manager_gui/bindings/type.dart';
@@ -228,9 +230,14 @@ class TableValueCell extends StatelessWidget {
     this.object,
     this.column,
     this.type, {
+    TableSnapshotCell? initialValue,
     super.key,
   }) {
-    _getValue().ignore();
+    if (initialValue != null) {
+      _setFromSnapshot(initialValue);
+    } else {
+      _getValue().ignore();
+    }
   }
 
   final EncryptedDevice encryptedDevice;
@@ -262,6 +269,17 @@ class TableValueCell extends StatelessWidget {
     );
   }
 
+  void _setFromSnapshot(TableSnapshotCell cell) {
+    switch (cell.status) {
+      case TableSnapshotCellStatus.value:
+        _currentValue.add(cell.content);
+      case TableSnapshotCellStatus.empty:
+        _currentValue.add("");
+      case TableSnapshotCellStatus.failure:
+        _currentValue.addError(SEDException(cell.content));
+    }
+  }
+
   Future<void> _getValue() async {
     try {
       final value = await session.getValue(object, column);
@@ -381,8 +399,8 @@ class TableCellView extends StatelessWidget {
   final Session session;
   final UID table;
 
-  Future<(List<UID>, List<ColumnDesc>)> _getLayout() async {
-    final rows = await session.getTableRows(table).toList();
+  Future<(TableSnapshot, List<ColumnDesc>)> _getLayout() async {
+    final snapshot = await session.getTableSnapshot(table);
     final columns = <ColumnDesc>[];
     for (int column = 0; column < session.getColumnCount(table); ++column) {
       columns.add(ColumnDesc(
@@ -390,14 +408,16 @@ class TableCellView extends StatelessWidget {
         session.getColumnType(table, column),
       ));
     }
-    return (rows, columns);
+    return (snapshot, columns);
   }
 
   Widget _buildWithData(
     BuildContext context,
-    List<UID> rows,
+    TableSnapshot snapshot,
     List<ColumnDesc> columns,
   ) {
+    final rows = snapshot.rows;
+
     Widget headerBuilder(columnIdx) {
       return TableHeaderCell(columns[columnIdx + 1].name);
     }
@@ -413,6 +433,7 @@ class TableCellView extends StatelessWidget {
         rows[rowIdx],
         columnIdx + 1,
         columns[columnIdx + 1].type,
+        initialValue: snapshot.cell(rowIdx, columnIdx + 1),
       );
     }
 
@@ -457,9 +478,9 @@ class TableCellView extends StatelessWidget {
       future: _getLayout(),
       builder: (context, snapshot) {
         if (snapshot.hasData) {
-          final rows = snapshot.data!.$1;
+          final tableSnapshot = snapshot.data!.$1;
           final columns = snapshot.data!.$2;
-          return _buildWithData(context, rows, columns);
+          return _buildWithData(context, tableSnapshot, columns);
         } else if (snapshot.hasError) {
           return _buildWithError(snapshot.error!);
         }
@@ -88,6 +88,12 @@ struct NoResponseError : std::logic_error {
 };
 
 
+struct CancelledError : std::runtime_error {
+    CancelledError(std::string_view reason)
+        : std::runtime_error(std::format("operation cancelled: {}", reason)) {}
+};
+
+
 struct InvocationError : std::logic_error {
     InvocationError(std::string_view methodName, std::string_view message)
         : std::logic_error(std::format("invoking '{}' failed: {}", methodName, message)) {}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+
+namespace sedmgr {
+
+// A stand-in for C++23's std::unexpected and std::expected, covering the parts
+// used here. Accessing the value of an Expected that holds an error throws.
+template <class E>
+class Unexpected {
+public:
+    explicit Unexpected(E error) : m_error(std::move(error)) {}
+
+    E& error() & { return m_error; }
+    const E& error() const& { return m_error; }
+    E&& error() && { return std::move(m_error); }
+
+private:
+    E m_error;
+};
+
+
+template <class T, class E>
+class Expected {
+public:
+    Expected() requires std::is_default_constructible_v<T> : m_storage(std::in_place_index<0>) {}
+    Expected(T value) : m_storage(std::in_place_index<0>, std::move(value)) {}
+    Expected(Unexpected<E> error) : m_storage(std::in_place_index<1>, std::move(error).error()) {}
+
+    bool has_value() const noexcept { return m_storage.index() == 0; }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    T& value() & { return Check(), std::get<0>(m_storage); }
+    const T& value() const& { return Check(), std::get<0>(m_storage); }
+    T&& value() && { return Check(), std::get<0>(std::move(m_storage)); }
+
+    T& operator*() & { return value(); }
+    const T& operator*() const& { return value(); }
+    T&& operator*() && { return std::move(*this).value(); }
+    T* operator->() { return &value(); }
+    const T* operator->() const { return &value(); }
+
+    E& error() & { return std::get<1>(m_storage); }
+    const E& error() const& { return std::get<1>(m_storage); }
+
+    template <class U>
+    T value_or(U&& fallback) const& {
+        return has_value() ? std::get<0>(m_storage) : static_cast<T>(std::forward<U>(fallback));
+    }
+
+private:
+    void Check() const {
+        if (!has_value()) {
+            throw std::logic_error("expected object holds an error");
+        }
+    }
+
+private:
+    std::variant<T, E> m_storage;
+};
+
+
+template <class E>
+class Expected<void, E> {
+public:
+    Expected() = default;
+    Expected(Unexpected<E> error) : m_error(std::move(error).error()), m_hasValue(false) {}
+
+    bool has_value() const noexcept { return m_hasValue; }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    void value() const {
+        if (!has_value()) {
+            throw std::logic_error("expected object holds an error");
+        }
+    }
+
+    E& error() & { return m_error; }
+    const E& error() const& { return m_error; }
+
+private:
+    E m_error = {};
+    bool m_hasValue = true;
+};
+
+} // namespace sedmgr
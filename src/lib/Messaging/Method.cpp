@@ -119,6 +119,15 @@ Value MethodResultToValue(const MethodResult& result) {
 }
 
 
+void MethodError::Throw(std::string_view methodName) const {
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+    MethodStatusToException(methodName, status);
+    throw InvocationError(methodName, "unknown error");
+}
+
+
 void MethodStatusToException(std::string_view methodName, eMethodStatus status) {
     switch (status) {
         case eMethodStatus::NOT_AUTHORIZED: throw NotAuthorizedError(methodName);
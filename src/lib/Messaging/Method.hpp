@@ -3,8 +3,15 @@
 #include "Native.hpp"
 #include "Value.hpp"
 
+#include <Error/Expected.hpp>
+
 #include <asyncpp/task.hpp>
 
+#include <exception>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 
 namespace sedmgr {
 
@@ -51,6 +58,21 @@ Value MethodResultToValue(const MethodResult& result);
 void MethodStatusToException(std::string_view methodName, eMethodStatus status);
 
 
+// The reason a method call failed: either the TPer replied with a status other
+// than SUCCESS, or the call itself failed, in which case the exception is kept.
+struct MethodError {
+    eMethodStatus status = eMethodStatus::FAIL;
+    std::exception_ptr exception = nullptr;
+
+    bool Is(eMethodStatus s) const { return !exception && status == s; }
+    [[noreturn]] void Throw(std::string_view methodName) const;
+};
+
+
+template <class T>
+using MethodExpected = Expected<T, MethodError>;
+
+
 struct CallContext {
     UID invokingId;
     std::function<asyncpp::task<MethodResult>(MethodCall)> callRemoteMethod;
@@ -60,6 +82,34 @@ struct CallContext {
 
 namespace impl_method {
 
+    // The method name is either a string or a callable that makes it, so that
+    // it's only looked up when an error is reported.
+    template <class MethodName>
+    decltype(auto) ResolveMethodName(const MethodName& methodName) {
+        if constexpr (std::is_invocable_v<const MethodName&>) {
+            return methodName();
+        }
+        else {
+            return std::string_view(methodName);
+        }
+    }
+
+
+    template <class MethodName>
+    std::pair<int, const Value&> GetOptionalResult(const Value& result, const MethodName& methodName) {
+        if (!result.Is<Named>()) {
+            throw InvocationError(ResolveMethodName(methodName),
+                                  std::format("expected named values for optional results, got {}", result.GetTypeStr()));
+        }
+        const auto& [name, value] = result.Get<Named>();
+        if (!name.IsInteger()) {
+            throw InvocationError(ResolveMethodName(methodName),
+                                  std::format("expected named value with integer key, key was {}", name.GetTypeStr()));
+        }
+        return { name.Get<int>(), value };
+    }
+
+
     template <class Required, class Optional>
     struct ParameterList;
 
@@ -78,30 +128,28 @@ namespace impl_method {
         static Unpacked Unpack(std::span<const Value> results, std::string_view methodName = "<unknown method>") {
             if (results.size() < sizeof...(Requireds)) {
                 throw InvocationError(methodName,
-                                      std::format("expected {} required results, got {}", results.size(), sizeof...(Requireds)));
+                                      std::format("expected {} required results, got {}", sizeof...(Requireds), results.size()));
             }
-            auto requireds = std::tuple(std::move(results[Requireds::key])...);
-            const auto optionalSubset = results.subspan(sizeof...(Requireds));
-            std::unordered_map<int, Value> presentOptionals;
-            for (auto& result : optionalSubset) {
-                if (!result.Is<Named>()) {
-                    throw InvocationError(methodName,
-                                          std::format("expected named values for optional results, got {}", result.GetTypeStr()));
-                }
-                auto [name, value] = std::move(result.Get<Named>());
-                if (!name.IsInteger()) {
-                    throw InvocationError(methodName,
-                                          std::format("expected named value with integer key, key was {}", name.GetTypeStr()));
-                }
-                presentOptionals.insert_or_assign(name.Get<int>(), std::move(value));
+            auto requireds = std::tuple(results[Requireds::key]...);
+            std::tuple<typename Optionals::Native...> optionals;
+            for (auto& result : results.subspan(sizeof...(Requireds))) {
+                const auto [key, value] = GetOptionalResult(result, methodName);
+                StoreOptional(optionals, key, value, std::index_sequence_for<Optionals...>{});
             }
-            auto optionals = std::tuple((std::move(presentOptionals.contains(Optionals::key)
-                                                       ? std::optional(std::move(presentOptionals.find(Optionals::key)->second))
-                                                       : std::nullopt))...);
             return std::tuple_cat(std::move(requireds), std::move(optionals));
         }
 
     private:
+        // The keys are known at compile time, so this is a chain of comparisons
+        // rather than a lookup in a map built for every call.
+        template <size_t... Indices>
+        static void StoreOptional(std::tuple<typename Optionals::Native...>& optionals,
+                                  int key,
+                                  const Value& value,
+                                  std::index_sequence<Indices...>) {
+            (void)(... || (key == Optionals::key ? (std::get<Indices>(optionals) = value, true) : false));
+        }
+
         static std::optional<Value> MakeOptional(int key, std::optional<Value> value) {
             if (value) {
                 return Value(Named{ uint16_t(key), *value });
@@ -191,6 +239,113 @@ namespace impl_method {
         using type = MakeMethodPackHelper<std::make_integer_sequence<int, Count>, Optional>::type;
     };
 
+
+    template <class T>
+    struct IsOptional : std::false_type {};
+
+    template <class T>
+    struct IsOptional<std::optional<T>> : std::true_type {};
+
+
+    template <class... Types>
+    consteval bool AreOptionalsTrailing() {
+        bool trailing = true;
+        bool seenOptional = false;
+        (..., (trailing = trailing && (!seenOptional || IsOptional<Types>::value),
+               seenOptional = seenOptional || IsOptional<Types>::value));
+        return trailing;
+    }
+
+
+    template <class T>
+    Value ToValue(const T& native) {
+        if constexpr (std::same_as<T, Value> || std::same_as<T, List>) {
+            return Value(native);
+        }
+        else {
+            return value_cast(native);
+        }
+    }
+
+
+    template <class T>
+    T FromValue(const Value& value) {
+        if constexpr (std::same_as<T, Value>) {
+            return value;
+        }
+        else if constexpr (std::same_as<T, List> || std::same_as<T, Bytes>) {
+            return value.Get<T>();
+        }
+        else {
+            return value_cast<T>(value);
+        }
+    }
+
+
+    // Parameters are native types, the trailing std::optionals being the optional
+    // parameters. An optional's key is its position among the optionals.
+    template <class... Types>
+    struct TypedParameterList {
+        static_assert(AreOptionalsTrailing<Types...>(), "optional parameters must follow the required ones");
+
+        static constexpr size_t requiredCount = (0 + ... + size_t(!IsOptional<Types>::value));
+        static constexpr size_t optionalCount = sizeof...(Types) - requiredCount;
+        using Unpacked = std::tuple<Types...>;
+
+        static std::vector<Value> Pack(const Types&... natives) {
+            return [&]<size_t... Indices>(std::index_sequence<Indices...>) {
+                std::vector<Value> values;
+                values.reserve(sizeof...(Types));
+                (..., PackElement<Indices>(values, natives));
+                return values;
+            }(std::index_sequence_for<Types...>{});
+        }
+
+        template <class MethodName>
+        static Unpacked Unpack(std::span<const Value> values, const MethodName& methodName) {
+            if (values.size() < requiredCount) {
+                throw InvocationError(ResolveMethodName(methodName),
+                                      std::format("expected {} required results, got {}", requiredCount, values.size()));
+            }
+            Unpacked unpacked;
+            UnpackRequireds(unpacked, values, std::make_index_sequence<requiredCount>{});
+            for (auto& value : values.subspan(requiredCount)) {
+                const auto [key, optionalValue] = GetOptionalResult(value, methodName);
+                UnpackOptionals(unpacked, key, optionalValue, std::make_index_sequence<optionalCount>{});
+            }
+            return unpacked;
+        }
+
+    private:
+        template <size_t Index, class T>
+        static void PackElement(std::vector<Value>& values, const T& native) {
+            if constexpr (IsOptional<T>::value) {
+                if (native) {
+                    values.emplace_back(Named{ uint16_t(Index - requiredCount), ToValue(*native) });
+                }
+            }
+            else {
+                values.push_back(ToValue(native));
+            }
+        }
+
+        template <size_t... Indices>
+        static void UnpackRequireds(Unpacked& unpacked, std::span<const Value> values, std::index_sequence<Indices...>) {
+            (..., (std::get<Indices>(unpacked) = FromValue<std::tuple_element_t<Indices, Unpacked>>(values[Indices])));
+        }
+
+        template <size_t... Keys>
+        static void UnpackOptionals(Unpacked& unpacked, int key, const Value& value, std::index_sequence<Keys...>) {
+            (void)(... || (key == int(Keys) ? (UnpackOptional<requiredCount + Keys>(unpacked, value), true) : false));
+        }
+
+        template <size_t Index>
+        static void UnpackOptional(Unpacked& unpacked, const Value& value) {
+            using Native = typename std::tuple_element_t<Index, Unpacked>::value_type;
+            std::get<Index>(unpacked) = FromValue<Native>(value);
+        }
+    };
+
 } // namespace impl_method
 
 
@@ -206,4 +361,88 @@ public:
     }
 };
 
+
+template <class... Types>
+struct Params {};
+
+template <class... Types>
+struct Results {};
+
+
+// Like Method, but the parameters and results are native types, such as
+// TypedMethod<Get, Params<CellBlock>, Results<List>>. Arguments are converted
+// straight into the call's values, and results straight into native types.
+template <UID MethodId, class ParamList, class ResultList>
+class TypedMethod;
+
+template <UID MethodId, class... ParamTypes, class... ResultTypes>
+class TypedMethod<MethodId, Params<ParamTypes...>, Results<ResultTypes...>> {
+    using InputList = impl_method::TypedParameterList<ParamTypes...>;
+    using OutputList = impl_method::TypedParameterList<ResultTypes...>;
+
+public:
+    using ResultType = std::tuple<ResultTypes...>;
+
+    static constexpr auto GetMethodId() {
+        return MethodId;
+    }
+
+    asyncpp::task<ResultType> operator()(CallContext context, ParamTypes... args) const {
+        MethodCall call{
+            .invokingId = context.invokingId,
+            .methodId = MethodId,
+            .args = InputList::Pack(args...),
+            .status = eMethodStatus::SUCCESS,
+        };
+        const MethodResult result = co_await context.callRemoteMethod(std::move(call));
+
+        if (result.status != eMethodStatus::SUCCESS) {
+            MethodStatusToException(GetMethodName(context), result.status);
+        }
+
+        co_return OutputList::Unpack(result.values, [&context] { return GetMethodName(context); });
+    }
+
+    // Like operator(), but failures, including a status other than SUCCESS, are
+    // returned as a MethodError instead of being thrown.
+    asyncpp::task<MethodExpected<ResultType>> Try(CallContext context, ParamTypes... args) const {
+        using Outcome = MethodExpected<ResultType>;
+
+        MethodCall call{
+            .invokingId = context.invokingId,
+            .methodId = MethodId,
+            .args = InputList::Pack(args...),
+            .status = eMethodStatus::SUCCESS,
+        };
+        MethodResult result;
+        std::exception_ptr exception = nullptr;
+        try {
+            result = co_await context.callRemoteMethod(std::move(call));
+        }
+        catch (...) {
+            exception = std::current_exception();
+        }
+        if (exception) {
+            co_return Outcome(Unexpected(MethodError{ .exception = exception }));
+        }
+        if (result.status != eMethodStatus::SUCCESS) {
+            co_return Outcome(Unexpected(MethodError{ .status = result.status }));
+        }
+
+        try {
+            co_return Outcome(OutputList::Unpack(result.values, [&context] { return GetMethodName(context); }));
+        }
+        catch (...) {
+            exception = std::current_exception();
+        }
+        co_return Outcome(Unexpected(MethodError{ .exception = exception }));
+    }
+
+private:
+    // Only called on failure, the lookup is too costly for every call.
+    static std::string GetMethodName(const CallContext& context) {
+        return context.getMethodName ? context.getMethodName(MethodId) : "<method name unspecified>";
+    }
+};
+
 } // namespace sedmgr
\ No newline at end of file
@@ -8,27 +8,47 @@
 #include <Messaging/Value.hpp>
 #include <Specification/Core/CoreModule.hpp>
 
+#include <algorithm>
 #include <random>
+#include <thread>
 
 
 namespace sedmgr {
 
 
-MockDevice::MockDevice() {
-    m_securityProviders = mock::GetMockPreconfig();
+MockDevice::MockDevice() : MockDevice(mock::SimulationConfig{}) {}
 
-    m_messageHandlers.push_back(std::make_unique<mock::DiscoveryHandler>(baseComId));
-    m_messageHandlers.push_back(std::make_unique<mock::ResetHandler>());
-    m_messageHandlers.push_back(std::make_unique<mock::RequestComIdHandler>());
-    m_messageHandlers.push_back(std::make_unique<mock::CommunicationLayerHandler>(baseComId, 0x0000));
-    m_messageHandlers.push_back(std::make_unique<mock::SessionLayerHandler>(baseComId, 0x0000, m_securityProviders));
+
+MockDevice::MockDevice(mock::SimulationConfig config)
+    : m_simulator(std::make_shared<mock::Simulator>(std::move(config))) {
+    const auto& simulation = m_simulator->GetConfig();
+    m_securityProviders = mock::GetMockPreconfig(simulation.dataStoreSize);
+    m_nextComId = baseComId + simulation.numStaticComIds;
+
+    const GeometryFeatureDesc geometry = {
+        .alignmentRequired = simulation.alignmentRequired,
+        .logicalBlockSize = simulation.logicalBlockSize,
+        .alignmentGranularity = simulation.alignmentGranularity,
+        .lowestAlignedLba = simulation.lowestAlignedLba,
+    };
+    auto& discovery = *m_messageHandlers.emplace_back(std::make_unique<mock::DiscoveryHandler>(baseComId, simulation.numStaticComIds, simulation.dynamicComIds, geometry));
+    auto& reset = *m_messageHandlers.emplace_back(std::make_unique<mock::ResetHandler>());
+    AddRoute(0x01, 0x0001, discovery);
+    AddRoute(0x02, 0x0004, reset);
+    if (simulation.dynamicComIds) {
+        auto& requestComId = *m_messageHandlers.emplace_back(std::make_unique<mock::RequestComIdHandler>([this] { return AllocateComId(); }));
+        AddRoute(0x02, 0x0000, requestComId);
+    }
+    for (uint16_t index = 0; index < simulation.numStaticComIds; ++index) {
+        AddComId(baseComId + index, 0x0000);
+    }
 }
 
 
 StorageDeviceDesc MockDevice::GetDesc() {
     return StorageDeviceDesc{
         .name = "Mock Device",
-        .serial = "MOCK0001",
+        .serial = m_simulator->GetConfig().serial,
         .firmware = "MOCKFW01",
         .interface = eStorageDeviceInterface::OTHER,
     };
@@ -39,12 +59,11 @@ void MockDevice::SecuritySend(uint8_t securityProtocol,
                               std::span<const std::byte, 2> protocolSpecific,
                               std::span<const std::byte> data) {
     const uint16_t comId = uint16_t(protocolSpecific[0]) | uint16_t(protocolSpecific[1]) << 8;
-    for (const auto& handler : m_messageHandlers) {
-        if (handler->SecuritySend(securityProtocol, comId, data)) {
-            return;
-        }
+    std::lock_guard lk(m_mutex);
+    const auto handler = FindRoute(securityProtocol, comId);
+    if (!handler || !handler->SecuritySend(securityProtocol, comId, data)) {
+        throw DeviceError(std::format("IF_SEND: invalid security protocol ({}) / ComID ({})", securityProtocol, comId));
     }
-    throw DeviceError(std::format("IF_SEND: invalid security protocol ({}) / ComID ({})", securityProtocol, comId));
 }
 
 
@@ -52,12 +71,49 @@ void MockDevice::SecurityReceive(uint8_t securityProtocol,
                                  std::span<const std::byte, 2> protocolSpecific,
                                  std::span<std::byte> data) {
     const uint16_t comId = uint16_t(protocolSpecific[0]) | uint16_t(protocolSpecific[1]) << 8;
-    for (const auto& handler : m_messageHandlers) {
-        if (handler->SecurityReceive(securityProtocol, comId, data)) {
-            return;
-        }
+    const auto latency = [this] {
+        std::lock_guard lk(m_mutex);
+        return m_simulator->SampleIfRecv();
+    }();
+    if (latency.count() > 0) {
+        std::this_thread::sleep_for(latency);
     }
-    throw DeviceError(std::format("IF_RECV: invalid security protocol ({}) / ComID ({})", securityProtocol, comId));
+    std::lock_guard lk(m_mutex);
+    const auto handler = FindRoute(securityProtocol, comId);
+    if (!handler || !handler->SecurityReceive(securityProtocol, comId, data)) {
+        throw DeviceError(std::format("IF_RECV: invalid security protocol ({}) / ComID ({})", securityProtocol, comId));
+    }
+}
+
+
+void MockDevice::AddRoute(uint8_t securityProtocol, uint16_t comId, mock::MessageHandler& handler) {
+    m_routes.insert_or_assign(uint32_t(securityProtocol) << 16 | comId, &handler);
+}
+
+
+mock::MessageHandler* MockDevice::FindRoute(uint8_t securityProtocol, uint16_t comId) const {
+    const auto it = m_routes.find(uint32_t(securityProtocol) << 16 | comId);
+    return it != m_routes.end() ? it->second : nullptr;
+}
+
+
+void MockDevice::AddComId(uint16_t comId, uint16_t comIdExt) {
+    auto& sessionLayer = static_cast<mock::SessionLayerHandler&>(
+        *m_messageHandlers.emplace_back(std::make_unique<mock::SessionLayerHandler>(comId, comIdExt, m_securityProviders, m_simulator)));
+    auto& communicationLayer = *m_messageHandlers.emplace_back(
+        std::make_unique<mock::CommunicationLayerHandler>(comId, comIdExt, [&sessionLayer] { sessionLayer.Reset(); }));
+    AddRoute(0x02, comId, communicationLayer);
+    AddRoute(0x01, comId, sessionLayer);
+}
+
+
+std::pair<uint16_t, uint16_t> MockDevice::AllocateComId() {
+    if (m_nextComId == 0xFFFF) {
+        throw DeviceError("no more ComIDs available");
+    }
+    const uint16_t comId = m_nextComId++;
+    AddComId(comId, 0x0000);
+    return { comId, 0x0000 };
 }
 
 
@@ -67,7 +123,8 @@ namespace mock {
     // Discovery handler
     //--------------------------------------------------------------------------
 
-    DiscoveryHandler::DiscoveryHandler(uint16_t baseComId) : m_baseComId(baseComId) {}
+    DiscoveryHandler::DiscoveryHandler(uint16_t baseComId, uint16_t numComIds, bool comIdMgmtSupported, GeometryFeatureDesc geometry)
+        : m_baseComId(baseComId), m_numComIds(numComIds), m_comIdMgmtSupported(comIdMgmtSupported), m_geometry(geometry) {}
 
 
     bool DiscoveryHandler::SecuritySend(uint8_t securityProtocol,
@@ -91,7 +148,7 @@ namespace mock {
     void DiscoveryHandler::Discovery(std::span<std::byte> data) {
         const std::array discovery = {
             // Discovery header
-            0_b, 0_b, 0_b, 52_b, // Length of data
+            0_b, 0_b, 0_b, 84_b, // Length of data
             0_b, 0_b, // Version major
             0_b, 0_b, // Version minor
             0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0_b, // Reserved
@@ -103,7 +160,7 @@ namespace mock {
             0x00_b, 0x01_b, // Feature code
             0x10_b, // Version
             0x0C_b, // Length
-            0b0001'0001_b, // Bitmask
+            0b0001'0001_b | (m_comIdMgmtSupported ? 0b0100'0000_b : 0_b), // Bitmask
             0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0_b, // Reserved
             0_b, 0_b, 0_b, // Reserved
             // Locking desc
@@ -113,12 +170,28 @@ namespace mock {
             0b0000'0000_b, // Bitmask
             0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0_b, // Reserved
             0_b, 0_b, 0_b, // Reserved
+            // Geometry desc
+            0x00_b, 0x03_b, // Feature code
+            0x10_b, // Version
+            0x1C_b, // Length
+            m_geometry.alignmentRequired ? 0x01_b : 0x00_b, // Bitmask
+            0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0_b, // Reserved
+            std::byte(m_geometry.logicalBlockSize >> 24), std::byte(m_geometry.logicalBlockSize >> 16),
+            std::byte(m_geometry.logicalBlockSize >> 8), std::byte(m_geometry.logicalBlockSize), // Logical block size
+            std::byte(m_geometry.alignmentGranularity >> 56), std::byte(m_geometry.alignmentGranularity >> 48),
+            std::byte(m_geometry.alignmentGranularity >> 40), std::byte(m_geometry.alignmentGranularity >> 32),
+            std::byte(m_geometry.alignmentGranularity >> 24), std::byte(m_geometry.alignmentGranularity >> 16),
+            std::byte(m_geometry.alignmentGranularity >> 8), std::byte(m_geometry.alignmentGranularity), // Alignment granularity
+            std::byte(m_geometry.lowestAlignedLba >> 56), std::byte(m_geometry.lowestAlignedLba >> 48),
+            std::byte(m_geometry.lowestAlignedLba >> 40), std::byte(m_geometry.lowestAlignedLba >> 32),
+            std::byte(m_geometry.lowestAlignedLba >> 24), std::byte(m_geometry.lowestAlignedLba >> 16),
+            std::byte(m_geometry.lowestAlignedLba >> 8), std::byte(m_geometry.lowestAlignedLba), // Lowest aligned LBA
             // Mock SSC desc == Opal v1 for now
             0x02_b, 0x00_b, // Feature code
             0x10_b, // Version | Reserved
             0x10_b, // Length
             std::byte(m_baseComId >> 8), std::byte(m_baseComId), // Base ComID
-            0x00_b, 0x01_b, // Num ComIDs
+            std::byte(m_numComIds >> 8), std::byte(m_numComIds), // Num ComIDs
             0x00_b, // Reserved
             0_b, 0_b, 0_b, 0_b, // Reserved
             0_b, 0_b, 0_b, 0_b, // Reserved
@@ -156,6 +229,10 @@ namespace mock {
     // Request ComID handler
     //--------------------------------------------------------------------------
 
+    RequestComIdHandler::RequestComIdHandler(std::function<std::pair<uint16_t, uint16_t>()> allocateComId)
+        : m_allocateComId(std::move(allocateComId)) {}
+
+
     bool RequestComIdHandler::SecuritySend(uint8_t securityProtocol,
                                            uint16_t comId,
                                            std::span<const std::byte> data) {
@@ -167,7 +244,13 @@ namespace mock {
                                               uint16_t comId,
                                               std::span<std::byte> data) {
         if (securityProtocol == 0x02 && comId == 0x0000) {
-            throw DeviceError("request ComID not implemented");
+            if (data.size() < 4) {
+                throw DeviceError("receive buffer too small");
+            }
+            const auto [allocatedComId, allocatedComIdExt] = m_allocateComId();
+            std::ranges::copy(Serialize(allocatedComId), data.begin());
+            std::ranges::copy(Serialize(allocatedComIdExt), data.begin() + 2);
+            return true;
         }
         return false;
     }
@@ -177,8 +260,8 @@ namespace mock {
     // Communication layer handler
     //--------------------------------------------------------------------------
 
-    CommunicationLayerHandler::CommunicationLayerHandler(uint16_t comId, uint16_t comIdExt)
-        : m_comId(comId), m_comIdExt(comIdExt) {}
+    CommunicationLayerHandler::CommunicationLayerHandler(uint16_t comId, uint16_t comIdExt, std::function<void()> onStackReset)
+        : m_comId(comId), m_comIdExt(comIdExt), m_onStackReset(std::move(onStackReset)) {}
 
 
     bool CommunicationLayerHandler::SecuritySend(uint8_t securityProtocol,
@@ -236,6 +319,9 @@ namespace mock {
 
 
     void CommunicationLayerHandler::StackReset() {
+        if (m_onStackReset) {
+            m_onStackReset();
+        }
         const StackResetResponse response = {
             .comId = m_comId,
             .comIdExtension = m_comIdExt,
@@ -253,10 +339,12 @@ namespace mock {
 
     SessionLayerHandler::SessionLayerHandler(uint16_t comId,
                                              uint16_t comIdExt,
-                                             std::vector<std::shared_ptr<SecurityProvider>> securityProviders)
+                                             std::vector<std::shared_ptr<SecurityProvider>> securityProviders,
+                                             std::shared_ptr<Simulator> simulator)
         : m_comId(comId),
           m_comIdExt(comIdExt),
-          m_securityProviders(std::move(securityProviders)) {}
+          m_securityProviders(std::move(securityProviders)),
+          m_simulator(std::move(simulator)) {}
 
 
     bool SessionLayerHandler::SecuritySend(uint8_t securityProtocol,
@@ -288,7 +376,7 @@ namespace mock {
                 EndSession(tsn, hsn);
             }
             else {
-                DecodeMethod(value, tsn, hsn);
+                DecodeStream(items, tsn, hsn);
             }
             return true;
         }
@@ -300,41 +388,20 @@ namespace mock {
                                               uint16_t comId,
                                               std::span<std::byte> data) {
         if (securityProtocol == 0x01 && comId == m_comId) {
-            static const ComPacket emptyPacket{
-                .comId = m_comId,
-                .comIdExtension = m_comIdExt,
-                .outstandingData = 0,
-                .minTransfer = 0,
-            };
-            static const auto emptyResponse = Serialize(emptyPacket);
-
-            if (!m_response) {
-                if (emptyResponse.size() <= data.size()) {
-                    std::ranges::copy(emptyResponse, data.begin());
-                }
-                else {
-                    throw DeviceError("receive buffer too small");
-                }
+            if (m_responses.empty()) {
+                WriteResponse(0, 0, data);
+            }
+            else if (std::chrono::steady_clock::now() < m_responses.front().readyAt) {
+                WriteResponse(1, 0, data);
             }
             else {
-                if (m_response->size() <= data.size()) {
-                    std::ranges::copy(*m_response, data.begin());
-                    m_response = std::nullopt;
+                const auto& response = m_responses.front().bytes;
+                if (response.size() <= data.size()) {
+                    std::ranges::copy(response, data.begin());
+                    m_responses.pop_front();
                 }
                 else {
-                    const ComPacket outstandingPacket{
-                        .comId = m_comId,
-                        .comIdExtension = m_comIdExt,
-                        .outstandingData = uint32_t(m_response->size()),
-                        .minTransfer = uint32_t(m_response->size()),
-                    };
-                    const auto outstandingResponse = Serialize(outstandingPacket);
-                    if (outstandingResponse.size() <= data.size()) {
-                        std::ranges::copy(outstandingResponse, data.begin());
-                    }
-                    else {
-                        throw DeviceError("receive buffer too small");
-                    }
+                    WriteResponse(uint32_t(response.size()), uint32_t(response.size()), data);
                 }
             }
             return true;
@@ -343,14 +410,47 @@ namespace mock {
     }
 
 
-    void SessionLayerHandler::DecodeMethod(const Value& value, uint32_t tsn, uint32_t hsn) {
+    void SessionLayerHandler::DecodeStream(const List& items, uint32_t tsn, uint32_t hsn) {
+        List replies;
+        size_t index = 0;
+        while (index < items.size()) {
+            if (!items[index].Is<eCommand>()) {
+                throw DeviceError("invalid method call format");
+            }
+            const auto command = items[index].Get<eCommand>();
+            if (command == eCommand::START_TRANSACTION || command == eCommand::END_TRANSACTION) {
+                if (index + 1 >= items.size() || !items[index + 1].IsInteger()) {
+                    throw DeviceError("missing transaction status");
+                }
+                const auto status = uint8_t(items[index + 1].Get<unsigned>());
+                const auto reply = command == eCommand::START_TRANSACTION ? StartTransaction(tsn, hsn) : EndTransaction(tsn, hsn, status);
+                replies.emplace_back(command);
+                replies.emplace_back(reply);
+                index += 2;
+            }
+            else {
+                const auto count = std::min(methodCallItems, items.size() - index);
+                const Value call = List(items.begin() + index, items.begin() + index + count);
+                const auto reply = DecodeMethod(call, tsn, hsn);
+                std::ranges::copy(reply.Get<List>(), std::back_inserter(replies));
+                index += count;
+            }
+        }
+        const auto tokenStream = UnSurroundWithList(TokenStream(Tokenize(Value(std::move(replies)))));
+        auto response = Serialize(tokenStream);
+        QueueResponse(Serialize(Packetize(tsn, hsn, std::move(response))));
+    }
+
+
+    Value SessionLayerHandler::DecodeMethod(const Value& value, uint32_t tsn, uint32_t hsn) {
         try {
             const auto call = MethodCallFromValue(value);
+            m_pendingLatency += m_simulator->SampleMethod(call.methodId);
             if (call.invokingId == UID(0xFF)) {
-                DispatchMethod(call);
+                return DispatchMethod(call);
             }
             else {
-                DispatchMethod(call, tsn, hsn);
+                return DispatchMethod(call, tsn, hsn);
             }
         }
         catch (std::invalid_argument&) {
@@ -358,7 +458,7 @@ namespace mock {
         }
     }
 
-    void SessionLayerHandler::DispatchMethod(const MethodCall& call) {
+    Value SessionLayerHandler::DispatchMethod(const MethodCall& call) {
         std::optional<MethodCall> reply;
         switch (core::eMethod(call.methodId)) {
             case core::eMethod::Properties: {
@@ -376,17 +476,11 @@ namespace mock {
         if (!reply) {
             throw DeviceError(std::format("invalid/unsupported session layer method: {}", call.methodId.ToString()));
         }
-        const auto tokenStream = UnSurroundWithList(TokenStream(Tokenize(MethodCallToValue(*reply))));
-        auto response = Serialize(tokenStream);
-        m_response = Serialize(Packetize(0, 0, std::move(response)));
+        return MethodCallToValue(*reply);
     }
 
-    void SessionLayerHandler::DispatchMethod(const MethodCall& call, uint32_t tsn, uint32_t hsn) {
-        const auto sessionIt = m_sessions.find({ tsn, hsn });
-        if (sessionIt == m_sessions.end()) {
-            throw DeviceError("invalid session");
-        }
-        auto& session = sessionIt->second;
+    Value SessionLayerHandler::DispatchMethod(const MethodCall& call, uint32_t tsn, uint32_t hsn) {
+        auto& session = GetSession(tsn, hsn);
         const auto reply = [&]() -> std::optional<MethodResult> {
             switch (call.methodId.value) {
                 case UID(core::eMethod::Get).value: return CallMethod(call, session, &SessionLayerHandler::Get, getMethod);
@@ -402,9 +496,10 @@ namespace mock {
         if (!reply) {
             throw DeviceError(std::format("invalid/unsupported session layer method: {}", call.methodId.ToString()));
         }
-        const auto tokenStream = UnSurroundWithList(TokenStream(Tokenize(MethodResultToValue(*reply))));
-        auto response = Serialize(tokenStream);
-        m_response = Serialize(Packetize(tsn, hsn, std::move(response)));
+        if (session.transactionSnapshot && reply->status != eMethodStatus::SUCCESS) {
+            session.transactionFailed = true;
+        }
+        return MethodResultToValue(*reply);
     }
 
     ComPacket SessionLayerHandler::Packetize(uint32_t tsn, uint32_t hsn, std::vector<std::byte> payload) const {
@@ -423,6 +518,32 @@ namespace mock {
         return comPacket;
     }
 
+
+    void SessionLayerHandler::QueueResponse(std::vector<std::byte> response) {
+        // The TPer works through requests one at a time, so a response can't
+        // become ready before the ones queued ahead of it.
+        const auto now = std::chrono::steady_clock::now();
+        const auto start = m_responses.empty() ? now : std::max(now, m_responses.back().readyAt);
+        const auto latency = std::exchange(m_pendingLatency, {});
+        m_responses.push_back({ std::move(response), start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(latency) });
+    }
+
+
+    void SessionLayerHandler::WriteResponse(uint32_t outstandingData, uint32_t minTransfer, std::span<std::byte> data) const {
+        const ComPacket packet{
+            .comId = m_comId,
+            .comIdExtension = m_comIdExt,
+            .outstandingData = outstandingData,
+            .minTransfer = minTransfer,
+        };
+        const auto response = Serialize(packet);
+        if (response.size() > data.size()) {
+            throw DeviceError("receive buffer too small");
+        }
+        std::ranges::copy(response, data.begin());
+    }
+
+
     template <class Executor, class Definition>
     MethodResult SessionLayerHandler::CallMethod(const MethodCall& query,
                                                  Session& session,
@@ -458,13 +579,25 @@ namespace mock {
     }
 
 
+    void SessionLayerHandler::Reset() {
+        // A stack reset aborts all sessions and drops pending responses.
+        for (const auto& [id, session] : m_sessions) {
+            m_simulator->CloseSession(session.securityProvider->GetUID());
+        }
+        m_sessions.clear();
+        m_responses.clear();
+        m_pendingLatency = {};
+    }
+
+
     void SessionLayerHandler::EndSession(uint32_t tperSessionNumber, uint32_t hostSessionNumber) {
         const auto sessionIt = m_sessions.find({ tperSessionNumber, hostSessionNumber });
         if (sessionIt != m_sessions.end()) {
+            m_simulator->CloseSession(sessionIt->second.securityProvider->GetUID());
             m_sessions.erase(sessionIt);
             const auto tokenStream = TokenStream(Tokenize(Value(eCommand::END_OF_SESSION)));
             auto response = Serialize(tokenStream);
-            m_response = Serialize(Packetize(0, 0, std::move(response)));
+            QueueResponse(Serialize(Packetize(0, 0, std::move(response))));
         }
         else {
             throw DeviceError("invalid session");
@@ -472,6 +605,41 @@ namespace mock {
     }
 
 
+    uint8_t SessionLayerHandler::StartTransaction(uint32_t tperSessionNumber, uint32_t hostSessionNumber) {
+        auto& session = GetSession(tperSessionNumber, hostSessionNumber);
+        if (session.transactionSnapshot) {
+            return uint8_t(eMethodStatus::TRANSACTION_FAILURE);
+        }
+        session.transactionSnapshot = *session.securityProvider;
+        session.transactionFailed = false;
+        return uint8_t(eMethodStatus::SUCCESS);
+    }
+
+
+    uint8_t SessionLayerHandler::EndTransaction(uint32_t tperSessionNumber, uint32_t hostSessionNumber, uint8_t status) {
+        auto& session = GetSession(tperSessionNumber, hostSessionNumber);
+        if (!session.transactionSnapshot) {
+            return uint8_t(eMethodStatus::TRANSACTION_FAILURE);
+        }
+        const bool commit = status == 0 && !session.transactionFailed;
+        if (!commit) {
+            *session.securityProvider = std::move(*session.transactionSnapshot);
+        }
+        session.transactionSnapshot = std::nullopt;
+        session.transactionFailed = false;
+        return commit ? uint8_t(eMethodStatus::SUCCESS) : uint8_t(eMethodStatus::TRANSACTION_FAILURE);
+    }
+
+
+    auto SessionLayerHandler::GetSession(uint32_t tperSessionNumber, uint32_t hostSessionNumber) -> Session& {
+        const auto sessionIt = m_sessions.find({ tperSessionNumber, hostSessionNumber });
+        if (sessionIt == m_sessions.end()) {
+            throw DeviceError("invalid session");
+        }
+        return sessionIt->second;
+    }
+
+
     auto SessionLayerHandler::Properties(std::optional<std::unordered_map<std::string, uint32_t>>) const
         -> std::pair<std::tuple<std::unordered_map<std::string, uint32_t>,
                                 std::optional<std::unordered_map<std::string, uint32_t>>>,
@@ -479,7 +647,7 @@ namespace mock {
         const std::unordered_map<std::string, uint32_t> tperProperties = {
             {"MaxPackets",        1    },
             { "MaxSubpackets",    1    },
-            { "MaxMethods",       1    },
+            { "MaxMethods",       16   },
             { "MaxComPacketSize", 65536},
             { "MaxIndTokenSize",  65536},
             { "MaxAggTokenSize",  65536},
@@ -525,40 +693,39 @@ namespace mock {
             };
         }
 
-        const auto hasSession = m_sessions.end() != std::ranges::find_if(m_sessions, [&](const auto& session) { return session.second.securityProvider == *spIt; });
-        if (hasSession) {
+        const auto tsn = m_simulator->OpenSession(spId);
+        if (!tsn) {
             return {
                 std::tuple(hostSessionID, 0, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt),
                 eMethodStatus::SP_BUSY,
             };
         }
 
-        const uint32_t tsn = m_nextTsn++;
-        m_sessions.insert_or_assign(SessionId{ tsn, hostSessionID }, Session{ *spIt });
+        m_sessions.insert_or_assign(SessionId{ *tsn, hostSessionID }, Session{ *spIt });
         return {
-            std::tuple(hostSessionID, tsn, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt),
+            std::tuple(hostSessionID, *tsn, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt),
             eMethodStatus::SUCCESS,
         };
     }
 
 
     auto SessionLayerHandler::Get(Session& session, UID invokingId, CellBlock cellBlock) const
-        -> std::pair<std::tuple<List>, eMethodStatus> {
+        -> std::pair<std::tuple<Value>, eMethodStatus> {
         if (invokingId.IsObject() || invokingId.IsDescriptor()) {
-            const auto securityProvider = *session.securityProvider;
+            const auto& securityProvider = *session.securityProvider;
             const auto containingTableUid = invokingId.ContainingTable();
             if (!securityProvider.contains(containingTableUid)) {
-                return { {}, eMethodStatus::INVALID_PARAMETER };
+                return { { List{} }, eMethodStatus::INVALID_PARAMETER };
             }
             const auto& containingTable = securityProvider[containingTableUid];
             if (!containingTable.contains(invokingId)) {
-                return { {}, eMethodStatus::INVALID_PARAMETER };
+                return { { List{} }, eMethodStatus::INVALID_PARAMETER };
             }
             const auto& object = containingTable[invokingId];
             const auto firstColumn = cellBlock.startColumn.value_or(0);
             const auto lastColumn = cellBlock.endColumn.value_or(object.Size() - 1) + 1;
             if (firstColumn > lastColumn || lastColumn > object.Size()) {
-                return { {}, eMethodStatus::INVALID_PARAMETER };
+                return { { List{} }, eMethodStatus::INVALID_PARAMETER };
             }
             List values;
             for (auto i = firstColumn; i < lastColumn; ++i) {
@@ -569,8 +736,24 @@ namespace mock {
             }
             return { { std::move(values) }, eMethodStatus::SUCCESS };
         }
+        else if (session.securityProvider->HasByteTable(invokingId)) {
+            // Rows of a byte table are its bytes, and the end row is inclusive.
+            const auto data = session.securityProvider->GetByteTable(invokingId).Data();
+            if (cellBlock.startColumn || cellBlock.endColumn || data.empty()) {
+                return { { List{} }, eMethodStatus::INVALID_PARAMETER };
+            }
+            if (cellBlock.startRow && !std::holds_alternative<uint32_t>(*cellBlock.startRow)) {
+                return { { List{} }, eMethodStatus::INVALID_PARAMETER };
+            }
+            const size_t firstRow = cellBlock.startRow ? std::get<uint32_t>(*cellBlock.startRow) : 0;
+            const size_t lastRow = cellBlock.endRow.value_or(uint32_t(data.size() - 1));
+            if (firstRow > lastRow || lastRow >= data.size()) {
+                return { { List{} }, eMethodStatus::INVALID_PARAMETER };
+            }
+            return { { Value(data.subspan(firstRow, lastRow - firstRow + 1)) }, eMethodStatus::SUCCESS };
+        }
         else {
-            throw NotImplementedError("byte tables are not implemented");
+            throw NotImplementedError("only object and byte tables are implemented");
         }
     }
 
@@ -611,15 +794,56 @@ namespace mock {
                     return { {}, eMethodStatus::INVALID_PARAMETER };
                 }
             }
+            auto updated = object;
             for (const auto& item : list) {
                 const auto& [name, value] = item.Get<Named>();
-                object[name.Get<uint16_t>()] = value;
+                updated[name.Get<uint16_t>()] = value;
+            }
+            if (containingTableUid == UID(core::eTable::Locking) && !IsRangeAligned(updated)) {
+                return { {}, eMethodStatus::INVALID_PARAMETER };
+            }
+            object = std::move(updated);
+            return { {}, eMethodStatus::SUCCESS };
+        }
+        else if (session.securityProvider->HasByteTable(invokingId)) {
+            const auto data = session.securityProvider->GetByteTable(invokingId).Data();
+            if (where && !where->IsInteger()) {
+                return { {}, eMethodStatus::INVALID_PARAMETER };
+            }
+            if (!values || !values->Is<Bytes>()) {
+                return { {}, eMethodStatus::INVALID_PARAMETER };
             }
+            const size_t firstRow = where ? where->Get<uint32_t>() : 0;
+            const auto& bytes = values->Get<Bytes>();
+            if (firstRow > data.size() || bytes.size() > data.size() - firstRow) {
+                return { {}, eMethodStatus::INVALID_PARAMETER };
+            }
+            std::ranges::copy(bytes, data.begin() + firstRow);
             return { {}, eMethodStatus::SUCCESS };
         }
         else {
-            throw NotImplementedError("byte tables are not implemented");
+            throw NotImplementedError("only object and byte tables are implemented");
+        }
+    }
+
+
+    bool SessionLayerHandler::IsRangeAligned(const Object& range) const {
+        // The global range covers the whole drive and doesn't use RangeStart and
+        // RangeLength, so the alignment requirement doesn't apply to it.
+        constexpr auto globalRangeUid = 0x0000'0802'0000'0001_uid;
+        const auto& config = m_simulator->GetConfig();
+        if (!config.alignmentRequired || config.alignmentGranularity == 0 || range.GetUID() == globalRangeUid) {
+            return true;
+        }
+        const auto rangeStart = range[3].HasValue() ? range[3].Get<uint64_t>() : 0;
+        const auto rangeLength = range[4].HasValue() ? range[4].Get<uint64_t>() : 0;
+        const auto lowestAligned = config.lowestAlignedLba % config.alignmentGranularity;
+        if (rangeLength == 0) {
+            return true;
         }
+        return rangeStart >= lowestAligned
+               && (rangeStart - lowestAligned) % config.alignmentGranularity == 0
+               && rangeLength % config.alignmentGranularity == 0;
     }
 
 
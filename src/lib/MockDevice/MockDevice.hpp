@@ -1,16 +1,24 @@
 #pragma once
 
 
+#include "Simulation.hpp"
 #include "State.hpp"
 
 #include <Messaging/ComPacket.hpp>
 #include <Specification/Core/Defs/UIDs.hpp>
 #include <Specification/Opal/OpalModule.hpp>
 #include <StorageDevice/Common/StorageDevice.hpp>
+#include <TrustedPeripheral/Discovery.hpp>
 #include <TrustedPeripheral/MethodUtils.hpp>
 
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <span>
+#include <unordered_map>
 #include <vector>
 
 
@@ -31,7 +39,7 @@ namespace mock {
 
     class DiscoveryHandler : public MessageHandler {
     public:
-        DiscoveryHandler(uint16_t baseComId);
+        DiscoveryHandler(uint16_t baseComId, uint16_t numComIds, bool comIdMgmtSupported, GeometryFeatureDesc geometry);
         bool SecuritySend(uint8_t securityProtocol,
                           uint16_t comId,
                           std::span<const std::byte> data) override;
@@ -43,6 +51,9 @@ namespace mock {
 
     private:
         uint16_t m_baseComId;
+        uint16_t m_numComIds;
+        bool m_comIdMgmtSupported;
+        GeometryFeatureDesc m_geometry;
     };
 
     class ResetHandler : public MessageHandler {
@@ -57,17 +68,21 @@ namespace mock {
 
     class RequestComIdHandler : public MessageHandler {
     public:
+        RequestComIdHandler(std::function<std::pair<uint16_t, uint16_t>()> allocateComId);
         bool SecuritySend(uint8_t securityProtocol,
                           uint16_t comId,
                           std::span<const std::byte> data) override;
         bool SecurityReceive(uint8_t securityProtocol,
                              uint16_t comId,
                              std::span<std::byte> data) override;
+
+    private:
+        std::function<std::pair<uint16_t, uint16_t>()> m_allocateComId;
     };
 
     class CommunicationLayerHandler : public MessageHandler {
     public:
-        CommunicationLayerHandler(uint16_t comId, uint16_t comIdExt);
+        CommunicationLayerHandler(uint16_t comId, uint16_t comIdExt, std::function<void()> onStackReset = {});
         bool SecuritySend(uint8_t securityProtocol,
                           uint16_t comId,
                           std::span<const std::byte> data) override;
@@ -82,6 +97,7 @@ namespace mock {
     private:
         uint16_t m_comId;
         uint16_t m_comIdExt;
+        std::function<void()> m_onStackReset;
         std::optional<std::vector<std::byte>> m_response;
     };
 
@@ -93,24 +109,35 @@ namespace mock {
         };
         struct Session {
             std::shared_ptr<SecurityProvider> securityProvider;
+            std::optional<SecurityProvider> transactionSnapshot = std::nullopt;
+            bool transactionFailed = false;
+        };
+        struct Response {
+            std::vector<std::byte> bytes;
+            std::chrono::steady_clock::time_point readyAt;
         };
 
     public:
         SessionLayerHandler(uint16_t comId,
                             uint16_t comIdExt,
-                            std::vector<std::shared_ptr<SecurityProvider>> securityProviders);
+                            std::vector<std::shared_ptr<SecurityProvider>> securityProviders,
+                            std::shared_ptr<Simulator> simulator);
         bool SecuritySend(uint8_t securityProtocol,
                           uint16_t comId,
                           std::span<const std::byte> data) override;
         bool SecurityReceive(uint8_t securityProtocol,
                              uint16_t comId,
                              std::span<std::byte> data) override;
+        void Reset();
 
     private:
-        void DecodeMethod(const Value& call, uint32_t tsn, uint32_t hsn);
-        void DispatchMethod(const MethodCall&, uint32_t tsn, uint32_t hsn);
-        void DispatchMethod(const MethodCall&);
+        void DecodeStream(const List& items, uint32_t tsn, uint32_t hsn);
+        Value DecodeMethod(const Value& call, uint32_t tsn, uint32_t hsn);
+        Value DispatchMethod(const MethodCall&, uint32_t tsn, uint32_t hsn);
+        Value DispatchMethod(const MethodCall&);
         ComPacket Packetize(uint32_t tsn, uint32_t hsn, std::vector<std::byte> payload) const;
+        void QueueResponse(std::vector<std::byte> response);
+        void WriteResponse(uint32_t outstandingData, uint32_t minTransfer, std::span<std::byte> data) const;
 
         template <class Executor, class Definition>
         MethodResult CallMethod(const MethodCall& query,
@@ -124,6 +151,9 @@ namespace mock {
                                 Definition&& definition);
 
         void EndSession(uint32_t tperSessionNumber, uint32_t hostSessionNumber);
+        uint8_t StartTransaction(uint32_t tperSessionNumber, uint32_t hostSessionNumber);
+        uint8_t EndTransaction(uint32_t tperSessionNumber, uint32_t hostSessionNumber, uint8_t status);
+        Session& GetSession(uint32_t tperSessionNumber, uint32_t hostSessionNumber);
 
         auto Properties(std::optional<std::unordered_map<std::string, uint32_t>>) const
             -> std::pair<std::tuple<std::unordered_map<std::string, uint32_t>,
@@ -153,11 +183,13 @@ namespace mock {
                          eMethodStatus>;
 
         auto Get(Session& session, UID invokingId, CellBlock cellBlock) const
-            -> std::pair<std::tuple<List>, eMethodStatus>;
+            -> std::pair<std::tuple<Value>, eMethodStatus>;
 
         auto Set(Session& session, UID invokingId, std::optional<Value> where, std::optional<Value> values) const
             -> std::pair<std::tuple<>, eMethodStatus>;
 
+        bool IsRangeAligned(const Object& range) const;
+
         auto Next(Session& session, UID invokingId, std::optional<UID> where, std::optional<uint32_t> count) const
             -> std::pair<std::tuple<List>, eMethodStatus>;
 
@@ -185,12 +217,17 @@ namespace mock {
         static constexpr auto revertMethod = Method<UID(opal::eMethod::Revert), 0, 0, 0, 0>{};
         static constexpr auto activateMethod = Method<UID(opal::eMethod::Activate), 0, 0, 0, 0>{};
 
+        // A method call in a stream: CALL, invoking ID, method ID, arguments,
+        // END_OF_DATA and the status list.
+        static constexpr size_t methodCallItems = 6;
+
         uint16_t m_comId;
         uint16_t m_comIdExt;
         std::vector<std::shared_ptr<SecurityProvider>> m_securityProviders;
-        std::optional<std::vector<std::byte>> m_response;
+        std::shared_ptr<Simulator> m_simulator;
+        std::deque<Response> m_responses;
+        std::chrono::nanoseconds m_pendingLatency = {};
         std::map<SessionId, Session> m_sessions;
-        mutable uint32_t m_nextTsn = 5000;
     };
 
 } // namespace mock
@@ -204,6 +241,7 @@ class MockDevice : public StorageDevice {
 
 public:
     MockDevice();
+    explicit MockDevice(mock::SimulationConfig config);
 
     StorageDeviceDesc GetDesc() override;
     void SecuritySend(uint8_t securityProtocol,
@@ -214,8 +252,18 @@ public:
                          std::span<std::byte> data) override;
 
 private:
+    void AddRoute(uint8_t securityProtocol, uint16_t comId, mock::MessageHandler& handler);
+    mock::MessageHandler* FindRoute(uint8_t securityProtocol, uint16_t comId) const;
+    void AddComId(uint16_t comId, uint16_t comIdExt);
+    std::pair<uint16_t, uint16_t> AllocateComId();
+
+private:
+    std::shared_ptr<mock::Simulator> m_simulator;
     std::vector<std::shared_ptr<mock::SecurityProvider>> m_securityProviders;
     std::vector<std::unique_ptr<mock::MessageHandler>> m_messageHandlers;
+    std::unordered_map<uint32_t, mock::MessageHandler*> m_routes;
+    uint16_t m_nextComId;
+    std::mutex m_mutex;
     static constexpr uint16_t baseComId = 4097;
 };
 
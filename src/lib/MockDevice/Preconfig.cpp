@@ -7,6 +7,8 @@
 #include <Specification/PSID/PSIDModule.hpp>
 #include <TrustedPeripheral/ModuleCollection.hpp>
 
+#include <format>
+
 using namespace std::string_literals;
 using namespace std::string_view_literals;
 
@@ -67,7 +69,7 @@ namespace mock {
         return std::make_shared<SecurityProvider>(adminSpUid, tables);
     }
 
-    std::shared_ptr<SecurityProvider> LockingPreconfig() {
+    std::shared_ptr<SecurityProvider> LockingPreconfig(uint32_t dataStoreSize) {
         ModuleCollection modules;
         modules.Load(CoreModule::Get());
         modules.Load(Opal1Module::Get());
@@ -85,6 +87,12 @@ namespace mock {
         const auto globalKeyUid = modules.FindUid("K_AES_256::GlobalRange", lockingSpUid).value();
         const auto globalKeyValue = Named(Bytes{ 0x00_b, 0x00_b, 0x02_b, 0x06_b }, value_cast("00007IFTW5NW3BT583N5TBV35TV34C5N4V56B7534BV872NV325N6B34B6H4UIVB"sv));
 
+        const auto range = [&](int index) {
+            const auto rangeUid = modules.FindUid(std::format("Locking::Range{}", index), lockingSpUid).value();
+            const auto keyUid = modules.FindUid(std::format("K_AES_256::Range{}", index), lockingSpUid).value();
+            return Object(rangeUid, { value_cast(std::format("Range{}", index)), {}, 0, 0, 0, 0, 0, 0, {}, value_cast(keyUid), value_cast(UID(0)), {}, {}, {}, {}, {}, {}, {}, {} });
+        };
+
         const auto mbrControlUid = modules.FindUid("MBRControl::MBRControl", lockingSpUid).value();
 
         const auto aceSetRdLockedUid = modules.FindUid("ACE::Locking_GlobalRange_Set_RdLocked", lockingSpUid).value();
@@ -102,6 +110,7 @@ namespace mock {
                     Object(UID(core::eTable::K_AES_256).ToDescriptor(), { value_cast("K_AES_256"sv), {}, {}, 1, {}, {}, {}, {}, {}, {}, {}, {}, 0, 0 }),
                     Object(UID(core::eTable::MBRControl).ToDescriptor(), { value_cast("MBRControl"sv), {}, {}, 1, {}, {}, {}, {}, {}, {}, {}, {}, 0, 0 }),
                     Object(UID(core::eTable::ACE).ToDescriptor(), { value_cast("ACE"sv), {}, {}, 1, {}, {}, {}, {}, {}, {}, {}, {}, 0, 0 }),
+                    Object(UID(opal::eTable::DataStore).ToDescriptor(), { value_cast("DataStore"sv), {}, {}, 2, {}, {}, dataStoreSize, {}, {}, {}, {}, {}, 1, 1 }),
                 }),
             Table(
                 UID(core::eTable::Authority),
@@ -118,6 +127,14 @@ namespace mock {
             Table(UID(core::eTable::Locking),
                   {
                       Object(globalRangeUid, { value_cast("GlobalRange"sv), {}, 0, 16384, 0, 0, 0, 0, {}, value_cast(globalKeyUid), value_cast(UID(0)), {}, {}, {}, {}, {}, {}, {}, {} }),
+                      range(1),
+                      range(2),
+                      range(3),
+                      range(4),
+                      range(5),
+                      range(6),
+                      range(7),
+                      range(8),
                   }),
             Table(UID(core::eTable::K_AES_256),
                   {
@@ -135,11 +152,15 @@ namespace mock {
                   }),
         };
 
-        return std::make_shared<SecurityProvider>(lockingSpUid, tables);
+        const auto byteTables = {
+            ByteTable(UID(opal::eTable::DataStore), dataStoreSize),
+        };
+
+        return std::make_shared<SecurityProvider>(lockingSpUid, tables, byteTables);
     }
 
-    std::vector<std::shared_ptr<SecurityProvider>> GetMockPreconfig() {
-        return { AdminPreconfig(), LockingPreconfig() };
+    std::vector<std::shared_ptr<SecurityProvider>> GetMockPreconfig(uint32_t dataStoreSize) {
+        return { AdminPreconfig(), LockingPreconfig(dataStoreSize) };
     }
 
 } // namespace mock
@@ -6,7 +6,7 @@
 namespace sedmgr {
 
 namespace mock {
-    std::vector<std::shared_ptr<SecurityProvider>> GetMockPreconfig();
+    std::vector<std::shared_ptr<SecurityProvider>> GetMockPreconfig(uint32_t dataStoreSize);
 }
 
 } // namespace sedmgr
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "Simulation.hpp"
+
+#include <algorithm>
+
+
+namespace sedmgr {
+
+namespace mock {
+
+    LatencyDistribution LatencyDistribution::Constant(std::chrono::nanoseconds value) {
+        LatencyDistribution distribution;
+        distribution.m_kind = eKind::CONSTANT;
+        distribution.m_first = value;
+        return distribution;
+    }
+
+
+    LatencyDistribution LatencyDistribution::Uniform(std::chrono::nanoseconds min, std::chrono::nanoseconds max) {
+        LatencyDistribution distribution;
+        distribution.m_kind = eKind::UNIFORM;
+        distribution.m_first = std::min(min, max);
+        distribution.m_second = std::max(min, max);
+        return distribution;
+    }
+
+
+    LatencyDistribution LatencyDistribution::Exponential(std::chrono::nanoseconds mean) {
+        LatencyDistribution distribution;
+        distribution.m_kind = eKind::EXPONENTIAL;
+        distribution.m_first = mean;
+        return distribution;
+    }
+
+
+    auto LatencyDistribution::Kind() const -> eKind {
+        return m_kind;
+    }
+
+
+    std::chrono::nanoseconds LatencyDistribution::Sample(std::mt19937_64& rne) const {
+        switch (m_kind) {
+            case eKind::NONE: return {};
+            case eKind::CONSTANT: return m_first;
+            case eKind::UNIFORM: {
+                std::uniform_int_distribution<int64_t> distribution(m_first.count(), m_second.count());
+                return std::chrono::nanoseconds(distribution(rne));
+            }
+            case eKind::EXPONENTIAL: {
+                if (m_first.count() <= 0) {
+                    return {};
+                }
+                std::exponential_distribution<double> distribution(1.0 / double(m_first.count()));
+                return std::chrono::nanoseconds(int64_t(distribution(rne)));
+            }
+        }
+        return {};
+    }
+
+
+    Simulator::Simulator(SimulationConfig config)
+        : m_config(std::move(config)), m_rne(m_config.seed) {}
+
+
+    const SimulationConfig& Simulator::GetConfig() const {
+        return m_config;
+    }
+
+
+    std::chrono::nanoseconds Simulator::SampleMethod(UID methodId) {
+        const auto overrideIt = m_config.methodLatencyOverrides.find(methodId);
+        const auto& distribution = overrideIt != m_config.methodLatencyOverrides.end() ? overrideIt->second : m_config.methodLatency;
+        return distribution.Sample(m_rne);
+    }
+
+
+    std::chrono::nanoseconds Simulator::SampleIfRecv() {
+        return m_config.ifRecvLatency.Sample(m_rne);
+    }
+
+
+    std::optional<uint32_t> Simulator::OpenSession(UID securityProvider) {
+        auto& numSessions = m_openSessions[securityProvider];
+        if (numSessions >= m_config.maxSessionsPerSp) {
+            return std::nullopt;
+        }
+        ++numSessions;
+        return m_nextTsn++;
+    }
+
+
+    void Simulator::CloseSession(UID securityProvider) {
+        const auto it = m_openSessions.find(securityProvider);
+        if (it != m_openSessions.end() && it->second > 0) {
+            --it->second;
+        }
+    }
+
+} // namespace mock
+
+} // namespace sedmgr
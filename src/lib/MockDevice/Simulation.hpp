@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Messaging/UID.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+
+namespace sedmgr {
+
+namespace mock {
+
+    class LatencyDistribution {
+    public:
+        enum class eKind {
+            NONE,
+            CONSTANT,
+            UNIFORM,
+            EXPONENTIAL,
+        };
+
+    public:
+        LatencyDistribution() = default;
+        static LatencyDistribution Constant(std::chrono::nanoseconds value);
+        static LatencyDistribution Uniform(std::chrono::nanoseconds min, std::chrono::nanoseconds max);
+        static LatencyDistribution Exponential(std::chrono::nanoseconds mean);
+
+        eKind Kind() const;
+        std::chrono::nanoseconds Sample(std::mt19937_64& rne) const;
+
+    private:
+        eKind m_kind = eKind::NONE;
+        std::chrono::nanoseconds m_first = {};
+        std::chrono::nanoseconds m_second = {};
+    };
+
+
+    struct SimulationConfig {
+        std::string serial = "MOCK0001";
+        // How long the TPer takes to produce a response. Until then, IF-RECV
+        // returns an empty ComPacket with OutstandingData = 1.
+        LatencyDistribution methodLatency = {};
+        std::unordered_map<UID, LatencyDistribution> methodLatencyOverrides = {};
+        // How long each IF-RECV blocks the caller, like the ioctl of a real drive.
+        LatencyDistribution ifRecvLatency = {};
+        uint16_t numStaticComIds = 1;
+        bool dynamicComIds = false;
+        uint32_t maxSessionsPerSp = 1;
+        // Size of the Locking SP's DataStore byte table.
+        uint32_t dataStoreSize = 128 * 1024;
+        // Reported by the Geometry feature. When alignment is required, the
+        // Locking table rejects ranges that are not aligned to the granularity.
+        bool alignmentRequired = false;
+        uint32_t logicalBlockSize = 512;
+        uint64_t alignmentGranularity = 8;
+        uint64_t lowestAlignedLba = 0;
+        uint64_t seed = 0;
+    };
+
+
+    class Simulator {
+    public:
+        explicit Simulator(SimulationConfig config);
+
+        const SimulationConfig& GetConfig() const;
+        std::chrono::nanoseconds SampleMethod(UID methodId);
+        std::chrono::nanoseconds SampleIfRecv();
+
+        // Sessions are limited per SP and numbered across all ComIDs of the
+        // device. Returns the TSN, or nothing if the SP is busy.
+        std::optional<uint32_t> OpenSession(UID securityProvider);
+        void CloseSession(UID securityProvider);
+
+    private:
+        SimulationConfig m_config;
+        std::mt19937_64 m_rne;
+        std::unordered_map<UID, uint32_t> m_openSessions;
+        uint32_t m_nextTsn = 5000;
+    };
+
+} // namespace mock
+
+} // namespace sedmgr
@@ -104,11 +104,38 @@ namespace mock {
     }
 
 
-    SecurityProvider::SecurityProvider(UID uid, std::initializer_list<Table> tables)
+    ByteTable::ByteTable(UID uid, size_t size)
+        : m_uid(uid), m_bytes(size) {}
+
+
+    size_t ByteTable::Size() const {
+        return m_bytes.size();
+    }
+
+
+    std::span<std::byte> ByteTable::Data() {
+        return m_bytes;
+    }
+
+
+    std::span<const std::byte> ByteTable::Data() const {
+        return m_bytes;
+    }
+
+
+    UID ByteTable::GetUID() const {
+        return m_uid;
+    }
+
+
+    SecurityProvider::SecurityProvider(UID uid, std::initializer_list<Table> tables, std::initializer_list<ByteTable> byteTables)
         : m_uid(uid) {
         for (const auto& table : tables) {
             m_tables.insert_or_assign(table.GetUID(), table);
         }
+        for (const auto& byteTable : byteTables) {
+            m_byteTables.insert_or_assign(byteTable.GetUID(), byteTable);
+        }
     }
 
 
@@ -131,6 +158,25 @@ namespace mock {
     }
 
 
+    bool SecurityProvider::HasByteTable(UID table) const {
+        return m_byteTables.contains(table);
+    }
+
+
+    ByteTable& SecurityProvider::GetByteTable(UID table) {
+        const auto it = m_byteTables.find(table);
+        assert(it != m_byteTables.end());
+        return it->second;
+    }
+
+
+    const ByteTable& SecurityProvider::GetByteTable(UID table) const {
+        const auto it = m_byteTables.find(table);
+        assert(it != m_byteTables.end());
+        return it->second;
+    }
+
+
     UID SecurityProvider::GetUID() const {
         return m_uid;
     }
@@ -4,8 +4,10 @@
 #include <Messaging/Value.hpp>
 #include <TrustedPeripheral/MethodUtils.hpp>
 
+#include <span>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 
 namespace sedmgr {
@@ -50,18 +52,37 @@ namespace mock {
     };
 
 
+    class ByteTable {
+    public:
+        ByteTable(UID uid, size_t size);
+
+        size_t Size() const;
+        std::span<std::byte> Data();
+        std::span<const std::byte> Data() const;
+        UID GetUID() const;
+
+    private:
+        UID m_uid;
+        std::vector<std::byte> m_bytes;
+    };
+
+
     class SecurityProvider {
     public:
-        SecurityProvider(UID uid, std::initializer_list<Table> tables);
+        SecurityProvider(UID uid, std::initializer_list<Table> tables, std::initializer_list<ByteTable> byteTables = {});
 
         bool contains(UID table) const;
         Table& operator[](UID table);
         const Table& operator[](UID table) const;
+        bool HasByteTable(UID table) const;
+        ByteTable& GetByteTable(UID table);
+        const ByteTable& GetByteTable(UID table) const;
         UID GetUID() const;
 
     private:
         UID m_uid;
         std::unordered_map<UID, Table> m_tables;
+        std::unordered_map<UID, ByteTable> m_byteTables;
     };
 
 } // namespace mock
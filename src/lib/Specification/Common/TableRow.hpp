@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Messaging/Native.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+
+namespace sedmgr {
+
+namespace impl {
+
+    template <class Member>
+    struct RowMemberTraits;
+
+
+    template <class Row_, class T>
+    struct RowMemberTraits<std::optional<T> Row_::*> {
+        using Row = Row_;
+        using Type = T;
+    };
+
+} // namespace impl
+
+
+// Binds a field of a typed row to its column in the table. The name must match
+// the column's name in the TableDescs, which the tests check.
+template <auto Member, uint32_t Index>
+struct RowColumn {
+    using Row = typename impl::RowMemberTraits<decltype(Member)>::Row;
+    using Type = typename impl::RowMemberTraits<decltype(Member)>::Type;
+    static constexpr auto member = Member;
+    static constexpr uint32_t index = Index;
+    std::string_view name;
+};
+
+
+// A typed row has a std::optional field per column it maps, and lists them in
+// Columns(). Fields are only set for the columns that were fetched and present.
+template <class Row>
+concept TableRow = requires {
+    { Row::table };
+    { Row::Columns() };
+};
+
+
+template <TableRow Row, class T>
+constexpr uint32_t GetRowColumn(std::optional<T> Row::*field) {
+    std::optional<uint32_t> index;
+    const auto match = [&]<class Column>(const Column&) {
+        if constexpr (std::is_same_v<std::remove_cv_t<decltype(Column::member)>, decltype(field)>) {
+            if (Column::member == field) {
+                index = Column::index;
+            }
+        }
+    };
+    std::apply([&](const auto&... columns) { (match(columns), ...); }, Row::Columns());
+    if (!index) {
+        throw std::invalid_argument("field is not mapped to a column");
+    }
+    return *index;
+}
+
+
+// The column index of a field, e.g. ColumnOf<&LockingRow::readLocked>.
+template <auto Member>
+constexpr uint32_t ColumnOf = GetRowColumn(Member);
+
+
+// Sets the field from the column's value, or leaves it empty if the TPer did not
+// return the column.
+template <class T>
+void DecodeRowField(std::optional<T>& field, const Value& value) {
+    field = value.HasValue() ? std::optional<T>(value_cast<T>(value)) : std::nullopt;
+}
+
+} // namespace sedmgr
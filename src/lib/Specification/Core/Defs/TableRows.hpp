@@ -0,0 +1,111 @@
+#pragma once
+
+#include "../../Common/TableRow.hpp"
+#include "UIDs.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+
+
+namespace sedmgr {
+
+namespace core {
+
+    struct AuthorityRow {
+        static constexpr auto table = eTable::Authority;
+
+        std::optional<std::string> name;
+        std::optional<std::string> commonName;
+        std::optional<bool> isClass;
+        std::optional<UID> authorityClass;
+        std::optional<bool> enabled;
+        std::optional<UID> credential;
+        std::optional<uint32_t> limit;
+        std::optional<uint32_t> uses;
+
+        static constexpr auto Columns() {
+            return std::tuple{
+                RowColumn<&AuthorityRow::name, 1>{"Name"},
+                RowColumn<&AuthorityRow::commonName, 2>{ "CommonName" },
+                RowColumn<&AuthorityRow::isClass, 3>{ "IsClass" },
+                RowColumn<&AuthorityRow::authorityClass, 4>{ "Class" },
+                RowColumn<&AuthorityRow::enabled, 5>{ "Enabled" },
+                RowColumn<&AuthorityRow::credential, 10>{ "Credential" },
+                RowColumn<&AuthorityRow::limit, 15>{ "Limit" },
+                RowColumn<&AuthorityRow::uses, 16>{ "Uses" },
+            };
+        }
+    };
+
+
+    struct C_PINRow {
+        static constexpr auto table = eTable::C_PIN;
+
+        std::optional<std::string> name;
+        std::optional<std::string> commonName;
+        std::optional<uint32_t> tryLimit;
+        std::optional<uint32_t> tries;
+        std::optional<bool> persistence;
+
+        static constexpr auto Columns() {
+            return std::tuple{
+                RowColumn<&C_PINRow::name, 1>{"Name"},
+                RowColumn<&C_PINRow::commonName, 2>{ "CommonName" },
+                RowColumn<&C_PINRow::tryLimit, 5>{ "TryLimit" },
+                RowColumn<&C_PINRow::tries, 6>{ "Tries" },
+                RowColumn<&C_PINRow::persistence, 7>{ "Persistence" },
+            };
+        }
+    };
+
+
+    struct LockingRow {
+        static constexpr auto table = eTable::Locking;
+
+        std::optional<std::string> name;
+        std::optional<std::string> commonName;
+        std::optional<uint64_t> rangeStart;
+        std::optional<uint64_t> rangeLength;
+        std::optional<bool> readLockEnabled;
+        std::optional<bool> writeLockEnabled;
+        std::optional<bool> readLocked;
+        std::optional<bool> writeLocked;
+        std::optional<UID> activeKey;
+        std::optional<UID> nextKey;
+
+        static constexpr auto Columns() {
+            return std::tuple{
+                RowColumn<&LockingRow::name, 1>{"Name"},
+                RowColumn<&LockingRow::commonName, 2>{ "CommonName" },
+                RowColumn<&LockingRow::rangeStart, 3>{ "RangeStart" },
+                RowColumn<&LockingRow::rangeLength, 4>{ "RangeLength" },
+                RowColumn<&LockingRow::readLockEnabled, 5>{ "ReadLockEnabled" },
+                RowColumn<&LockingRow::writeLockEnabled, 6>{ "WriteLockEnabled" },
+                RowColumn<&LockingRow::readLocked, 7>{ "ReadLocked" },
+                RowColumn<&LockingRow::writeLocked, 8>{ "WriteLocked" },
+                RowColumn<&LockingRow::activeKey, 10>{ "ActiveKey" },
+                RowColumn<&LockingRow::nextKey, 11>{ "NextKey" },
+            };
+        }
+    };
+
+
+    struct MBRControlRow {
+        static constexpr auto table = eTable::MBRControl;
+
+        std::optional<bool> enable;
+        std::optional<bool> done;
+
+        static constexpr auto Columns() {
+            return std::tuple{
+                RowColumn<&MBRControlRow::enable, 1>{"Enable"},
+                RowColumn<&MBRControlRow::done, 2>{ "Done" },
+            };
+        }
+    };
+
+} // namespace core
+
+} // namespace sedmgr
@@ -0,0 +1,183 @@
+#include "DeviceLock.hpp"
+
+#include "LockFile.hpp"
+
+#include <Error/Exception.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+
+namespace sedmgr {
+
+namespace {
+
+class ScopedFileLock {
+public:
+    explicit ScopedFileLock(impl::LockFile& file) : m_file(file) { m_file.Lock(true); }
+    ScopedFileLock(const ScopedFileLock&) = delete;
+    ScopedFileLock& operator=(const ScopedFileLock&) = delete;
+    ~ScopedFileLock() { m_file.Unlock(); }
+
+private:
+    impl::LockFile& m_file;
+};
+
+} // namespace
+
+
+static std::string SanitizeFileName(std::string_view name) {
+    std::string result(name);
+    std::ranges::replace_if(result, [](char c) { return !std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_'; }, '_');
+    return result;
+}
+
+
+static void CreateLockDirectory(const std::filesystem::path& directory) {
+    std::error_code ec;
+    if (std::filesystem::create_directories(directory, ec)) {
+        // Only the owner may add lock files, others can't plant their own.
+        using enum std::filesystem::perms;
+        std::filesystem::permissions(directory, owner_all | group_read | group_exec | others_read | others_exec, ec);
+    }
+    if (!std::filesystem::is_directory(directory)) {
+        throw DeviceError(std::format("cannot create lock directory '{}'", directory.string()));
+    }
+}
+
+
+DeviceLock::DeviceLock(std::string_view serial, std::filesystem::path directory) {
+    static std::atomic_uint64_t nextId = 0;
+
+    if (serial.empty()) {
+        throw std::invalid_argument("device lock needs a serial number");
+    }
+    CreateLockDirectory(directory);
+    const auto name = SanitizeFileName(serial);
+    m_queuePath = directory / (name + ".queue");
+    m_queueFile = std::make_unique<impl::LockFile>(m_queuePath);
+    m_deviceFile = std::make_unique<impl::LockFile>(directory / (name + ".lock"));
+    m_waiter = { impl::GetProcessId(), nextId.fetch_add(1) };
+}
+
+
+DeviceLock::~DeviceLock() {
+    try {
+        Release();
+        Dequeue();
+    }
+    catch (std::exception&) {
+        // The entry is dropped by the other waiters once the process exits.
+    }
+}
+
+
+bool DeviceLock::TryAcquire() {
+    std::lock_guard lk(m_mutex);
+    if (m_held) {
+        return true;
+    }
+
+    const ScopedFileLock queueLock(*m_queueFile);
+    auto waiters = ReadQueue();
+    std::erase_if(waiters, [](const Waiter& waiter) { return !impl::IsProcessAlive(waiter.processId); });
+    if (std::ranges::find(waiters, m_waiter) == waiters.end()) {
+        waiters.push_back(m_waiter);
+    }
+    m_queued = true;
+    if (waiters.front() == m_waiter && m_deviceFile->Lock(false)) {
+        waiters.erase(waiters.begin());
+        m_queued = false;
+        m_held = true;
+    }
+    WriteQueue(waiters);
+    return m_held;
+}
+
+
+void DeviceLock::Acquire(std::optional<std::chrono::nanoseconds> timeout) {
+    using namespace std::chrono_literals;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::chrono::milliseconds delay = 1ms;
+    while (!TryAcquire()) {
+        if (timeout && std::chrono::steady_clock::now() - start > *timeout) {
+            Dequeue();
+            throw DeviceError(std::format("timed out waiting for the device lock '{}'", m_queuePath.stem().string()));
+        }
+        std::this_thread::sleep_for(delay);
+        delay = std::min<std::chrono::milliseconds>(delay * 2, 50ms);
+    }
+}
+
+
+void DeviceLock::Release() {
+    std::lock_guard lk(m_mutex);
+    if (m_held) {
+        m_deviceFile->Unlock();
+        m_held = false;
+    }
+}
+
+
+bool DeviceLock::IsHeld() const {
+    std::lock_guard lk(m_mutex);
+    return m_held;
+}
+
+
+std::filesystem::path DeviceLock::DefaultDirectory() {
+    if (const auto directory = std::getenv("SEDMANAGER_LOCK_DIR"); directory && *directory) {
+        return directory;
+    }
+#ifdef _WIN32
+    if (const auto programData = std::getenv("PROGRAMDATA"); programData && *programData) {
+        return std::filesystem::path(programData) / "SEDManager" / "locks";
+    }
+#elif defined(__linux__)
+    if (std::filesystem::is_directory("/run/lock")) {
+        return "/run/lock/sedmanager";
+    }
+#endif
+    return std::filesystem::temp_directory_path() / "sedmanager-locks";
+}
+
+
+auto DeviceLock::ReadQueue() const -> std::vector<Waiter> {
+    std::vector<Waiter> waiters;
+    std::ifstream file(m_queuePath);
+    Waiter waiter;
+    while (file >> waiter.processId >> waiter.id) {
+        waiters.push_back(waiter);
+    }
+    return waiters;
+}
+
+
+void DeviceLock::WriteQueue(const std::vector<Waiter>& waiters) const {
+    std::ofstream file(m_queuePath, std::ios::out | std::ios::trunc);
+    for (const auto& waiter : waiters) {
+        file << waiter.processId << ' ' << waiter.id << '\n';
+    }
+}
+
+
+void DeviceLock::Dequeue() {
+    std::lock_guard lk(m_mutex);
+    if (!m_queued) {
+        return;
+    }
+    const ScopedFileLock queueLock(*m_queueFile);
+    auto waiters = ReadQueue();
+    std::erase(waiters, m_waiter);
+    WriteQueue(waiters);
+    m_queued = false;
+}
+
+} // namespace sedmgr
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+
+namespace sedmgr {
+
+namespace impl {
+    class LockFile;
+}
+
+
+// An advisory lock on a drive that all processes using this library respect,
+// so that they take turns on its ComID instead of ending up with SP_BUSY or
+// resetting each other's sessions. Waiters are served in the order they arrived.
+// The lock and the queued waiters of a crashed process are dropped automatically.
+// The lock files must belong to the current user, which is usually root for raw
+// access to the drive.
+class DeviceLock {
+public:
+    explicit DeviceLock(std::string_view serial, std::filesystem::path directory = DefaultDirectory());
+    DeviceLock(const DeviceLock&) = delete;
+    DeviceLock& operator=(const DeviceLock&) = delete;
+    ~DeviceLock();
+
+    // Queues up on the first call. Takes the lock when it's this waiter's turn
+    // and the previous holder has released it. Never blocks.
+    bool TryAcquire();
+    // Throws DeviceError when the lock can't be taken within the timeout.
+    void Acquire(std::optional<std::chrono::nanoseconds> timeout = {});
+    void Release();
+    bool IsHeld() const;
+
+    // $SEDMANAGER_LOCK_DIR if set, a system-wide directory otherwise.
+    static std::filesystem::path DefaultDirectory();
+
+private:
+    struct Waiter {
+        uint64_t processId;
+        uint64_t id;
+        bool operator==(const Waiter&) const = default;
+    };
+
+    std::vector<Waiter> ReadQueue() const;
+    void WriteQueue(const std::vector<Waiter>& waiters) const;
+    void Dequeue();
+
+private:
+    std::filesystem::path m_queuePath;
+    std::unique_ptr<impl::LockFile> m_queueFile;
+    std::unique_ptr<impl::LockFile> m_deviceFile;
+    Waiter m_waiter;
+    bool m_queued = false;
+    bool m_held = false;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace sedmgr
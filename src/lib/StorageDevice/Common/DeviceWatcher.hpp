@@ -0,0 +1,34 @@
+#pragma once
+
+#include "StorageDevice.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+
+namespace sedmgr {
+
+// Reports storage devices as their nodes appear in a device directory. That's
+// /dev normally, but tests can point it at a temporary directory. Only nodes
+// that appear after the watcher is created are reported.
+class DeviceWatcher {
+public:
+    explicit DeviceWatcher(std::filesystem::path directory = "/dev");
+    DeviceWatcher(const DeviceWatcher&) = delete;
+    DeviceWatcher& operator=(const DeviceWatcher&) = delete;
+    ~DeviceWatcher();
+
+    // Returns the devices that appeared since the last call, waiting for the
+    // first one up to the timeout. Returns nothing if the timeout expires.
+    std::vector<StorageDeviceLabel> Wait(std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+    const std::filesystem::path& GetDirectory() const;
+
+private:
+    std::filesystem::path m_directory;
+    intptr_t m_handle = -1;
+};
+
+} // namespace sedmgr
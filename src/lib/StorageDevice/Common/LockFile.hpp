@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+
+namespace sedmgr {
+
+namespace impl {
+
+    // An exclusive advisory lock on a file, released by the OS when the process
+    // dies. Implemented per platform.
+    class LockFile {
+    public:
+        explicit LockFile(const std::filesystem::path& path);
+        LockFile(const LockFile&) = delete;
+        LockFile& operator=(const LockFile&) = delete;
+        ~LockFile();
+
+        bool Lock(bool wait);
+        void Unlock();
+
+    private:
+        intptr_t m_handle;
+    };
+
+
+    uint64_t GetProcessId();
+    bool IsProcessAlive(uint64_t processId);
+
+} // namespace impl
+
+} // namespace sedmgr
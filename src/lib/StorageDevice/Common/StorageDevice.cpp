@@ -0,0 +1,19 @@
+#include "StorageDevice.hpp"
+
+#include "../NvmeDevice.hpp"
+
+#include <Error/Exception.hpp>
+
+#include <format>
+
+
+namespace sedmgr {
+
+std::shared_ptr<StorageDevice> OpenStorageDevice(const StorageDeviceLabel& label) {
+    if (label.interface == eStorageDeviceInterface::NVME) {
+        return std::make_shared<NvmeDevice>(label.path);
+    }
+    throw NotImplementedError(std::format("opening '{}': only NVMe devices are supported", label.path));
+}
+
+} // namespace sedmgr
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <filesystem>
+#include <memory>
 #include <span>
 #include <string>
 #include <string_view>
@@ -34,7 +36,28 @@ struct StorageDeviceDesc {
 };
 
 
+struct StorageNamespaceDesc {
+    std::string path;
+    uint64_t size = 0;
+};
+
+
+struct StorageDeviceInfo {
+    StorageDeviceLabel label;
+    StorageDeviceDesc desc;
+    std::vector<StorageNamespaceDesc> namespaces;
+};
+
+
+class StorageDevice;
+
+
 std::vector<StorageDeviceLabel> EnumerateStorageDevices();
+// Lists the devices along with their descriptions. On Linux, that comes from
+// sysfs under the given root, without opening the devices. Elsewhere, the
+// devices are opened and identified, and the root is ignored.
+std::vector<StorageDeviceInfo> EnumerateStorageDeviceInfo(const std::filesystem::path& sysfsRoot = "/sys");
+std::shared_ptr<StorageDevice> OpenStorageDevice(const StorageDeviceLabel& label);
 
 
 class StorageDevice {
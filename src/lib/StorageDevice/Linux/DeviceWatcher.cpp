@@ -0,0 +1,94 @@
+#include "../Common/DeviceWatcher.hpp"
+
+#include <Error/Exception.hpp>
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <array>
+#include <format>
+#include <regex>
+#include <string>
+
+
+namespace sedmgr {
+
+DeviceWatcher::DeviceWatcher(std::filesystem::path directory)
+    : m_directory(std::move(directory)) {
+    const auto fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd < 0) {
+        throw DeviceError{
+            std::format("cannot watch '{}': {}", m_directory.string(), strerror(errno))
+        };
+    }
+    if (inotify_add_watch(fd, m_directory.c_str(), IN_CREATE | IN_MOVED_TO) < 0) {
+        const auto error = errno;
+        close(fd);
+        throw DeviceError{
+            std::format("cannot watch '{}': {}", m_directory.string(), strerror(error))
+        };
+    }
+    m_handle = fd;
+}
+
+
+DeviceWatcher::~DeviceWatcher() {
+    close(int(m_handle));
+}
+
+
+std::vector<StorageDeviceLabel> DeviceWatcher::Wait(std::optional<std::chrono::milliseconds> timeout) {
+    static const auto nvmePattern = std::regex("nvme[0-9]+");
+
+    // Nodes other than NVMe controllers, like partitions, wake up the poll as
+    // well, so it's repeated until a controller shows up or the time is up.
+    const auto deadline = timeout ? std::optional(std::chrono::steady_clock::now() + *timeout) : std::nullopt;
+    std::vector<StorageDeviceLabel> devices;
+    while (devices.empty()) {
+        int pollTimeout = -1;
+        if (deadline) {
+            const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0) {
+                break;
+            }
+            pollTimeout = int(remaining.count());
+        }
+        pollfd pollFd = { .fd = int(m_handle), .events = POLLIN, .revents = 0 };
+        const auto ready = poll(&pollFd, 1, pollTimeout);
+        if (ready < 0 && errno != EINTR) {
+            throw DeviceError{
+                std::format("cannot watch '{}': {}", m_directory.string(), strerror(errno))
+            };
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        alignas(inotify_event) std::array<char, 4096> buffer;
+        ssize_t length;
+        while ((length = read(int(m_handle), buffer.data(), buffer.size())) > 0) {
+            for (ssize_t offset = 0; offset < length;) {
+                const auto event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+                offset += sizeof(inotify_event) + event->len;
+                if (event->len == 0 || (event->mask & IN_ISDIR)) {
+                    continue;
+                }
+                const std::string name = event->name;
+                if (std::regex_match(name, nvmePattern)) {
+                    devices.emplace_back((m_directory / name).string(), eStorageDeviceInterface::NVME);
+                }
+            }
+        }
+    }
+    return devices;
+}
+
+
+const std::filesystem::path& DeviceWatcher::GetDirectory() const {
+    return m_directory;
+}
+
+} // namespace sedmgr
@@ -1,15 +1,114 @@
 #include "../Common/StorageDevice.hpp"
 
 #include <algorithm>
+#include <charconv>
 #include <filesystem>
+#include <fstream>
 #include <ranges>
 #include <regex>
 
 
 namespace sedmgr {
 
+namespace fs = std::filesystem;
+
+
+static std::string ReadAttribute(const fs::path& path) {
+    std::ifstream file(path);
+    std::string value;
+    std::getline(file, value);
+    const auto first = value.find_first_not_of(" \t");
+    const auto last = value.find_last_not_of(" \t\r\n");
+    return first == std::string::npos ? std::string{} : value.substr(first, last - first + 1);
+}
+
+
+// Sorts nvme2 before nvme10.
+static bool NaturalLess(std::string_view lhs, std::string_view rhs) {
+    return lhs.size() != rhs.size() ? lhs.size() < rhs.size() : lhs < rhs;
+}
+
+
+// Reads the size attribute, which counts 512-byte sectors whatever the LBA
+// format. A missing or malformed attribute gives 0.
+static uint64_t ReadSize(const fs::path& path) {
+    const auto sectors = ReadAttribute(path);
+    uint64_t value = 0;
+    const auto [ptr, ec] = std::from_chars(sectors.data(), sectors.data() + sectors.size(), value);
+    if (ec != std::errc{} || ptr != sectors.data() + sectors.size()) {
+        return 0;
+    }
+    return value * 512;
+}
+
+
+static std::vector<StorageNamespaceDesc> EnumerateNamespaces(const fs::path& controllerDir) {
+    // With native multipath, the controller lists its path to the namespace,
+    // like nvme0c0n1, while the block device is the shared head, nvme0n1.
+    static const auto namePattern = std::regex("(nvme[0-9]+)(?:c[0-9]+)?(n[0-9]+)");
+
+    std::vector<std::pair<std::string, std::string>> names;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(controllerDir, ec)) {
+        const auto name = entry.path().filename().string();
+        std::smatch match;
+        if (std::regex_match(name, match, namePattern)) {
+            names.emplace_back(match[1].str() + match[2].str(), name);
+        }
+    }
+    std::ranges::sort(names, NaturalLess, [](const auto& item) -> std::string_view { return item.first; });
+
+    std::vector<StorageNamespaceDesc> namespaces;
+    for (const auto& [deviceName, name] : names) {
+        namespaces.push_back({
+            .path = (fs::path("/dev") / deviceName).string(),
+            .size = ReadSize(controllerDir / name / "size"),
+        });
+    }
+    return namespaces;
+}
+
+
+std::vector<StorageDeviceInfo> EnumerateStorageDeviceInfo(const fs::path& sysfsRoot) {
+    static const auto namePattern = std::regex("nvme[0-9]+");
+
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(sysfsRoot / "class" / "nvme", ec)) {
+        const auto name = entry.path().filename().string();
+        if (std::regex_match(name, namePattern)) {
+            names.push_back(name);
+        }
+    }
+    std::ranges::sort(names, NaturalLess);
+
+    std::vector<StorageDeviceInfo> devices;
+    for (const auto& name : names) {
+        const auto controllerDir = sysfsRoot / "class" / "nvme" / name;
+        devices.push_back({
+            .label = { (fs::path("/dev") / name).string(), eStorageDeviceInterface::NVME },
+            .desc = {
+                .name = ReadAttribute(controllerDir / "model"),
+                .serial = ReadAttribute(controllerDir / "serial"),
+                .firmware = ReadAttribute(controllerDir / "firmware_rev"),
+                .interface = eStorageDeviceInterface::NVME,
+            },
+            .namespaces = EnumerateNamespaces(controllerDir),
+        });
+    }
+    return devices;
+}
+
+
 std::vector<StorageDeviceLabel> EnumerateStorageDevices() {
-    namespace fs = std::filesystem;
+    // Without sysfs, like in some containers, the device nodes are listed instead.
+    if (fs::exists("/sys/class/nvme")) {
+        std::vector<StorageDeviceLabel> devices;
+        for (auto& info : EnumerateStorageDeviceInfo()) {
+            devices.push_back(std::move(info.label));
+        }
+        return devices;
+    }
 
     const auto isNvme = [](const fs::directory_entry& file) {
         const auto name = file.path().filename().string();
@@ -29,4 +128,4 @@ std::vector<StorageDeviceLabel> EnumerateStorageDevices() {
     return devices;
 }
 
-} // namespace sedmgr
\ No newline at end of file
+} // namespace sedmgr
@@ -0,0 +1,74 @@
+#include "../Common/LockFile.hpp"
+
+#include <Error/Exception.hpp>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <format>
+
+
+namespace sedmgr {
+
+namespace impl {
+
+    LockFile::LockFile(const std::filesystem::path& path) {
+        const auto fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0644);
+        if (fd < 0) {
+            throw DeviceError{
+                std::format("cannot open lock file '{}': {}", path.string(), strerror(errno))
+            };
+        }
+        // Anyone who can write the file could also fake the queue, so it must be
+        // a file of our own and not one planted by another user.
+        struct stat status;
+        if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode) || status.st_uid != geteuid()) {
+            close(fd);
+            throw DeviceError{
+                std::format("lock file '{}' is not a regular file owned by the current user", path.string())
+            };
+        }
+        m_handle = fd;
+    }
+
+
+    LockFile::~LockFile() {
+        close(int(m_handle));
+    }
+
+
+    bool LockFile::Lock(bool wait) {
+        while (flock(int(m_handle), LOCK_EX | (wait ? 0 : LOCK_NB)) != 0) {
+            if (errno == EWOULDBLOCK) {
+                return false;
+            }
+            if (errno != EINTR) {
+                throw DeviceError{ std::format("cannot lock file: {}", strerror(errno)) };
+            }
+        }
+        return true;
+    }
+
+
+    void LockFile::Unlock() {
+        flock(int(m_handle), LOCK_UN);
+    }
+
+
+    uint64_t GetProcessId() {
+        return uint64_t(getpid());
+    }
+
+
+    bool IsProcessAlive(uint64_t processId) {
+        return kill(pid_t(processId), 0) == 0 || errno == EPERM;
+    }
+
+} // namespace impl
+
+} // namespace sedmgr
@@ -0,0 +1,28 @@
+#include "../Common/DeviceWatcher.hpp"
+
+#include <Error/Exception.hpp>
+
+
+namespace sedmgr {
+
+// Windows doesn't expose drives as nodes in a directory. Device arrival would
+// need RegisterDeviceNotification instead, which isn't done yet.
+DeviceWatcher::DeviceWatcher(std::filesystem::path directory)
+    : m_directory(std::move(directory)) {
+    throw NotImplementedError("watching for new devices");
+}
+
+
+DeviceWatcher::~DeviceWatcher() {}
+
+
+std::vector<StorageDeviceLabel> DeviceWatcher::Wait(std::optional<std::chrono::milliseconds> timeout) {
+    throw NotImplementedError("watching for new devices");
+}
+
+
+const std::filesystem::path& DeviceWatcher::GetDirectory() const {
+    return m_directory;
+}
+
+} // namespace sedmgr
@@ -134,4 +134,22 @@ std::vector<StorageDeviceLabel> EnumerateStorageDevices() {
     return devices;
 }
 
-} // namespace sedmgr
\ No newline at end of file
+
+// There's no equivalent of sysfs, so the devices are opened and identified.
+// Devices that can't be opened are listed without a description.
+std::vector<StorageDeviceInfo> EnumerateStorageDeviceInfo(const std::filesystem::path& sysfsRoot) {
+    std::vector<StorageDeviceInfo> devices;
+    for (auto& label : EnumerateStorageDevices()) {
+        StorageDeviceDesc desc{ .interface = label.interface };
+        try {
+            desc = OpenStorageDevice(label)->GetDesc();
+        }
+        catch (std::exception&) {
+            // Leave the description empty.
+        }
+        devices.push_back({ .label = std::move(label), .desc = std::move(desc) });
+    }
+    return devices;
+}
+
+} // namespace sedmgr
@@ -0,0 +1,130 @@
+#include "../Common/LockFile.hpp"
+
+#include <Error/Exception.hpp>
+
+#include <Windows.h>
+#include <AclAPI.h>
+
+#include <format>
+#include <memory>
+#include <vector>
+
+
+namespace sedmgr {
+
+namespace impl {
+
+    // The locked byte is far past the end of the file, so that the lock doesn't
+    // get in the way of reading and writing the contents.
+    static OVERLAPPED LockedRegion() {
+        OVERLAPPED overlapped = {};
+        overlapped.OffsetHigh = 0x7FFF'FFFF;
+        return overlapped;
+    }
+
+
+    static std::vector<std::byte> GetTokenInfo(TOKEN_INFORMATION_CLASS infoClass) {
+        HANDLE token = nullptr;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) {
+            return {};
+        }
+        DWORD size = 0;
+        GetTokenInformation(token, infoClass, nullptr, 0, &size);
+        std::vector<std::byte> info(size);
+        if (!GetTokenInformation(token, infoClass, info.data(), size, &size)) {
+            info.clear();
+        }
+        CloseHandle(token);
+        return info;
+    }
+
+
+    // New files are owned by the token's default owner, which is the
+    // Administrators group rather than the user when running elevated.
+    static bool IsOwnedByCurrentUser(HANDLE handle) {
+        PSID owner = nullptr;
+        PSECURITY_DESCRIPTOR descriptor = nullptr;
+        if (GetSecurityInfo(handle, SE_FILE_OBJECT, OWNER_SECURITY_INFORMATION, &owner, nullptr, nullptr, nullptr, &descriptor) != ERROR_SUCCESS) {
+            return false;
+        }
+        const std::unique_ptr<void, decltype(&LocalFree)> descriptorGuard(descriptor, &LocalFree);
+        const auto user = GetTokenInfo(TokenUser);
+        const auto defaultOwner = GetTokenInfo(TokenOwner);
+        return (!user.empty() && EqualSid(owner, reinterpret_cast<const TOKEN_USER*>(user.data())->User.Sid))
+               || (!defaultOwner.empty() && EqualSid(owner, reinterpret_cast<const TOKEN_OWNER*>(defaultOwner.data())->Owner));
+    }
+
+
+    LockFile::LockFile(const std::filesystem::path& path) {
+        const auto handle = CreateFileW(path.c_str(),
+                                        GENERIC_READ | GENERIC_WRITE,
+                                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                        nullptr,
+                                        OPEN_ALWAYS,
+                                        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OPEN_REPARSE_POINT,
+                                        nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            throw DeviceError{
+                std::format("cannot open lock file '{}': {}", path.string(), GetLastError())
+            };
+        }
+        // Anyone who can write the file could also fake the queue, so it must be
+        // a file of our own and not a link or one planted by another user.
+        BY_HANDLE_FILE_INFORMATION info;
+        if (!GetFileInformationByHandle(handle, &info)
+            || (info.dwFileAttributes & (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_REPARSE_POINT)) != 0
+            || GetFileType(handle) != FILE_TYPE_DISK
+            || !IsOwnedByCurrentUser(handle)) {
+            CloseHandle(handle);
+            throw DeviceError{
+                std::format("lock file '{}' is not a regular file owned by the current user", path.string())
+            };
+        }
+        m_handle = reinterpret_cast<intptr_t>(handle);
+    }
+
+
+    LockFile::~LockFile() {
+        CloseHandle(reinterpret_cast<HANDLE>(m_handle));
+    }
+
+
+    bool LockFile::Lock(bool wait) {
+        auto overlapped = LockedRegion();
+        const DWORD flags = LOCKFILE_EXCLUSIVE_LOCK | (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY);
+        if (!LockFileEx(reinterpret_cast<HANDLE>(m_handle), flags, 0, 1, 0, &overlapped)) {
+            const auto error = GetLastError();
+            if (error == ERROR_LOCK_VIOLATION) {
+                return false;
+            }
+            throw DeviceError{ std::format("cannot lock file: {}", error) };
+        }
+        return true;
+    }
+
+
+    void LockFile::Unlock() {
+        auto overlapped = LockedRegion();
+        UnlockFileEx(reinterpret_cast<HANDLE>(m_handle), 0, 1, 0, &overlapped);
+    }
+
+
+    uint64_t GetProcessId() {
+        return uint64_t(GetCurrentProcessId());
+    }
+
+
+    bool IsProcessAlive(uint64_t processId) {
+        const auto process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, DWORD(processId));
+        if (!process) {
+            return GetLastError() == ERROR_ACCESS_DENIED;
+        }
+        DWORD exitCode = 0;
+        const bool alive = GetExitCodeProcess(process, &exitCode) && exitCode == STILL_ACTIVE;
+        CloseHandle(process);
+        return alive;
+    }
+
+} // namespace impl
+
+} // namespace sedmgr
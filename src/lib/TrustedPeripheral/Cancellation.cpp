@@ -0,0 +1,72 @@
+#include "Cancellation.hpp"
+
+#include <Error/Exception.hpp>
+
+#include <algorithm>
+
+
+namespace sedmgr {
+
+CancellationToken::CancellationToken(std::optional<Clock::time_point> deadline)
+    : m_state(std::make_shared<State>()) {
+    m_state->deadline = deadline;
+}
+
+
+CancellationToken CancellationToken::Manual() {
+    return CancellationToken(std::nullopt);
+}
+
+
+CancellationToken CancellationToken::After(std::chrono::nanoseconds timeout) {
+    return CancellationToken(Clock::now() + std::chrono::duration_cast<Clock::duration>(timeout));
+}
+
+
+CancellationToken CancellationToken::At(Clock::time_point deadline) {
+    return CancellationToken(deadline);
+}
+
+
+void CancellationToken::Cancel() const {
+    if (m_state) {
+        m_state->cancelled.store(true, std::memory_order_relaxed);
+    }
+}
+
+
+bool CancellationToken::IsCancelled() const {
+    if (!m_state) {
+        return false;
+    }
+    return m_state->cancelled.load(std::memory_order_relaxed)
+           || (m_state->deadline && Clock::now() >= *m_state->deadline);
+}
+
+
+void CancellationToken::ThrowIfCancelled() const {
+    if (!m_state) {
+        return;
+    }
+    if (m_state->cancelled.load(std::memory_order_relaxed)) {
+        throw CancelledError("cancelled by caller");
+    }
+    if (m_state->deadline && Clock::now() >= *m_state->deadline) {
+        throw CancelledError("deadline exceeded");
+    }
+}
+
+
+auto CancellationToken::GetDeadline() const -> std::optional<Clock::time_point> {
+    return m_state ? m_state->deadline : std::nullopt;
+}
+
+
+std::chrono::nanoseconds CancellationToken::Remaining() const {
+    if (!m_state || !m_state->deadline) {
+        return std::chrono::nanoseconds::max();
+    }
+    return std::max(std::chrono::nanoseconds(*m_state->deadline - Clock::now()), std::chrono::nanoseconds(0));
+}
+
+} // namespace sedmgr
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+
+
+namespace sedmgr {
+
+// Bounds an operation by a deadline, by an explicit Cancel, or both. Copies
+// share their state, so one token can be handed to many sessions and cancelled
+// from anywhere. A default-constructed token never expires.
+class CancellationToken {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CancellationToken() = default;
+    static CancellationToken Manual();
+    static CancellationToken After(std::chrono::nanoseconds timeout);
+    static CancellationToken At(Clock::time_point deadline);
+
+    void Cancel() const;
+    bool IsCancelled() const;
+    void ThrowIfCancelled() const;
+    std::optional<Clock::time_point> GetDeadline() const;
+    std::chrono::nanoseconds Remaining() const;
+
+private:
+    struct State {
+        std::optional<Clock::time_point> deadline;
+        std::atomic_bool cancelled = false;
+    };
+
+    explicit CancellationToken(std::optional<Clock::time_point> deadline);
+
+private:
+    std::shared_ptr<State> m_state;
+};
+
+} // namespace sedmgr
@@ -46,10 +46,14 @@ TPerDesc ParseTPerDesc(std::span<const std::byte> bytes) {
             const auto desc = DeSerialize(Serialized<TPerFeatureDesc>{ featurePayloadBytes });
             tperDesc.tperDesc = desc;
         }
-        if (featureHeader.featureCode == LockingFeatureDesc::featureCode) {
+        else if (featureHeader.featureCode == LockingFeatureDesc::featureCode) {
             const auto desc = DeSerialize(Serialized<LockingFeatureDesc>{ featurePayloadBytes });
             tperDesc.lockingDesc = desc;
         }
+        else if (featureHeader.featureCode == GeometryFeatureDesc::featureCode) {
+            const auto desc = DeSerialize(Serialized<GeometryFeatureDesc>{ featurePayloadBytes });
+            tperDesc.geometryDesc = desc;
+        }
         else {
             std::optional<SSCFeatureDesc> sscFeatureDesc;
             ParseDesc(featurePayloadBytes, featureHeader.featureCode, sscFeatureDesc);
@@ -54,6 +54,16 @@ struct LockingFeatureDesc {
 };
 
 
+struct GeometryFeatureDesc {
+    static constexpr uint16_t featureCode = 0x0003;
+
+    bool alignmentRequired;
+    uint32_t logicalBlockSize;
+    uint64_t alignmentGranularity;
+    uint64_t lowestAlignedLba;
+};
+
+
 //------------------------------------------------------------------------------
 // SSC features
 //------------------------------------------------------------------------------
@@ -148,6 +158,7 @@ using SSCFeatureDesc = std::variant<
 struct TPerDesc {
     std::optional<TPerFeatureDesc> tperDesc;
     std::optional<LockingFeatureDesc> lockingDesc;
+    std::optional<GeometryFeatureDesc> geometryDesc;
     std::vector<SSCFeatureDesc> sscDescs;
 };
 
@@ -225,6 +236,21 @@ void load(Archive& ar, LockingFeatureDesc& obj) {
 }
 
 
+template <class Archive>
+void load(Archive& ar, GeometryFeatureDesc& obj) {
+    uint8_t bits = uint8_t(obj.alignmentRequired);
+    std::array<uint8_t, 11 - 4> reserved;
+
+    ar(bits);
+    ar(reserved);
+    ar(obj.logicalBlockSize);
+    ar(obj.alignmentGranularity);
+    ar(obj.lowestAlignedLba);
+
+    obj.alignmentRequired = bool(bits & 1);
+}
+
+
 template <class Archive, std::derived_from<BasicSSCFeatureDesc> ConcreteSSCFeatureDesc>
 void load(Archive& ar, ConcreteSSCFeatureDesc& obj) {
     // Always present
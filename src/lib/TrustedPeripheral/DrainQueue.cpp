@@ -0,0 +1,158 @@
+#include "DrainQueue.hpp"
+
+#include <asyncpp/join.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+
+namespace sedmgr {
+
+//------------------------------------------------------------------------------
+// Background worker
+//------------------------------------------------------------------------------
+
+class DrainWorker {
+public:
+    void Schedule(std::shared_ptr<DrainQueue> queue) {
+        {
+            std::lock_guard lk(m_mutex);
+            m_queues.push_back(std::move(queue));
+            if (!m_thread.joinable()) {
+                m_thread = std::jthread([this](std::stop_token token) { Run(token); });
+            }
+        }
+        m_cv.notify_one();
+    }
+
+private:
+    void Run(std::stop_token token) {
+        std::unique_lock lk(m_mutex);
+        while (true) {
+            // On stop, the remaining queues are still drained before exiting.
+            m_cv.wait(lk, token, [this] { return !m_queues.empty(); });
+            if (m_queues.empty()) {
+                return;
+            }
+            auto queue = std::move(m_queues.front());
+            m_queues.pop_front();
+            lk.unlock();
+            join(queue->Run());
+            queue = nullptr;
+            lk.lock();
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable_any m_cv;
+    std::deque<std::shared_ptr<DrainQueue>> m_queues;
+    std::jthread m_thread;
+};
+
+
+static DrainWorker& GetDrainWorker() {
+    static DrainWorker worker;
+    return worker;
+}
+
+
+static void ReportFailure(const std::exception& ex) {
+    std::cerr << "background teardown failed: " << ex.what() << std::endl;
+}
+
+
+//------------------------------------------------------------------------------
+// Drain queue
+//------------------------------------------------------------------------------
+
+std::shared_ptr<DrainQueue> DrainQueue::ForDevice(const StorageDevice& device) {
+    static std::mutex mutex;
+    static std::unordered_map<const StorageDevice*, std::weak_ptr<DrainQueue>> queues;
+
+    std::lock_guard lk(mutex);
+    std::erase_if(queues, [](const auto& item) { return item.second.expired(); });
+    auto& entry = queues[&device];
+    auto queue = entry.lock();
+    if (!queue) {
+        queue = std::make_shared<DrainQueue>();
+        entry = queue;
+    }
+    return queue;
+}
+
+
+void DrainQueue::Post(Job job) {
+    bool schedule;
+    {
+        std::lock_guard lk(m_mutex);
+        m_jobs.push_back(std::move(job));
+        schedule = !std::exchange(m_scheduled, true);
+    }
+    if (schedule) {
+        GetDrainWorker().Schedule(shared_from_this());
+    }
+}
+
+
+size_t DrainQueue::Pending() const {
+    std::lock_guard lk(m_mutex);
+    return m_jobs.size() + (m_running ? 1 : 0);
+}
+
+
+asyncpp::task<void> DrainQueue::Flush() {
+    {
+        std::lock_guard lk(m_mutex);
+        if (m_jobs.empty() && !m_running) {
+            co_return;
+        }
+    }
+    // The job the worker is running finishes first, the rest run here.
+    co_await RunJobs();
+}
+
+
+asyncpp::task<void> DrainQueue::Run() {
+    {
+        std::lock_guard lk(m_mutex);
+        m_scheduled = false;
+    }
+    // A flushing caller may have run the jobs meanwhile, then there's nothing left.
+    co_await RunJobs();
+}
+
+
+asyncpp::task<void> DrainQueue::RunJobs() {
+    asyncpp::unique_lock lk = co_await m_runner;
+    while (auto job = Take()) {
+        try {
+            co_await job();
+        }
+        catch (std::exception& ex) {
+            ReportFailure(ex);
+        }
+        // The job may hold the last reference to a TPer, whose destructor posts
+        // a stack reset. That must be queued before the next Take.
+        job = nullptr;
+    }
+}
+
+
+DrainQueue::Job DrainQueue::Take() {
+    std::lock_guard lk(m_mutex);
+    m_running = !m_jobs.empty();
+    if (!m_running) {
+        return nullptr;
+    }
+    auto job = std::move(m_jobs.front());
+    m_jobs.pop_front();
+    return job;
+}
+
+} // namespace sedmgr
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <asyncpp/mutex.hpp>
+#include <asyncpp/task.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+
+namespace sedmgr {
+
+class StorageDevice;
+
+
+// Runs teardown work, like ending sessions and resetting the stack, away from
+// the caller, so that destructors don't block on device round-trips. There is
+// one queue per storage device. Its jobs run in order on a process-wide worker
+// thread, which finishes all pending work before the program exits.
+class DrainQueue : public std::enable_shared_from_this<DrainQueue> {
+public:
+    using Job = std::function<asyncpp::task<void>()>;
+
+    static std::shared_ptr<DrainQueue> ForDevice(const StorageDevice& device);
+
+    void Post(Job job);
+    size_t Pending() const;
+
+    // Runs the pending jobs in the caller, after the job the worker may be
+    // running. Either way, one job runs at a time. Waiting suspends the caller
+    // instead of blocking its thread. Jobs must not flush their own queue, as
+    // they would wait for themselves.
+    asyncpp::task<void> Flush();
+
+private:
+    friend class DrainWorker;
+
+    asyncpp::task<void> Run();
+    asyncpp::task<void> RunJobs();
+    // Returns the next job, or marks the queue idle if there is none.
+    Job Take();
+
+private:
+    mutable std::mutex m_mutex;
+    // Held by whoever runs the jobs, the worker or a flushing caller.
+    asyncpp::mutex m_runner;
+    std::deque<Job> m_jobs;
+    bool m_running = false;
+    bool m_scheduled = false;
+};
+
+} // namespace sedmgr
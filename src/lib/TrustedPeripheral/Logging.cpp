@@ -1,70 +1,307 @@
 #include "Logging.hpp"
 
+#include <Archive/Serialization.hpp>
+#include <Messaging/ComPacket.hpp>
+#include <Messaging/TokenStream.hpp>
+#include <Messaging/Value.hpp>
+
+#include <bit>
+#include <condition_variable>
+#include <cstdint>
 #include <filesystem>
+#include <format>
 #include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
 
 
 namespace sedmgr {
 
-std::ofstream& GetLogFile() {
-    const auto path = std::filesystem::temp_directory_path() / "sedmgr.log";
-    static std::ofstream file;
-    if (!file.is_open()) {
-        file.open(path, std::ios::out | std::ios::trunc);
-    }
-    return file;
-}
-
-static bool logging =
+namespace impl {
+    std::atomic_bool tracingEnabled =
 #ifndef NDEBUG
-    true
+        true
 #else
-    false
+        false
 #endif
-    ;
+        ;
+}
+
+
+//------------------------------------------------------------------------------
+// Trace buffer
+//------------------------------------------------------------------------------
+
+TraceBuffer::TraceBuffer(size_t capacity)
+    : m_cells(std::make_unique<Cell[]>(std::bit_ceil(std::max(capacity, size_t(2))))),
+      m_mask(std::bit_ceil(std::max(capacity, size_t(2))) - 1) {
+    for (size_t i = 0; i <= m_mask; ++i) {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+
+bool TraceBuffer::Push(TraceEvent event) {
+    size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &m_cells[pos & m_mask];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto diff = intptr_t(sequence) - intptr_t(pos);
+        if (diff == 0) {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->event = std::move(event);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+
+std::optional<TraceEvent> TraceBuffer::Pop() {
+    size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &m_cells[pos & m_mask];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto diff = intptr_t(sequence) - intptr_t(pos + 1);
+        if (diff == 0) {
+            if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return std::nullopt;
+        }
+        else {
+            pos = m_dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+    auto event = std::exchange(cell->event, TraceEvent{});
+    cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+    return event;
+}
+
+
+size_t TraceBuffer::Capacity() const {
+    return m_mask + 1;
+}
+
+
+size_t TraceBuffer::Dropped() const {
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+
+//------------------------------------------------------------------------------
+// Global trace & file sink
+//------------------------------------------------------------------------------
+
+class TraceWriter {
+public:
+    TraceWriter(TraceBuffer& buffer, std::ofstream file)
+        : m_buffer(buffer),
+          m_file(std::move(file)),
+          m_thread([this](std::stop_token token) { Run(token); }) {}
+
+private:
+    void Run(std::stop_token token) {
+        using namespace std::chrono_literals;
+
+        std::mutex mtx;
+        std::condition_variable_any cv;
+        std::unique_lock lk(mtx);
+        do {
+            cv.wait_for(lk, token, 50ms, [] { return false; });
+            while (auto event = m_buffer.Pop()) {
+                m_file << FormatTraceEvent(*event) << "\n";
+            }
+            m_file.flush();
+        } while (!token.stop_requested());
+    }
+
+private:
+    TraceBuffer& m_buffer;
+    std::ofstream m_file;
+    std::jthread m_thread;
+};
+
 
-void SetLogging(bool enabled) {
-    logging = enabled;
+struct TraceContext {
+    TraceBuffer buffer{ 16384 };
+    std::mutex sinkMutex;
+    std::atomic_bool hasFileSink = false;
+    std::unique_ptr<TraceWriter> writer;
+};
+
+
+static TraceContext& GetTraceContext() {
+    static TraceContext context;
+    return context;
+}
+
+
+void SetTracing(bool enabled) {
+    impl::tracingEnabled.store(enabled, std::memory_order_relaxed);
+    if (!enabled) {
+        auto& context = GetTraceContext();
+        std::lock_guard lk(context.sinkMutex);
+        context.writer.reset();
+        context.hasFileSink.store(false, std::memory_order_relaxed);
+    }
+}
+
+
+void TraceToFile(const std::filesystem::path& file) {
+    std::ofstream stream(file, std::ios::out | std::ios::trunc);
+    if (!stream) {
+        throw std::runtime_error(std::format("failed to open trace file '{}'", file.string()));
+    }
+    auto& context = GetTraceContext();
+    {
+        std::lock_guard lk(context.sinkMutex);
+        context.writer.reset();
+        context.writer = std::make_unique<TraceWriter>(context.buffer, std::move(stream));
+        context.hasFileSink.store(true, std::memory_order_relaxed);
+    }
+    impl::tracingEnabled.store(true, std::memory_order_relaxed);
+}
+
+
+void Trace(TraceEvent event) {
+    auto& context = GetTraceContext();
+    event.timestamp = std::chrono::system_clock::now();
+    context.buffer.Push(std::move(event));
+}
+
+
+std::shared_ptr<const std::vector<std::byte>> TraceText(std::string_view text) {
+    const auto bytes = std::as_bytes(std::span(text));
+    return std::make_shared<const std::vector<std::byte>>(bytes.begin(), bytes.end());
+}
+
+
+std::vector<TraceEvent> DrainTrace(size_t maxCount) {
+    auto& context = GetTraceContext();
+    if (context.hasFileSink.load(std::memory_order_relaxed)) {
+        throw std::logic_error("trace events are being written to a file, they cannot be drained");
+    }
+    std::vector<TraceEvent> events;
+    while (events.size() < maxCount) {
+        auto event = context.buffer.Pop();
+        if (!event) {
+            break;
+        }
+        events.push_back(std::move(*event));
+    }
+    return events;
+}
+
+
+size_t GetDroppedTraceEvents() {
+    return GetTraceContext().buffer.Dropped();
 }
 
-void Log(std::string_view event, const ComPacket& request) {
-    if (logging) {
-        auto& file = GetLogFile();
-        file << "+--------------------------------------------------------------" << std::endl;
-        file << "| " << event << std::endl;
-        file << "| Logging packet is not supported yet." << std::endl;
-        file << "+--------------------------------------------------------------" << std::endl;
-        file.flush();
+
+//------------------------------------------------------------------------------
+// Formatting
+//------------------------------------------------------------------------------
+
+static std::string_view GetEventName(eTraceEvent id) {
+    switch (id) {
+        case eTraceEvent::IF_SEND: return "IF-SEND";
+        case eTraceEvent::IF_SEND_FAILED: return "IF-SEND FAILED";
+        case eTraceEvent::IF_RECV: return "IF-RECV";
+        case eTraceEvent::IF_RECV_FAILED: return "IF-RECV FAILED";
+        case eTraceEvent::PACKET_SENT: return "Host -> TPer >>";
+        case eTraceEvent::PACKET_RECEIVED: return "TPer -> Host <<";
+        case eTraceEvent::METHOD_CALL: return "Method call";
+        case eTraceEvent::METHOD_RESULT: return "Method result";
+        case eTraceEvent::METHOD_FAILED: return "Method failed";
+        case eTraceEvent::END_SESSION: return "End session";
+        case eTraceEvent::END_SESSION_FAILED: return "End session failed";
     }
+    return "<unknown event>";
 }
 
-void Log(std::string_view event, const Value& request) {
-    if (logging) {
-        auto& file = GetLogFile();
 
-        file << "+--------------------------------------------------------------" << std::endl;
-        file << "| " << event << std::endl;
-        file << "+--------------------------------------------------------------" << std::endl;
-        file << "\n";
+static std::string FormatPayloadText(const std::shared_ptr<const std::vector<std::byte>>& payload) {
+    if (!payload) {
+        return {};
+    }
+    return std::string(reinterpret_cast<const char*>(payload->data()), payload->size());
+}
 
-        file << Dump(request);
 
-        file << "\n";
-        file << "\n";
-        file.flush();
+static std::string FormatPayloadPacket(const std::shared_ptr<const std::vector<std::byte>>& payload) {
+    if (!payload) {
+        return {};
+    }
+    std::string out;
+    try {
+        const auto comPacket = DeSerialize(Serialized<ComPacket>{ *payload });
+        for (const auto& packet : comPacket.payload) {
+            out += std::format("\nPacket TSN={}, HSN={}\n", packet.tperSessionNumber, packet.hostSessionNumber);
+            for (const auto& subPacket : packet.payload) {
+                const auto stream = SurroundWithList(DeSerialize(Serialized<TokenStream>{ subPacket.payload }));
+                const Value value = DeTokenize(Tokenized<Value>{ stream.stream }).first;
+                out += Dump(value);
+                out += "\n";
+            }
+        }
     }
+    catch (std::exception& ex) {
+        out += std::format("\n<failed to decode packet: {}>\n", ex.what());
+        for (const auto byte : *payload) {
+            out += std::format("{:02x} ", uint8_t(byte));
+        }
+        out += "\n";
+    }
+    return out;
 }
 
-void Log(std::string_view event) {
-    if (logging) {
-        auto& file = GetLogFile();
 
-        file << "+--------------------------------------------------------------" << std::endl;
-        file << "| " << event << std::endl;
-        file << "+--------------------------------------------------------------" << std::endl;
-        file << "\n";
-        file.flush();
+std::string FormatTraceEvent(const TraceEvent& event,
+                             const std::function<std::optional<std::string>(UID)>& findName) {
+    const auto nameOf = [&findName](uint64_t uid) {
+        const auto name = findName ? findName(UID(uid)) : std::nullopt;
+        return name.value_or(UID(uid).ToString());
+    };
+    const auto header = std::format("[{}] {}", event.timestamp, GetEventName(event.id));
+
+    switch (event.id) {
+        case eTraceEvent::IF_SEND: [[fallthrough]];
+        case eTraceEvent::IF_RECV:
+            return std::format("{}: Protocol={}, ComID={}, payload: {} bytes", header, event.protocol, event.comId, event.arg0);
+        case eTraceEvent::IF_SEND_FAILED: [[fallthrough]];
+        case eTraceEvent::IF_RECV_FAILED:
+            return std::format("{}: Protocol={}, ComID={}, payload: {} bytes --- {}", header, event.protocol, event.comId, event.arg0, FormatPayloadText(event.payload));
+        case eTraceEvent::PACKET_SENT: [[fallthrough]];
+        case eTraceEvent::PACKET_RECEIVED:
+            return std::format("{} Protocol={}, ComID={}{}", header, event.protocol, event.comId, FormatPayloadPacket(event.payload));
+        case eTraceEvent::METHOD_CALL:
+            return std::format("{}: '{}' on {}", header, nameOf(event.arg1), nameOf(event.arg0));
+        case eTraceEvent::METHOD_RESULT:
+            return std::format("{}: '{}' status={}", header, nameOf(event.arg1), event.arg0);
+        case eTraceEvent::METHOD_FAILED:
+            return std::format("{}: '{}' --- {}", header, nameOf(event.arg1), FormatPayloadText(event.payload));
+        case eTraceEvent::END_SESSION:
+            return std::format("{}: TSN={}, HSN={}", header, event.arg0, event.arg1);
+        case eTraceEvent::END_SESSION_FAILED:
+            return std::format("{}: TSN={}, HSN={} --- {}", header, event.arg0, event.arg1, FormatPayloadText(event.payload));
     }
+    return header;
 }
 
-} // namespace sedmgr
\ No newline at end of file
+} // namespace sedmgr
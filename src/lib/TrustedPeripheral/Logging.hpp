@@ -1,14 +1,101 @@
 #pragma once
 
-#include <Messaging/ComPacket.hpp>
-#include <Messaging/Value.hpp>
+#include <Messaging/UID.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 
 namespace sedmgr {
 
-void SetLogging(bool enabled);
-void Log(std::string_view event, const ComPacket& request);
-void Log(std::string_view event, const Value& request);
-void Log(std::string_view event);
+enum class eTraceEvent : uint8_t {
+    IF_SEND,
+    IF_SEND_FAILED,
+    IF_RECV,
+    IF_RECV_FAILED,
+    PACKET_SENT,
+    PACKET_RECEIVED,
+    METHOD_CALL,
+    METHOD_RESULT,
+    METHOD_FAILED,
+    END_SESSION,
+    END_SESSION_FAILED,
+};
+
+
+// Events only hold integers and a shared, immutable payload so that recording
+// one is a handful of stores. Turning them into text is deferred to the reader.
+//   IF_SEND/IF_RECV:           arg0 = transfer length
+//   PACKET_SENT/RECEIVED:      payload = raw ComPacket bytes
+//   METHOD_CALL:               arg0 = invoking ID, arg1 = method ID
+//   METHOD_RESULT:             arg0 = status, arg1 = method ID
+//   END_SESSION:               arg0 = TSN, arg1 = HSN
+//   *_FAILED:                  payload = error message
+struct TraceEvent {
+    std::chrono::system_clock::time_point timestamp = {};
+    eTraceEvent id = eTraceEvent::IF_SEND;
+    uint8_t protocol = 0;
+    uint16_t comId = 0;
+    uint64_t arg0 = 0;
+    uint64_t arg1 = 0;
+    std::shared_ptr<const std::vector<std::byte>> payload = nullptr;
+};
+
+
+// Bounded multi-producer multi-consumer queue. Producers never block: when the
+// ring is full, the event is dropped and counted.
+class TraceBuffer {
+public:
+    explicit TraceBuffer(size_t capacity);
+
+    bool Push(TraceEvent event);
+    std::optional<TraceEvent> Pop();
+    size_t Capacity() const;
+    size_t Dropped() const;
+
+private:
+    struct Cell {
+        std::atomic_size_t sequence;
+        TraceEvent event;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    alignas(64) std::atomic_size_t m_enqueuePos = 0;
+    alignas(64) std::atomic_size_t m_dequeuePos = 0;
+    std::atomic_size_t m_dropped = 0;
+};
+
+
+namespace impl {
+    extern std::atomic_bool tracingEnabled;
+}
+
+
+inline bool IsTracing() noexcept {
+    return impl::tracingEnabled.load(std::memory_order_relaxed);
+}
+
+// Events stay in the global buffer until DrainTrace collects them. TraceToFile
+// enables tracing and hands them to a background writer instead, and DrainTrace
+// throws while it is attached. Disabling tracing detaches the writer.
+void SetTracing(bool enabled);
+void TraceToFile(const std::filesystem::path& file);
+void Trace(TraceEvent event);
+std::shared_ptr<const std::vector<std::byte>> TraceText(std::string_view text);
+
+std::vector<TraceEvent> DrainTrace(size_t maxCount = std::numeric_limits<size_t>::max());
+size_t GetDroppedTraceEvents();
+std::string FormatTraceEvent(const TraceEvent& event,
+                             const std::function<std::optional<std::string>(UID)>& findName = {});
 
-} // namespace sedmgr
\ No newline at end of file
+} // namespace sedmgr
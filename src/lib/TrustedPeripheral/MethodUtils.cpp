@@ -6,6 +6,8 @@
 #include <Error/Exception.hpp>
 #include <Messaging/TokenStream.hpp>
 
+#include <chrono>
+
 
 namespace sedmgr {
 
@@ -44,7 +46,8 @@ asyncpp::task<Value> SendPacketizedValue(std::shared_ptr<TrustedPeripheral> tper
                                          uint32_t tperSessionNumber,
                                          uint32_t hostSessionNumber,
                                          Value request,
-                                         bool isRequestList) {
+                                         bool isRequestList,
+                                         CancellationToken cancellation) {
     const auto comId = tper->GetComId();
     const auto comIdExt = tper->GetComIdExtension();
 
@@ -52,9 +55,8 @@ asyncpp::task<Value> SendPacketizedValue(std::shared_ptr<TrustedPeripheral> tper
     if (isRequestList) {
         requestStream = UnSurroundWithList(std::move(requestStream));
     }
-    const auto requestBytes = Serialize(requestStream);
-    const auto requestPacket = CreatePacket(requestBytes, comId, comIdExt, tperSessionNumber, hostSessionNumber);
-    const auto responsePacket = co_await tper->SendPacket(protocol, requestPacket);
+    auto requestPacket = CreatePacket(Serialize(requestStream), comId, comIdExt, tperSessionNumber, hostSessionNumber);
+    const auto responsePacket = co_await tper->SendPacket(protocol, std::move(requestPacket), std::move(cancellation));
     const auto responseBytes = UnwrapPacket(responsePacket);
     auto responseStream = DeSerialize(Serialized<TokenStream>{ responseBytes });
     if (isRequestList) {
@@ -66,26 +68,32 @@ asyncpp::task<Value> SendPacketizedValue(std::shared_ptr<TrustedPeripheral> tper
 }
 
 
+// A status other than SUCCESS is returned, not thrown. The caller decides
+// whether it's an error, see Method and TypedMethod.
 asyncpp::task<MethodResult> CallRemoteMethod(std::shared_ptr<TrustedPeripheral> tper,
                                              uint8_t protocol,
                                              uint32_t tperSessionNumber,
                                              uint32_t hostSessionNumber,
-                                             MethodCall call) {
-    const auto maybeMethodName = tper->GetModules().FindName(call.methodId);
-    const auto methodName = maybeMethodName.value_or(call.methodId.ToString());
-
-    const auto request = MethodCallToValue(call);
-    Log(std::format("Host -> TPer >> '{}' [Session]", methodName), request);
+                                             MethodCall call,
+                                             CancellationToken cancellation) {
+    auto request = MethodCallToValue(call);
+    if (IsTracing()) {
+        Trace({ .id = eTraceEvent::METHOD_CALL, .protocol = protocol, .arg0 = call.invokingId.value, .arg1 = call.methodId.value });
+    }
     try {
-        const Value response = co_await SendPacketizedValue(tper, protocol, tperSessionNumber, hostSessionNumber, request, true);
-        Log(std::format("TPer -> Host << '{}' [Session]", methodName), response);
-
+        const auto startTime = std::chrono::steady_clock::now();
+        const Value response = co_await SendPacketizedValue(tper, protocol, tperSessionNumber, hostSessionNumber, std::move(request), true, std::move(cancellation));
+        tper->GetMetrics()->RecordMethod(call.methodId, std::chrono::steady_clock::now() - startTime);
         MethodResult result = MethodResultFromValue(response);
-        MethodStatusToException(methodName, result.status);
+        if (IsTracing()) {
+            Trace({ .id = eTraceEvent::METHOD_RESULT, .protocol = protocol, .arg0 = uint64_t(result.status), .arg1 = call.methodId.value });
+        }
         co_return result;
     }
     catch (std::exception& ex) {
-        Log(std::format("TPer -> Host << '{}' [Session] --- {}", methodName, ex.what()));
+        if (IsTracing()) {
+            Trace({ .id = eTraceEvent::METHOD_FAILED, .protocol = protocol, .arg1 = call.methodId.value, .payload = TraceText(ex.what()) });
+        }
         throw;
     }
 }
@@ -95,22 +103,104 @@ asyncpp::task<MethodResult> CallRemoteSessionMethod(std::shared_ptr<TrustedPerip
                                                     uint8_t protocol,
                                                     uint32_t tperSessionNumber,
                                                     uint32_t hostSessionNumber,
-                                                    MethodCall call) {
-    const auto maybeMethodName = tper->GetModules().FindName(call.methodId);
-    const auto methodName = maybeMethodName.value_or(call.methodId.ToString());
-
-    const auto request = MethodCallToValue(call);
-    Log(std::format("Host -> TPer >> '{}' [SessionManager]", methodName), request);
+                                                    MethodCall call,
+                                                    CancellationToken cancellation) {
+    auto request = MethodCallToValue(call);
+    if (IsTracing()) {
+        Trace({ .id = eTraceEvent::METHOD_CALL, .protocol = protocol, .arg0 = call.invokingId.value, .arg1 = call.methodId.value });
+    }
     try {
-        const Value response = co_await SendPacketizedValue(tper, protocol, tperSessionNumber, hostSessionNumber, request, true);
-        Log(std::format("TPer -> Host << '{}' [SessionManager]", methodName), response);
-
+        const auto startTime = std::chrono::steady_clock::now();
+        const Value response = co_await SendPacketizedValue(tper, protocol, tperSessionNumber, hostSessionNumber, std::move(request), true, std::move(cancellation));
+        tper->GetMetrics()->RecordMethod(call.methodId, std::chrono::steady_clock::now() - startTime);
         MethodCall result = MethodCallFromValue(response);
-        MethodStatusToException(methodName, result.status);
+        if (IsTracing()) {
+            Trace({ .id = eTraceEvent::METHOD_RESULT, .protocol = protocol, .arg0 = uint64_t(result.status), .arg1 = call.methodId.value });
+        }
         co_return { std::move(result.args), result.status };
     }
     catch (std::exception& ex) {
-        Log(std::format("TPer -> Host << '{}' [SessionManager] --- {}", methodName, ex.what()));
+        if (IsTracing()) {
+            Trace({ .id = eTraceEvent::METHOD_FAILED, .protocol = protocol, .arg1 = call.methodId.value, .payload = TraceText(ex.what()) });
+        }
+        throw;
+    }
+}
+
+
+TransactionResult TransactionResultFromValue(const Value& value) {
+    const auto& items = value.Get<List>();
+    TransactionResult result;
+    size_t index = 0;
+    while (index < items.size()) {
+        const auto& item = items[index];
+        if (item.Is<eCommand>() && (item.Get<eCommand>() == eCommand::START_TRANSACTION || item.Get<eCommand>() == eCommand::END_TRANSACTION)) {
+            if (index + 1 >= items.size() || !items[index + 1].IsInteger()) {
+                throw InvalidResponseError("Transaction", "expected a status code after transaction token");
+            }
+            const auto status = uint8_t(items[index + 1].Get<unsigned>());
+            (item.Get<eCommand>() == eCommand::START_TRANSACTION ? result.startStatus : result.endStatus) = status;
+            index += 2;
+        }
+        else {
+            if (index + 3 > items.size()) {
+                throw InvalidResponseError("Transaction", "incomplete method result");
+            }
+            const Value methodResult = List(items.begin() + index, items.begin() + index + 3);
+            result.results.push_back(MethodResultFromValue(methodResult));
+            index += 3;
+        }
+    }
+    return result;
+}
+
+
+asyncpp::task<TransactionResult> CallRemoteTransaction(std::shared_ptr<TrustedPeripheral> tper,
+                                                       uint8_t protocol,
+                                                       uint32_t tperSessionNumber,
+                                                       uint32_t hostSessionNumber,
+                                                       std::vector<MethodCall> calls,
+                                                       bool startTransaction,
+                                                       std::optional<uint8_t> endTransaction,
+                                                       CancellationToken cancellation) {
+    List items;
+    if (startTransaction) {
+        items.emplace_back(eCommand::START_TRANSACTION);
+        items.emplace_back(uint8_t(0));
+    }
+    for (const auto& call : calls) {
+        const auto callValue = MethodCallToValue(call);
+        std::ranges::copy(callValue.Get<List>(), std::back_inserter(items));
+    }
+    if (endTransaction) {
+        items.emplace_back(eCommand::END_TRANSACTION);
+        items.emplace_back(*endTransaction);
+    }
+
+    // Each call of the batch is traced as if it were sent on its own.
+    if (IsTracing()) {
+        for (const auto& call : calls) {
+            Trace({ .id = eTraceEvent::METHOD_CALL, .protocol = protocol, .arg0 = call.invokingId.value, .arg1 = call.methodId.value });
+        }
+    }
+    try {
+        Value request = std::move(items);
+        const Value response = co_await SendPacketizedValue(tper, protocol, tperSessionNumber, hostSessionNumber, std::move(request), true, std::move(cancellation));
+        TransactionResult result = TransactionResultFromValue(response);
+        if (IsTracing()) {
+            for (size_t i = 0; i < result.results.size() && i < calls.size(); ++i) {
+                Trace({ .id = eTraceEvent::METHOD_RESULT, .protocol = protocol, .arg0 = uint64_t(result.results[i].status), .arg1 = calls[i].methodId.value });
+            }
+        }
+        co_return result;
+    }
+    catch (std::exception& ex) {
+        if (IsTracing()) {
+            const auto message = TraceText(ex.what());
+            for (const auto& call : calls) {
+                Trace({ .id = eTraceEvent::METHOD_FAILED, .protocol = protocol, .arg1 = call.methodId.value, .payload = message });
+            }
+        }
         throw;
     }
 }
@@ -10,24 +10,43 @@
 
 namespace sedmgr {
 
+struct TransactionResult {
+    std::vector<MethodResult> results;
+    std::optional<uint8_t> startStatus;
+    std::optional<uint8_t> endStatus;
+};
+
+
 asyncpp::task<Value> SendPacketizedValue(std::shared_ptr<TrustedPeripheral> tper,
                                          uint8_t protocol,
                                          uint32_t tperSessionNumber,
                                          uint32_t hostSessionNumber,
                                          Value request,
-                                         bool isRequestList);
+                                         bool isRequestList,
+                                         CancellationToken cancellation = {});
 
 asyncpp::task<MethodResult> CallRemoteMethod(std::shared_ptr<TrustedPeripheral> tper,
                                              uint8_t protocol,
                                              uint32_t tperSessionNumber,
                                              uint32_t hostSessionNumber,
-                                             MethodCall call);
+                                             MethodCall call,
+                                             CancellationToken cancellation = {});
 
 asyncpp::task<MethodResult> CallRemoteSessionMethod(std::shared_ptr<TrustedPeripheral> tper,
                                                     uint8_t protocol,
                                                     uint32_t tperSessionNumber,
                                                     uint32_t hostSessionNumber,
-                                                    MethodCall call);
+                                                    MethodCall call,
+                                                    CancellationToken cancellation = {});
+
+asyncpp::task<TransactionResult> CallRemoteTransaction(std::shared_ptr<TrustedPeripheral> tper,
+                                                       uint8_t protocol,
+                                                       uint32_t tperSessionNumber,
+                                                       uint32_t hostSessionNumber,
+                                                       std::vector<MethodCall> calls,
+                                                       bool startTransaction,
+                                                       std::optional<uint8_t> endTransaction,
+                                                       CancellationToken cancellation = {});
 
 
 template <class T>
@@ -70,9 +89,9 @@ template <class T>
 ConvertResult(T) -> ConvertResult<T>;
 
 
-template <class T, class... Results>
-T ResultAs(const std::tuple<Results...>& results) {
-    return std::apply([](const auto&... values) { return T{ ConvertResult(values)... }; }, results);
+template <class T, class... Natives>
+T ResultAs(std::tuple<Natives...> results) {
+    return std::apply([](auto&... values) { return T{ std::move(values)... }; }, results);
 }
 
 
@@ -0,0 +1,201 @@
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+
+namespace sedmgr {
+
+//------------------------------------------------------------------------------
+// Histogram
+//------------------------------------------------------------------------------
+
+size_t Histogram::BucketIndex(uint64_t value) {
+    if (value < subBucketCount) {
+        return size_t(value);
+    }
+    const size_t exponent = std::bit_width(value) - 1;
+    const size_t subBucket = size_t(value >> (exponent - subBucketBits)) & (subBucketCount - 1);
+    return (exponent - subBucketBits + 1) * subBucketCount + subBucket;
+}
+
+
+uint64_t Histogram::BucketUpperBound(size_t index) {
+    if (index < subBucketCount) {
+        return index;
+    }
+    const size_t exponent = index / subBucketCount + subBucketBits - 1;
+    const size_t subBucket = index % subBucketCount;
+    const uint64_t lowerBound = uint64_t(subBucketCount + subBucket) << (exponent - subBucketBits);
+    return lowerBound + ((uint64_t(1) << (exponent - subBucketBits)) - 1);
+}
+
+
+void Histogram::Record(uint64_t value) {
+    ++m_counts[BucketIndex(value)];
+    ++m_count;
+    m_sum += value;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+}
+
+
+uint64_t Histogram::Count() const {
+    return m_count;
+}
+
+
+uint64_t Histogram::Sum() const {
+    return m_sum;
+}
+
+
+uint64_t Histogram::Min() const {
+    return m_count != 0 ? m_min : 0;
+}
+
+
+uint64_t Histogram::Max() const {
+    return m_max;
+}
+
+
+uint64_t Histogram::Mean() const {
+    return m_count != 0 ? m_sum / m_count : 0;
+}
+
+
+uint64_t Histogram::Percentile(double percentile) const {
+    if (m_count == 0) {
+        return 0;
+    }
+    const auto rank = std::max(uint64_t(1), uint64_t(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * double(m_count))));
+    uint64_t cumulative = 0;
+    for (size_t index = 0; index < m_counts.size(); ++index) {
+        cumulative += m_counts[index];
+        if (cumulative >= rank) {
+            return std::clamp(BucketUpperBound(index), Min(), Max());
+        }
+    }
+    return m_max;
+}
+
+
+auto Histogram::Summarize() const -> Summary {
+    return {
+        .count = Count(),
+        .min = Min(),
+        .mean = Mean(),
+        .p50 = Percentile(50),
+        .p90 = Percentile(90),
+        .p99 = Percentile(99),
+        .max = Max(),
+    };
+}
+
+
+//------------------------------------------------------------------------------
+// Metrics
+//------------------------------------------------------------------------------
+
+void Metrics::RecordSend(size_t bytes) {
+    m_ifSendCount.fetch_add(1, std::memory_order_relaxed);
+    m_bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+
+void Metrics::RecordReceive(size_t bytes) {
+    m_ifRecvCount.fetch_add(1, std::memory_order_relaxed);
+    m_bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+
+void Metrics::RecordExchange(std::chrono::nanoseconds latency, size_t polls) {
+    std::lock_guard lk(m_mutex);
+    m_exchangeLatency.Record(uint64_t(latency.count()));
+    m_pollsPerExchange.Record(polls);
+}
+
+
+void Metrics::RecordMethod(UID methodId, std::chrono::nanoseconds latency) {
+    std::lock_guard lk(m_mutex);
+    m_methodLatency[methodId].Record(uint64_t(latency.count()));
+}
+
+
+void Metrics::RecordEndSession(std::chrono::nanoseconds latency) {
+    std::lock_guard lk(m_mutex);
+    m_endSessionLatency.Record(uint64_t(latency.count()));
+}
+
+
+void Metrics::RecordLockWait(std::chrono::nanoseconds wait) {
+    std::lock_guard lk(m_mutex);
+    m_lockWait.Record(uint64_t(wait.count()));
+}
+
+
+void Metrics::RecordRetry() {
+    m_retryCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void Metrics::RecordSessionRestart() {
+    m_sessionRestartCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void Metrics::RecordRecoveryReset() {
+    m_recoveryResetCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void Metrics::RecordRetryExhausted() {
+    m_retryExhaustedCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+MetricsSnapshot Metrics::Snapshot() const {
+    MetricsSnapshot snapshot{
+        .ifSendCount = m_ifSendCount.load(std::memory_order_relaxed),
+        .ifRecvCount = m_ifRecvCount.load(std::memory_order_relaxed),
+        .bytesSent = m_bytesSent.load(std::memory_order_relaxed),
+        .bytesReceived = m_bytesReceived.load(std::memory_order_relaxed),
+        .retryCount = m_retryCount.load(std::memory_order_relaxed),
+        .sessionRestartCount = m_sessionRestartCount.load(std::memory_order_relaxed),
+        .recoveryResetCount = m_recoveryResetCount.load(std::memory_order_relaxed),
+        .retryExhaustedCount = m_retryExhaustedCount.load(std::memory_order_relaxed),
+    };
+    std::lock_guard lk(m_mutex);
+    snapshot.exchangeCount = m_exchangeLatency.Count();
+    snapshot.pollCount = m_pollsPerExchange.Sum();
+    snapshot.exchangeLatency = m_exchangeLatency.Summarize();
+    snapshot.pollsPerExchange = m_pollsPerExchange.Summarize();
+    snapshot.lockWait = m_lockWait.Summarize();
+    for (const auto& [methodId, histogram] : m_methodLatency) {
+        snapshot.methodLatency.insert_or_assign(methodId, histogram.Summarize());
+    }
+    snapshot.endSessionLatency = m_endSessionLatency.Summarize();
+    return snapshot;
+}
+
+
+void Metrics::Reset() {
+    m_ifSendCount = 0;
+    m_ifRecvCount = 0;
+    m_bytesSent = 0;
+    m_bytesReceived = 0;
+    m_retryCount = 0;
+    m_sessionRestartCount = 0;
+    m_recoveryResetCount = 0;
+    m_retryExhaustedCount = 0;
+    std::lock_guard lk(m_mutex);
+    m_exchangeLatency = {};
+    m_pollsPerExchange = {};
+    m_lockWait = {};
+    m_methodLatency.clear();
+    m_endSessionLatency = {};
+}
+
+} // namespace sedmgr
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Messaging/UID.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+namespace sedmgr {
+
+// Log-linear buckets in the spirit of HdrHistogram: each power of two is split
+// into 16 linear sub-buckets, which bounds the relative error to 1/16.
+class Histogram {
+public:
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t min = 0;
+        uint64_t mean = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+        uint64_t max = 0;
+    };
+
+public:
+    void Record(uint64_t value);
+    uint64_t Count() const;
+    uint64_t Sum() const;
+    uint64_t Min() const;
+    uint64_t Max() const;
+    uint64_t Mean() const;
+    uint64_t Percentile(double percentile) const;
+    Summary Summarize() const;
+
+private:
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(size_t index);
+
+private:
+    static constexpr size_t subBucketBits = 4;
+    static constexpr size_t subBucketCount = size_t(1) << subBucketBits;
+    static constexpr size_t bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+    std::array<uint64_t, bucketCount> m_counts = {};
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_min = std::numeric_limits<uint64_t>::max();
+    uint64_t m_max = 0;
+};
+
+
+struct MetricsSnapshot {
+    uint64_t ifSendCount = 0;
+    uint64_t ifRecvCount = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t exchangeCount = 0;
+    uint64_t pollCount = 0;
+    uint64_t retryCount = 0;
+    uint64_t sessionRestartCount = 0;
+    uint64_t recoveryResetCount = 0;
+    uint64_t retryExhaustedCount = 0;
+    Histogram::Summary exchangeLatency;
+    Histogram::Summary pollsPerExchange;
+    Histogram::Summary lockWait;
+    std::map<UID, Histogram::Summary> methodLatency;
+    Histogram::Summary endSessionLatency;
+};
+
+
+class Metrics {
+public:
+    void RecordSend(size_t bytes);
+    void RecordReceive(size_t bytes);
+    void RecordExchange(std::chrono::nanoseconds latency, size_t polls);
+    void RecordMethod(UID methodId, std::chrono::nanoseconds latency);
+    // Ending a session is a token, not a method, so it's kept apart.
+    void RecordEndSession(std::chrono::nanoseconds latency);
+    void RecordLockWait(std::chrono::nanoseconds wait);
+    void RecordRetry();
+    void RecordSessionRestart();
+    void RecordRecoveryReset();
+    // Counts the operations that failed after exhausting their retries.
+    void RecordRetryExhausted();
+    MetricsSnapshot Snapshot() const;
+    void Reset();
+
+private:
+    std::atomic_uint64_t m_ifSendCount = 0;
+    std::atomic_uint64_t m_ifRecvCount = 0;
+    std::atomic_uint64_t m_bytesSent = 0;
+    std::atomic_uint64_t m_bytesReceived = 0;
+    std::atomic_uint64_t m_retryCount = 0;
+    std::atomic_uint64_t m_sessionRestartCount = 0;
+    std::atomic_uint64_t m_recoveryResetCount = 0;
+    std::atomic_uint64_t m_retryExhaustedCount = 0;
+    mutable std::mutex m_mutex;
+    Histogram m_exchangeLatency;
+    Histogram m_pollsPerExchange;
+    Histogram m_lockWait;
+    std::unordered_map<UID, Histogram> m_methodLatency;
+    Histogram m_endSessionLatency;
+};
+
+} // namespace sedmgr
@@ -0,0 +1,68 @@
+#include "Probe.hpp"
+
+#include "Metrics.hpp"
+#include "TrustedPeripheral.hpp"
+
+#include <thread>
+
+
+namespace sedmgr {
+
+static ProbeResult ProbeDevice(std::shared_ptr<StorageDevice> device) {
+    if (!device) {
+        return { .error = "device not available" };
+    }
+    const auto start = std::chrono::steady_clock::now();
+    ProbeResult result;
+    try {
+        Metrics metrics;
+        result.desc = TrustedPeripheral::Discovery(device, metrics);
+    }
+    catch (std::exception& ex) {
+        result.error = ex.what();
+    }
+    result.duration = std::chrono::steady_clock::now() - start;
+    return result;
+}
+
+
+// Each device is probed on its own thread, as opening devices and IF-RECV block.
+template <class Probe>
+static std::vector<ProbeResult> ProbeInParallel(size_t count, Probe probe) {
+    std::vector<ProbeResult> results(count);
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([&results, &probe, i] { results[i] = probe(i); });
+        }
+    }
+    return results;
+}
+
+
+std::vector<ProbeResult> ProbeDevices(const std::vector<std::shared_ptr<StorageDevice>>& devices) {
+    return ProbeInParallel(devices.size(), [&devices](size_t index) {
+        return ProbeDevice(devices[index]);
+    });
+}
+
+
+std::vector<ProbeResult> ProbeDevices(const std::vector<StorageDeviceLabel>& labels,
+                                      std::function<std::shared_ptr<StorageDevice>(const StorageDeviceLabel&)> open) {
+    return ProbeInParallel(labels.size(), [&labels, &open](size_t index) {
+        const auto start = std::chrono::steady_clock::now();
+        std::shared_ptr<StorageDevice> device;
+        try {
+            device = open(labels[index]);
+        }
+        catch (std::exception& ex) {
+            return ProbeResult{ .error = ex.what(), .duration = std::chrono::steady_clock::now() - start };
+        }
+        auto result = ProbeDevice(std::move(device));
+        result.duration = std::chrono::steady_clock::now() - start;
+        return result;
+    });
+}
+
+} // namespace sedmgr
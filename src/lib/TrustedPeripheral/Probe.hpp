@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Discovery.hpp"
+
+#include <StorageDevice/StorageDevice.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace sedmgr {
+
+struct ProbeResult {
+    std::optional<TPerDesc> desc;
+    std::optional<std::string> error;
+    std::chrono::nanoseconds duration = {};
+};
+
+
+// Reads Level 0 discovery from each device in parallel, and nothing else. No
+// ComID is allocated, no session is started, and no stack reset follows, so
+// probing doesn't disturb the sessions of other processes. The results are in
+// the order of the devices. Failures, including null devices, are reported in
+// the results instead of being thrown.
+std::vector<ProbeResult> ProbeDevices(const std::vector<std::shared_ptr<StorageDevice>>& devices);
+
+// Like above, but the devices are also opened in parallel. Failing to open a
+// device is reported like a failed discovery.
+std::vector<ProbeResult> ProbeDevices(const std::vector<StorageDeviceLabel>& labels,
+                                      std::function<std::shared_ptr<StorageDevice>(const StorageDeviceLabel&)> open = OpenStorageDevice);
+
+} // namespace sedmgr
@@ -0,0 +1,98 @@
+#include "RetryPolicy.hpp"
+
+#include <Error/Exception.hpp>
+
+#include <algorithm>
+#include <random>
+
+
+namespace sedmgr {
+
+RetryPolicy RetryPolicy::None() {
+    return RetryPolicy{ .maxAttempts = 1 };
+}
+
+
+eFailureClass RetryPolicy::Classify(eMethodStatus status) {
+    switch (status) {
+        case eMethodStatus::SP_BUSY: [[fallthrough]];
+        case eMethodStatus::NO_SESSIONS_AVAILABLE: return eFailureClass::CONTENTION;
+        case eMethodStatus::TPER_MALFUNCTION: return eFailureClass::TRANSIENT;
+        default: return eFailureClass::PERMANENT;
+    }
+}
+
+
+eFailureClass RetryPolicy::Classify(std::exception_ptr failure) {
+    try {
+        std::rethrow_exception(failure);
+    }
+    catch (SecurityProviderBusyError&) {
+        return Classify(eMethodStatus::SP_BUSY);
+    }
+    catch (NoSessionsAvailableError&) {
+        return Classify(eMethodStatus::NO_SESSIONS_AVAILABLE);
+    }
+    catch (TPerMalfunctionError&) {
+        return Classify(eMethodStatus::TPER_MALFUNCTION);
+    }
+    catch (NoResponseError&) {
+        return eFailureClass::DESYNC;
+    }
+    catch (DeviceError&) {
+        return eFailureClass::TRANSIENT;
+    }
+    catch (...) {
+        return eFailureClass::PERMANENT;
+    }
+}
+
+
+RetryState::RetryState(RetryPolicy policy)
+    : m_policy(policy), m_start(Clock::now()) {}
+
+
+eRecoveryAction RetryState::Next(eFailureClass failure) {
+    ++m_failures;
+    if (failure == eFailureClass::PERMANENT
+        || (m_policy.contentionOnly && failure != eFailureClass::CONTENTION)
+        || m_failures >= m_policy.maxAttempts
+        || Clock::now() - m_start >= m_policy.budget) {
+        return eRecoveryAction::FAIL;
+    }
+    if (failure == eFailureClass::DESYNC) {
+        return m_policy.allowStackReset ? eRecoveryAction::STACK_RESET : eRecoveryAction::RESTART_SESSION;
+    }
+    if (m_policy.allowStackReset && m_failures == m_policy.retriesBeforeStackReset + 1) {
+        return eRecoveryAction::STACK_RESET;
+    }
+    if (failure == eFailureClass::TRANSIENT && m_failures == m_policy.retriesBeforeRestart + 1) {
+        return eRecoveryAction::RESTART_SESSION;
+    }
+    return eRecoveryAction::RETRY;
+}
+
+
+std::chrono::nanoseconds RetryState::Backoff() const {
+    thread_local std::mt19937_64 rne(std::random_device{}());
+
+    auto ceiling = m_policy.initialDelay;
+    for (uint32_t i = 1; i < m_failures && ceiling < m_policy.maxDelay; ++i) {
+        ceiling *= 2;
+    }
+    ceiling = std::min(ceiling, m_policy.maxDelay);
+
+    // The lower half of the range is excluded, so that backing off always waits
+    // a while, while the upper half still spreads out concurrent retries.
+    std::uniform_int_distribution<int64_t> distribution(ceiling.count() / 2, ceiling.count());
+    const auto delay = std::chrono::nanoseconds(distribution(rne));
+    const auto remaining = m_policy.budget - std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start);
+    return std::clamp(delay, std::chrono::nanoseconds(0), std::max(remaining, std::chrono::nanoseconds(0)));
+}
+
+
+uint32_t RetryState::GetFailures() const {
+    return m_failures;
+}
+
+} // namespace sedmgr
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Messaging/Method.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+
+
+namespace sedmgr {
+
+enum class eFailureClass {
+    PERMANENT, // Trying again won't help, like NOT_AUTHORIZED or INVALID_PARAMETER.
+    CONTENTION, // Someone else holds the SP or the sessions: SP_BUSY, NO_SESSIONS_AVAILABLE.
+    TRANSIENT, // The TPer or the transport misbehaved: TPER_MALFUNCTION, DeviceError.
+    DESYNC, // An exchange was left unfinished and a stale response may be queued: NoResponseError.
+};
+
+
+enum class eRecoveryAction {
+    FAIL,
+    RETRY,
+    RESTART_SESSION,
+    STACK_RESET,
+};
+
+
+// Retries back off exponentially with jitter, within both a number of attempts
+// and a time budget. Recovery escalates along the way: a transient failure
+// restarts the session once, and, if allowed, after a few failures of any kind,
+// the stack is reset once. Restarting only helps against transient failures, as
+// contention comes from sessions other than our own. The stack reset is off by
+// default, as it also closes every other session on the ComID. After a desync,
+// the same request is never sent again as is, as it could be paired with the
+// stale response: the stack is reset if allowed, otherwise the session restarts.
+struct RetryPolicy {
+    uint32_t maxAttempts = 6;
+    std::chrono::nanoseconds budget = std::chrono::seconds(5);
+    std::chrono::nanoseconds initialDelay = std::chrono::milliseconds(2);
+    std::chrono::nanoseconds maxDelay = std::chrono::milliseconds(250);
+    uint32_t retriesBeforeRestart = 1;
+    uint32_t retriesBeforeStackReset = 3;
+    bool allowStackReset = false;
+    // Fails right away on anything but contention.
+    bool contentionOnly = false;
+
+    static RetryPolicy None();
+    static eFailureClass Classify(eMethodStatus status);
+    static eFailureClass Classify(std::exception_ptr failure);
+};
+
+
+class RetryState {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit RetryState(RetryPolicy policy);
+
+    // Decides how to recover from the latest failed attempt.
+    eRecoveryAction Next(eFailureClass failure);
+    // The delay before the next attempt.
+    std::chrono::nanoseconds Backoff() const;
+    uint32_t GetFailures() const;
+
+private:
+    RetryPolicy m_policy;
+    uint32_t m_failures = 0;
+    Clock::time_point m_start;
+};
+
+} // namespace sedmgr
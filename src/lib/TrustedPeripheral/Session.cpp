@@ -12,6 +12,8 @@
 #include <asyncpp/join.hpp>
 
 #include <atomic>
+#include <iterator>
+#include <limits>
 
 
 namespace sedmgr {
@@ -32,13 +34,14 @@ Session::Session(std::shared_ptr<SessionManager> sessionManager,
       opal{ sessionManager, tperSessionNumber, hostSessionNumber },
       m_sessionManager(sessionManager),
       m_tperSessionNumber(tperSessionNumber),
-      m_hostSessionNumber(hostSessionNumber) {
+      m_hostSessionNumber(hostSessionNumber),
+      m_resetCount(sessionManager->GetTrustedPeripheral()->GetResetCount()) {
 }
 
 
 Session& Session::operator=(Session&& rhs) noexcept {
     try {
-        join(End());
+        EndInBackground();
     }
     catch (std::exception& ex) {
         std::cerr << "error while closing session: " << ex.what() << std::endl;
@@ -46,13 +49,14 @@ Session& Session::operator=(Session&& rhs) noexcept {
     m_sessionManager = std::move(rhs.m_sessionManager);
     m_tperSessionNumber = rhs.m_tperSessionNumber;
     m_hostSessionNumber = rhs.m_hostSessionNumber;
+    m_resetCount = rhs.m_resetCount;
     return *this;
 }
 
 
 Session::~Session() {
     try {
-        join(End());
+        EndInBackground();
     }
     catch (std::exception& ex) {
         std::cerr << "error while closing session: " << ex.what() << std::endl;
@@ -64,6 +68,9 @@ asyncpp::task<Session> Session::Start(std::shared_ptr<SessionManager> sessionMan
                                       UID securityProvider,
                                       std::optional<std::vector<std::byte>> password,
                                       std::optional<UID> authority) {
+    // Sessions destroyed just before may still hold the SP.
+    co_await sessionManager->GetTrustedPeripheral()->GetDrainQueue()->Flush();
+
     const auto hostSessionNumber = NewHostSessionNumber();
     const auto result = co_await sessionManager->StartSession(hostSessionNumber,
                                                               securityProvider,
@@ -77,6 +84,17 @@ asyncpp::task<Session> Session::Start(std::shared_ptr<SessionManager> sessionMan
 }
 
 
+void Session::SetCancellation(CancellationToken cancellation) {
+    base.SetCancellation(cancellation);
+    opal.SetCancellation(std::move(cancellation));
+}
+
+
+Transaction Session::StartTransaction() {
+    return Transaction(m_sessionManager, m_tperSessionNumber, m_hostSessionNumber, base.GetCancellation());
+}
+
+
 uint32_t Session::GetHostSessionNumber() const {
     return m_hostSessionNumber;
 }
@@ -85,6 +103,10 @@ uint32_t Session::GetTPerSessionNumber() const {
     return m_tperSessionNumber;
 }
 
+std::shared_ptr<SessionManager> Session::GetSessionManager() const {
+    return m_sessionManager;
+}
+
 uint32_t Session::NewHostSessionNumber() {
     static std::atomic_uint32_t hsn = 1;
     return hsn.fetch_add(1);
@@ -92,16 +114,170 @@ uint32_t Session::NewHostSessionNumber() {
 
 asyncpp::task<void> Session::End() {
     try {
-        if (m_sessionManager) {
-            co_await m_sessionManager->EndSession(m_tperSessionNumber, m_hostSessionNumber);
-            m_sessionManager = nullptr;
-        }
+        co_await Close();
     }
     catch (std::exception& ex) {
         std::cerr << std::format("failed to end session (tsn={}, hsn={}): {}", m_tperSessionNumber, m_hostSessionNumber, ex.what()) << std::endl;
     }
 }
 
+
+asyncpp::task<void> Session::Close() {
+    if (m_sessionManager && IsReset()) {
+        m_sessionManager = nullptr;
+    }
+    if (m_sessionManager) {
+        co_await m_sessionManager->EndSession(m_tperSessionNumber, m_hostSessionNumber);
+        m_sessionManager = nullptr;
+    }
+}
+
+
+// A reset has already closed the session on the TPer, and ending it again would fail.
+bool Session::IsReset() const {
+    return m_sessionManager->GetTrustedPeripheral()->GetResetCount() != m_resetCount;
+}
+
+
+void Session::EndInBackground() {
+    if (!m_sessionManager || IsReset()) {
+        m_sessionManager = nullptr;
+        return;
+    }
+    const auto drainQueue = m_sessionManager->GetTrustedPeripheral()->GetDrainQueue();
+    drainQueue->Post([sessionManager = std::move(m_sessionManager), tsn = m_tperSessionNumber, hsn = m_hostSessionNumber] {
+        return sessionManager->EndSession(tsn, hsn);
+    });
+}
+
+//------------------------------------------------------------------------------
+// Transaction
+//------------------------------------------------------------------------------
+
+Transaction::Transaction(std::shared_ptr<SessionManager> sessionManager,
+                         uint32_t tperSessionNumber,
+                         uint32_t hostSessionNumber,
+                         CancellationToken cancellation)
+    : m_sessionManager(std::move(sessionManager)),
+      m_tperSessionNumber(tperSessionNumber),
+      m_hostSessionNumber(hostSessionNumber),
+      m_cancellation(std::move(cancellation)) {}
+
+
+void Transaction::Set(UID object, std::vector<uint32_t> columns, std::vector<Value> values) {
+    auto updateIt = std::ranges::find_if(m_updates, [&](const auto& update) { return update.object == object; });
+    if (updateIt == m_updates.end()) {
+        updateIt = m_updates.insert(m_updates.end(), Update{ object, {} });
+    }
+    for (auto [colIt, valIt] = std::tuple{ columns.begin(), values.begin() };
+         colIt != columns.end() && valIt != values.end();
+         ++colIt, ++valIt) {
+        updateIt->columns.insert_or_assign(*colIt, std::move(*valIt));
+    }
+}
+
+
+void Transaction::Set(UID object, uint32_t column, Value value) {
+    Set(object, std::vector{ column }, std::vector{ std::move(value) });
+}
+
+
+size_t Transaction::Size() const {
+    return m_updates.size();
+}
+
+
+asyncpp::task<void> Transaction::Commit() {
+    if (m_updates.empty()) {
+        co_return;
+    }
+
+    // The updates are copied, so that a failed commit can be retried.
+    std::vector<MethodCall> calls;
+    for (const auto& [object, columns] : m_updates) {
+        List labeledValues;
+        for (const auto& [column, value] : columns) {
+            labeledValues.emplace_back(Named{ column, value });
+        }
+        calls.push_back(MethodCall{
+            .invokingId = object,
+            .methodId = UID(core::eMethod::Set),
+            .args = { Named{ uint16_t(1), std::move(labeledValues) } },
+        });
+    }
+
+    const auto tper = m_sessionManager->GetTrustedPeripheral();
+    const auto methodName = tper->GetModules().FindName(UID(core::eMethod::Set)).value_or("Set");
+    const auto maxMethods = GetMaxMethodsPerPacket();
+    bool isOpen = false;
+    std::exception_ptr failure;
+    try {
+        for (size_t first = 0; first < calls.size(); first += maxMethods) {
+            const size_t last = std::min(first + maxMethods, calls.size());
+            const bool isFinal = last == calls.size();
+            isOpen = !isFinal;
+            const auto result = co_await CallRemoteTransaction(tper,
+                                                               PROTOCOL,
+                                                               m_tperSessionNumber,
+                                                               m_hostSessionNumber,
+                                                               std::vector(calls.begin() + first, calls.begin() + last),
+                                                               first == 0,
+                                                               isFinal ? std::optional<uint8_t>(0) : std::nullopt,
+                                                               m_cancellation);
+            if (result.startStatus.value_or(0) != 0) {
+                throw TransactionFailureError("StartTransaction");
+            }
+            if (result.results.size() != last - first) {
+                throw InvalidResponseError("Transaction", std::format("expected {} method results, got {}", last - first, result.results.size()));
+            }
+            for (const auto& methodResult : result.results) {
+                MethodStatusToException(methodName, methodResult.status);
+            }
+            if (isFinal && result.endStatus.value_or(1) != 0) {
+                throw TransactionFailureError("EndTransaction");
+            }
+        }
+    }
+    catch (...) {
+        failure = std::current_exception();
+    }
+    if (failure && isOpen) {
+        // The token may be what just expired, so the abort goes out regardless.
+        try {
+            co_await CallRemoteTransaction(tper, PROTOCOL, m_tperSessionNumber, m_hostSessionNumber, {}, false, uint8_t(1), CancellationToken{});
+        }
+        catch (std::exception& ex) {
+            std::cerr << std::format("failed to abort transaction (tsn={}, hsn={}): {}", m_tperSessionNumber, m_hostSessionNumber, ex.what()) << std::endl;
+        }
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    m_updates.clear();
+}
+
+
+void Transaction::Abort() {
+    m_updates.clear();
+}
+
+
+static size_t MaxMethodsPerPacket(const SessionManager& sessionManager) {
+    const auto lookup = [](const SessionManager::PropertyMap& properties) {
+        const auto it = properties.find("MaxMethods");
+        return it != properties.end() && it->second != 0 ? size_t(it->second) : std::numeric_limits<size_t>::max();
+    };
+    const auto maxMethods = std::min(lookup(sessionManager.GetTPerProperties()),
+                                     lookup(sessionManager.GetHostProperties()));
+    return maxMethods != std::numeric_limits<size_t>::max() ? maxMethods : 1;
+}
+
+
+size_t Transaction::GetMaxMethodsPerPacket() const {
+    return MaxMethodsPerPacket(*m_sessionManager);
+}
+
+
 //------------------------------------------------------------------------------
 // Templates
 //------------------------------------------------------------------------------
@@ -113,7 +289,29 @@ namespace impl {
                        uint32_t hostSessionNumber)
         : m_sessionManager(sessionManager),
           m_tperSessionNumber(tperSessionNumber),
-          m_hostSessionNumber(hostSessionNumber) {}
+          m_hostSessionNumber(hostSessionNumber),
+          m_callTarget(std::make_shared<CallTarget>(CallTarget{ sessionManager->GetTrustedPeripheral(), tperSessionNumber, hostSessionNumber })) {
+        const auto target = m_callTarget.get();
+        m_callContext.callRemoteMethod = [target](MethodCall call) {
+            return CallRemoteMethod(target->tper, PROTOCOL, target->tperSessionNumber, target->hostSessionNumber, std::move(call), target->cancellation);
+        };
+        m_callContext.getMethodName = [target](UID methodId) {
+            const auto maybeMethodName = target->tper->GetModules().FindName(methodId);
+            return maybeMethodName.value_or(methodId.ToString());
+        };
+    }
+
+
+    void Template::SetCancellation(CancellationToken cancellation) {
+        if (m_callTarget) {
+            m_callTarget->cancellation = std::move(cancellation);
+        }
+    }
+
+
+    CancellationToken Template::GetCancellation() const {
+        return m_callTarget ? m_callTarget->cancellation : CancellationToken{};
+    }
 
 
     const ModuleCollection& Template::GetModules() const {
@@ -122,16 +320,31 @@ namespace impl {
 
 
     CallContext Template::GetCallContext(UID invokingId) const {
-        auto callRemoteMethod = [tper = m_sessionManager->GetTrustedPeripheral(),
-                                 tsn = m_tperSessionNumber,
-                                 hsn = m_hostSessionNumber](MethodCall call) -> asyncpp::task<MethodResult> {
-            co_return co_await CallRemoteMethod(tper, PROTOCOL, tsn, hsn, std::move(call));
-        };
-        auto getMethodName = [tper = m_sessionManager->GetTrustedPeripheral()](UID methodId) {
-            const auto maybeMethodName = tper->GetModules().FindName(methodId);
-            return maybeMethodName.value_or(methodId.ToString());
-        };
-        return CallContext{ .invokingId = invokingId, .callRemoteMethod = callRemoteMethod, .getMethodName = getMethodName };
+        return CallContext{ .invokingId = invokingId, .callRemoteMethod = m_callContext.callRemoteMethod, .getMethodName = m_callContext.getMethodName };
+    }
+
+
+    asyncpp::task<std::vector<MethodResult>> Template::CallRemoteMethods(std::vector<MethodCall> calls) {
+        const auto tper = m_sessionManager->GetTrustedPeripheral();
+        const auto maxMethods = MaxMethodsPerPacket(*m_sessionManager);
+        std::vector<MethodResult> results;
+        results.reserve(calls.size());
+        for (size_t first = 0; first < calls.size(); first += maxMethods) {
+            const size_t last = std::min(first + maxMethods, calls.size());
+            auto result = co_await CallRemoteTransaction(tper,
+                                                         PROTOCOL,
+                                                         m_tperSessionNumber,
+                                                         m_hostSessionNumber,
+                                                         std::vector(calls.begin() + first, calls.begin() + last),
+                                                         false,
+                                                         std::nullopt,
+                                                         m_callTarget->cancellation);
+            if (result.results.size() != last - first) {
+                throw InvalidResponseError("Batch", std::format("expected {} method results, got {}", last - first, result.results.size()));
+            }
+            std::ranges::move(result.results, std::back_inserter(results));
+        }
+        co_return results;
     }
 
 
@@ -140,21 +353,37 @@ namespace impl {
     //------------------------------------------------------------------------------
 
 
-    asyncpp::task<std::vector<Value>> BaseTemplate::Get(UID object, uint32_t startColumn, uint32_t endColumn) {
-        CellBlock cellBlock{
-            .startColumn = startColumn,
-            .endColumn = endColumn - 1,
-        };
-        auto [labeledValues] = co_await getMethod(GetCallContext(object), ConvertArg(cellBlock));
+    std::vector<Value> UnlabelColumns(const List& labeledValues, uint32_t startColumn, uint32_t endColumn) {
         std::vector<Value> values(endColumn - startColumn);
-        for (auto& nvp : labeledValues.Get<List>()) {
+        for (auto& nvp : labeledValues) {
             const auto idx = nvp.Get<Named>().name.Get<size_t>();
-            if (size_t(idx - startColumn) > values.size()) {
+            if (size_t(idx - startColumn) >= values.size()) {
                 throw InvalidResponseError("Get", "too many columns");
             }
             values[idx - startColumn] = nvp.Get<Named>().value;
         }
-        co_return values;
+        return values;
+    }
+
+
+    static List LabelColumns(const std::vector<uint32_t>& columns, const std::vector<Value>& values) {
+        List labeledValues;
+        for (auto [colIt, valIt] = std::tuple{ columns.begin(), values.begin() };
+             colIt != columns.end() && valIt != values.end();
+             ++colIt, ++valIt) {
+            labeledValues.emplace_back(Named{ *colIt, *valIt });
+        }
+        return labeledValues;
+    }
+
+
+    asyncpp::task<std::vector<Value>> BaseTemplate::Get(UID object, uint32_t startColumn, uint32_t endColumn) {
+        CellBlock cellBlock{
+            .startColumn = startColumn,
+            .endColumn = endColumn - 1,
+        };
+        auto [labeledValues] = co_await getMethod(GetCallContext(object), cellBlock);
+        co_return UnlabelColumns(labeledValues, startColumn, endColumn);
     }
 
 
@@ -168,13 +397,7 @@ namespace impl {
 
 
     asyncpp::task<void> BaseTemplate::Set(UID object, std::vector<uint32_t> columns, std::vector<Value> values) {
-        std::vector<Value> labeledValues;
-        for (auto [colIt, valIt] = std::tuple{ columns.begin(), values.begin() };
-             colIt != columns.end() && valIt != values.end();
-             ++colIt, ++valIt) {
-            labeledValues.emplace_back(Named{ *colIt, *valIt });
-        }
-        co_await setMethod(GetCallContext(object), std::nullopt, ConvertArg(labeledValues));
+        co_await setMethod(GetCallContext(object), std::nullopt, LabelColumns(columns, values));
     }
 
 
@@ -184,12 +407,7 @@ namespace impl {
 
 
     asyncpp::task<std::vector<UID>> BaseTemplate::Next(UID table, std::optional<UID> row, uint32_t count) {
-        auto [results] = co_await nextMethod(GetCallContext(table), ConvertArg(row), ConvertArg(count));
-        std::vector<UID> nextUids;
-        std::ranges::transform(results.Get<List>(), std::back_inserter(nextUids), [](const auto& value) -> UID {
-            return ConvertResult(value);
-        });
-        co_return nextUids;
+        co_return std::get<0>(co_await nextMethod(GetCallContext(table), row, count));
     }
 
 
@@ -203,7 +421,7 @@ namespace impl {
 
 
     asyncpp::task<void> BaseTemplate::Authenticate(UID authority, std::optional<std::vector<std::byte>> proof) {
-        auto [result] = co_await authenticateMethod(GetCallContext(THIS_SP), ConvertArg(authority), ConvertArg(proof));
+        auto [result] = co_await authenticateMethod(GetCallContext(THIS_SP), authority, std::move(proof));
         if (result.IsInteger()) {
             const auto success = result.Get<uint8_t>();
             if (!success) {
@@ -217,7 +435,104 @@ namespace impl {
 
 
     asyncpp::task<void> BaseTemplate::GenKey(UID object, std::optional<uint32_t> publicExponent, std::optional<uint32_t> pinLength) {
-        co_await genKeyMethod(GetCallContext(object), ConvertArg(publicExponent), ConvertArg(pinLength));
+        co_await genKeyMethod(GetCallContext(object), publicExponent, pinLength);
+    }
+
+
+    asyncpp::task<Bytes> BaseTemplate::GetBytes(UID table, uint32_t startRow, uint32_t endRow) {
+        CellBlock cellBlock{
+            .startRow = startRow,
+            .endRow = endRow - 1,
+        };
+        auto [bytes] = co_await getBytesMethod(GetCallContext(table), cellBlock);
+        if (bytes.size() != endRow - startRow) {
+            throw InvalidResponseError("Get", std::format("expected {} bytes, got {}", endRow - startRow, bytes.size()));
+        }
+        co_return std::move(bytes);
+    }
+
+
+    asyncpp::task<void> BaseTemplate::SetBytes(UID table, uint32_t startRow, std::span<const std::byte> bytes) {
+        co_await setBytesMethod(GetCallContext(table), startRow, Bytes(bytes.begin(), bytes.end()));
+    }
+
+
+    asyncpp::task<MethodExpected<std::vector<Value>>> BaseTemplate::TryGet(UID object, uint32_t startColumn, uint32_t endColumn) {
+        using Outcome = MethodExpected<std::vector<Value>>;
+        CellBlock cellBlock{
+            .startColumn = startColumn,
+            .endColumn = endColumn - 1,
+        };
+        const auto result = co_await getMethod.Try(GetCallContext(object), cellBlock);
+        if (!result) {
+            co_return Outcome(Unexpected(result.error()));
+        }
+        std::exception_ptr exception = nullptr;
+        try {
+            co_return Outcome(UnlabelColumns(std::get<0>(*result), startColumn, endColumn));
+        }
+        catch (...) {
+            exception = std::current_exception();
+        }
+        co_return Outcome(Unexpected(MethodError{ .exception = exception }));
+    }
+
+
+    asyncpp::task<std::vector<MethodExpected<std::vector<Value>>>> BaseTemplate::TryGet(std::span<const CellRange> ranges) {
+        using Outcome = MethodExpected<std::vector<Value>>;
+        std::vector<MethodCall> calls;
+        for (const auto& range : ranges) {
+            CellBlock cellBlock{
+                .startColumn = range.startColumn,
+                .endColumn = range.endColumn - 1,
+            };
+            calls.push_back(MethodCall{
+                .invokingId = range.object,
+                .methodId = UID(core::eMethod::Get),
+                .args = { value_cast(cellBlock) },
+            });
+        }
+        const auto results = co_await CallRemoteMethods(std::move(calls));
+
+        std::vector<Outcome> outcomes;
+        for (size_t index = 0; index < ranges.size(); ++index) {
+            if (results[index].status != eMethodStatus::SUCCESS) {
+                outcomes.emplace_back(Unexpected(MethodError{ .status = results[index].status }));
+                continue;
+            }
+            try {
+                if (results[index].values.empty()) {
+                    throw InvalidResponseError("Get", "expected 1 required results, got 0");
+                }
+                outcomes.emplace_back(UnlabelColumns(results[index].values[0].Get<List>(), ranges[index].startColumn, ranges[index].endColumn));
+            }
+            catch (...) {
+                outcomes.emplace_back(Unexpected(MethodError{ .exception = std::current_exception() }));
+            }
+        }
+        co_return outcomes;
+    }
+
+
+    asyncpp::task<MethodExpected<Value>> BaseTemplate::TryGet(UID object, uint32_t column) {
+        using Outcome = MethodExpected<Value>;
+        auto result = co_await TryGet(object, column, column + 1);
+        if (!result) {
+            co_return Outcome(Unexpected(result.error()));
+        }
+        co_return Outcome(std::move(result->at(0)));
+    }
+
+
+    asyncpp::task<MethodExpected<void>> BaseTemplate::TrySet(UID object, std::vector<uint32_t> columns, std::vector<Value> values) {
+        using Outcome = MethodExpected<void>;
+        const auto result = co_await setMethod.Try(GetCallContext(object), std::nullopt, LabelColumns(columns, values));
+        co_return result ? Outcome() : Outcome(Unexpected(result.error()));
+    }
+
+
+    asyncpp::task<MethodExpected<void>> BaseTemplate::TrySet(UID object, uint32_t column, const Value& value) {
+        co_return co_await TrySet(object, std::vector(&column, &column + 1), std::vector(&value, &value + 1));
     }
 
 
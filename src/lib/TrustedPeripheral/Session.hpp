@@ -5,13 +5,27 @@
 
 #include <Specification/Opal/OpalModule.hpp>
 
+#include <map>
 #include <memory>
+#include <span>
 
 
 namespace sedmgr {
 
+struct CellRange {
+    UID object;
+    uint32_t startColumn;
+    uint32_t endColumn;
+};
+
+
 namespace impl {
 
+    // Places the named values of a Get result by column, endColumn is exclusive.
+    // Throws if the TPer returned a column outside the requested range.
+    std::vector<Value> UnlabelColumns(const List& labeledValues, uint32_t startColumn, uint32_t endColumn);
+
+
     class Template {
     public:
         Template() = default;
@@ -19,17 +33,36 @@ namespace impl {
                  uint32_t tperSessionNumber,
                  uint32_t hostSessionNumber);
 
+        // Applies to the calls made after it's set.
+        void SetCancellation(CancellationToken cancellation);
+        CancellationToken GetCancellation() const;
+
     protected:
         const ModuleCollection& GetModules() const;
         CallContext GetCallContext(UID invokingId) const;
+        // Sends the calls with as many in each packet as MaxMethods allows. The
+        // statuses are returned, not thrown.
+        asyncpp::task<std::vector<MethodResult>> CallRemoteMethods(std::vector<MethodCall> calls);
 
     protected:
         static constexpr auto THIS_SP = 0x0000'0000'0000'0001_uid;
 
     private:
+        // Lives on the heap so that the cached call context can refer to it with
+        // a plain pointer. That keeps the lambdas within std::function's small
+        // buffer, and handing out the context for a method call doesn't allocate.
+        struct CallTarget {
+            std::shared_ptr<TrustedPeripheral> tper;
+            uint32_t tperSessionNumber;
+            uint32_t hostSessionNumber;
+            CancellationToken cancellation = {};
+        };
+
         std::shared_ptr<SessionManager> m_sessionManager = nullptr;
         uint32_t m_tperSessionNumber = 0;
         uint32_t m_hostSessionNumber = 0;
+        std::shared_ptr<CallTarget> m_callTarget = nullptr;
+        CallContext m_callContext;
         static constexpr uint8_t PROTOCOL = 0x01;
     };
 
@@ -47,13 +80,40 @@ namespace impl {
         asyncpp::task<std::optional<UID>> Next(UID table, std::optional<UID> row);
         asyncpp::task<void> Authenticate(UID authority, std::optional<std::vector<std::byte>> proof);
         asyncpp::task<void> GenKey(UID object, std::optional<uint32_t> publicExponent = {}, std::optional<uint32_t> pinLength = {});
+        // Reads and writes the rows of a byte table, [startRow, endRow) in one call.
+        asyncpp::task<Bytes> GetBytes(UID table, uint32_t startRow, uint32_t endRow);
+        asyncpp::task<void> SetBytes(UID table, uint32_t startRow, std::span<const std::byte> bytes);
+
+        // Non-throwing variants for probing many objects, where failures are expected.
+        asyncpp::task<MethodExpected<std::vector<Value>>> TryGet(UID object, uint32_t startColumn, uint32_t endColumn);
+        asyncpp::task<MethodExpected<Value>> TryGet(UID object, uint32_t column);
+        // Gets all the ranges with as few packets as possible, see CallRemoteMethods.
+        asyncpp::task<std::vector<MethodExpected<std::vector<Value>>>> TryGet(std::span<const CellRange> ranges);
+        asyncpp::task<MethodExpected<void>> TrySet(UID object, std::vector<uint32_t> columns, std::vector<Value> values);
+        asyncpp::task<MethodExpected<void>> TrySet(UID object, uint32_t column, const Value& value);
 
     private:
-        static constexpr auto getMethod = Method<UID(core::eMethod::Get), 1, 0, 1, 0>{};
-        static constexpr auto setMethod = Method<UID(core::eMethod::Set), 0, 2, 0, 0>{};
-        static constexpr auto nextMethod = Method<UID(core::eMethod::Next), 0, 2, 1, 0>{};
-        static constexpr auto authenticateMethod = Method<UID(core::eMethod::Authenticate), 1, 1, 1, 0>{};
-        static constexpr auto genKeyMethod = Method<UID(core::eMethod::GenKey), 0, 2, 0, 0>{};
+        static constexpr auto getMethod = TypedMethod<UID(core::eMethod::Get),
+                                                      Params<CellBlock>,
+                                                      Results<List>>{};
+        static constexpr auto setMethod = TypedMethod<UID(core::eMethod::Set),
+                                                      Params<std::optional<Value>, std::optional<List>>,
+                                                      Results<>>{};
+        static constexpr auto getBytesMethod = TypedMethod<UID(core::eMethod::Get),
+                                                           Params<CellBlock>,
+                                                           Results<Bytes>>{};
+        static constexpr auto setBytesMethod = TypedMethod<UID(core::eMethod::Set),
+                                                           Params<std::optional<uint32_t>, std::optional<Bytes>>,
+                                                           Results<>>{};
+        static constexpr auto nextMethod = TypedMethod<UID(core::eMethod::Next),
+                                                       Params<std::optional<UID>, std::optional<uint32_t>>,
+                                                       Results<std::vector<UID>>>{};
+        static constexpr auto authenticateMethod = TypedMethod<UID(core::eMethod::Authenticate),
+                                                               Params<UID, std::optional<Bytes>>,
+                                                               Results<Value>>{};
+        static constexpr auto genKeyMethod = TypedMethod<UID(core::eMethod::GenKey),
+                                                         Params<std::optional<uint32_t>, std::optional<uint32_t>>,
+                                                         Results<>>{};
     };
 
 
@@ -65,14 +125,47 @@ namespace impl {
         asyncpp::task<void> Activate(UID securityProvider);
 
     private:
-        static constexpr auto revertMethod = Method<UID(opal::eMethod::Revert), 0, 0, 0, 0>{};
-        static constexpr auto activateMethod = Method<UID(opal::eMethod::Activate), 0, 0, 0, 0>{};
+        static constexpr auto revertMethod = TypedMethod<UID(opal::eMethod::Revert), Params<>, Results<>>{};
+        static constexpr auto activateMethod = TypedMethod<UID(opal::eMethod::Activate), Params<>, Results<>>{};
     };
 
 
 } // namespace impl
 
 
+class Transaction {
+public:
+    Transaction(std::shared_ptr<SessionManager> sessionManager,
+                uint32_t tperSessionNumber,
+                uint32_t hostSessionNumber,
+                CancellationToken cancellation = {});
+
+    void Set(UID object, std::vector<uint32_t> columns, std::vector<Value> values);
+    void Set(UID object, uint32_t column, Value value);
+    size_t Size() const;
+    // Sends the updates in a single transaction. If that fails, they're kept, so
+    // Commit can be called again, or Abort drops them.
+    asyncpp::task<void> Commit();
+    void Abort();
+
+private:
+    size_t GetMaxMethodsPerPacket() const;
+
+private:
+    struct Update {
+        UID object;
+        std::map<uint32_t, Value> columns;
+    };
+
+    std::shared_ptr<SessionManager> m_sessionManager;
+    uint32_t m_tperSessionNumber;
+    uint32_t m_hostSessionNumber;
+    CancellationToken m_cancellation;
+    std::vector<Update> m_updates;
+    static constexpr uint8_t PROTOCOL = 0x01;
+};
+
+
 class Session {
 public:
     Session(std::shared_ptr<SessionManager> sessionManager,
@@ -89,15 +182,26 @@ public:
                                         UID securityProvider,
                                         std::optional<std::vector<std::byte>> password = {},
                                         std::optional<UID> authority = {});
+    // Ends the session and logs failures. Destroying the session ends it on the
+    // device's drain queue instead, without waiting for the reply.
     asyncpp::task<void> End();
+    // Like End, but reports failures.
+    asyncpp::task<void> Close();
+    // Bounds the method calls of the session, but not ending it.
+    void SetCancellation(CancellationToken cancellation);
+    Transaction StartTransaction();
     uint32_t GetHostSessionNumber() const;
     uint32_t GetTPerSessionNumber() const;
+    std::shared_ptr<SessionManager> GetSessionManager() const;
+    // A stack or TPer reset has closed the session on the TPer.
+    bool IsReset() const;
 
 private:
     Session(std::shared_ptr<SessionManager> sessionManager,
             uint32_t tperSessionNumber,
             uint32_t hostSessionNumber);
     static uint32_t NewHostSessionNumber();
+    void EndInBackground();
 
 public:
     impl::BaseTemplate base;
@@ -107,6 +211,7 @@ private:
     std::shared_ptr<SessionManager> m_sessionManager;
     uint32_t m_tperSessionNumber;
     uint32_t m_hostSessionNumber;
+    uint64_t m_resetCount;
 };
 
 
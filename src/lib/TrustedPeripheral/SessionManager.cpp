@@ -2,6 +2,8 @@
 
 #include "Logging.hpp"
 
+#include <chrono>
+
 
 namespace sedmgr {
 
@@ -11,8 +13,10 @@ SessionManager::SessionManager(std::shared_ptr<TrustedPeripheral> tper)
 
 auto SessionManager::Properties(std::optional<PropertyMap> hostProperties)
     -> asyncpp::task<PropertiesResult> {
-    const auto result = co_await propertiesMethod(GetCallContext(), ConvertArg(hostProperties));
-    co_return ResultAs<PropertiesResult>(result);
+    auto properties = ResultAs<PropertiesResult>(co_await propertiesMethod(GetCallContext(), std::move(hostProperties)));
+    m_tperProperties = properties.tperProperties;
+    m_hostProperties = properties.hostProperties.value_or(PropertyMap{});
+    co_return properties;
 }
 
 
@@ -30,37 +34,57 @@ auto SessionManager::StartSession(
     std::optional<uint32_t> initialCredit,
     std::optional<std::vector<std::byte>> signedHash)
     -> asyncpp::task<StartSessionResult> {
-    const auto result = co_await startSessionMethod(GetCallContext(),
-                                                    ConvertArg(hostSessionID),
-                                                    ConvertArg(spId),
-                                                    ConvertArg(write),
-                                                    ConvertArg(hostChallenge),
-                                                    ConvertArg(hostExchangeAuthority),
-                                                    ConvertArg(hostExchangeCert),
-                                                    ConvertArg(hostSigningAuthority),
-                                                    ConvertArg(hostSigningCert),
-                                                    ConvertArg(sessionTimeout),
-                                                    ConvertArg(transTimeout),
-                                                    ConvertArg(initialCredit),
-                                                    ConvertArg(signedHash));
-    co_return ResultAs<StartSessionResult>(result);
+    auto result = co_await startSessionMethod(GetCallContext(),
+                                              hostSessionID,
+                                              spId,
+                                              write,
+                                              std::move(hostChallenge),
+                                              hostExchangeAuthority,
+                                              std::move(hostExchangeCert),
+                                              hostSigningAuthority,
+                                              std::move(hostSigningCert),
+                                              sessionTimeout,
+                                              transTimeout,
+                                              initialCredit,
+                                              std::move(signedHash));
+    co_return ResultAs<StartSessionResult>(std::move(result));
 }
 
 
 asyncpp::task<void> SessionManager::EndSession(uint32_t tperSessionNumber, uint32_t hostSessionNumber) {
     Value request = eCommand::END_OF_SESSION;
-    Log(std::format("Host -> TPer >> End session TSN={}, HSN={}", tperSessionNumber, hostSessionNumber), request);
+    if (IsTracing()) {
+        Trace({ .id = eTraceEvent::END_SESSION, .protocol = PROTOCOL, .arg0 = tperSessionNumber, .arg1 = hostSessionNumber });
+    }
     try {
-        const Value response = co_await SendPacketizedValue(m_tper, PROTOCOL, tperSessionNumber, hostSessionNumber, request, false);
-        Log("TPer -> Host << End session", response);
+        const auto startTime = std::chrono::steady_clock::now();
+        co_await SendPacketizedValue(m_tper, PROTOCOL, tperSessionNumber, hostSessionNumber, request, false);
+        m_tper->GetMetrics()->RecordEndSession(std::chrono::steady_clock::now() - startTime);
     }
     catch (std::exception& ex) {
-        Log(std::format("TPer -> Host << End session --- {}", ex.what()));
+        if (IsTracing()) {
+            Trace({ .id = eTraceEvent::END_SESSION_FAILED, .protocol = PROTOCOL, .arg0 = tperSessionNumber, .arg1 = hostSessionNumber, .payload = TraceText(ex.what()) });
+        }
         throw;
     }
 }
 
 
+void SessionManager::SetCancellation(CancellationToken cancellation) {
+    m_cancellation = std::move(cancellation);
+}
+
+
+auto SessionManager::GetTPerProperties() const -> const PropertyMap& {
+    return m_tperProperties;
+}
+
+
+auto SessionManager::GetHostProperties() const -> const PropertyMap& {
+    return m_hostProperties;
+}
+
+
 std::shared_ptr<TrustedPeripheral> SessionManager::GetTrustedPeripheral() {
     return m_tper;
 }
@@ -77,8 +101,8 @@ const ModuleCollection& SessionManager::GetModules() const {
 
 
 CallContext SessionManager::GetCallContext() const {
-    auto callRemoteMethod = [tper = m_tper](MethodCall call) -> asyncpp::task<MethodResult> {
-        co_return co_await CallRemoteSessionMethod(tper, PROTOCOL, 0, 0, std::move(call));
+    auto callRemoteMethod = [tper = m_tper, cancellation = m_cancellation](MethodCall call) {
+        return CallRemoteSessionMethod(tper, PROTOCOL, 0, 0, std::move(call), cancellation);
     };
     auto getMethodName = [tper = m_tper](UID methodId) {
         const auto maybeMethodName = tper->GetModules().FindName(methodId);
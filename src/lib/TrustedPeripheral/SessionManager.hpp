@@ -57,6 +57,13 @@ public:
 
     asyncpp::task<void> EndSession(uint32_t tperSessionNumber, uint32_t hostSessionNumber);
 
+    // Bounds Properties and StartSession. Ending sessions is not bounded, so
+    // that they can still be cleaned up once the token expired.
+    void SetCancellation(CancellationToken cancellation);
+
+    const PropertyMap& GetTPerProperties() const;
+    const PropertyMap& GetHostProperties() const;
+
     std::shared_ptr<TrustedPeripheral> GetTrustedPeripheral();
     std::shared_ptr<const TrustedPeripheral> GetTrustedPeripheral() const;
 
@@ -67,10 +74,35 @@ private:
 private:
     static constexpr UID INVOKING_ID = 0xFF_uid;
     static constexpr uint8_t PROTOCOL = 0x01;
-    static constexpr auto propertiesMethod = Method<UID(core::eMethod::Properties), 0, 1, 1, 1>{};
-    static constexpr auto startSessionMethod = Method<UID(core::eMethod::StartSession), 3, 9, 2, 6>{};
+    static constexpr auto propertiesMethod = TypedMethod<UID(core::eMethod::Properties),
+                                                         Params<std::optional<PropertyMap>>,
+                                                         Results<PropertyMap, std::optional<PropertyMap>>>{};
+    static constexpr auto startSessionMethod = TypedMethod<UID(core::eMethod::StartSession),
+                                                           Params<uint32_t,
+                                                                  UID,
+                                                                  bool,
+                                                                  std::optional<Bytes>,
+                                                                  std::optional<UID>,
+                                                                  std::optional<Bytes>,
+                                                                  std::optional<UID>,
+                                                                  std::optional<Bytes>,
+                                                                  std::optional<uint32_t>,
+                                                                  std::optional<uint32_t>,
+                                                                  std::optional<uint32_t>,
+                                                                  std::optional<Bytes>>,
+                                                           Results<uint32_t,
+                                                                   uint32_t,
+                                                                   std::optional<Bytes>,
+                                                                   std::optional<Bytes>,
+                                                                   std::optional<Bytes>,
+                                                                   std::optional<uint32_t>,
+                                                                   std::optional<uint32_t>,
+                                                                   std::optional<Bytes>>>{};
 
     std::shared_ptr<TrustedPeripheral> m_tper;
+    CancellationToken m_cancellation;
+    PropertyMap m_tperProperties;
+    PropertyMap m_hostProperties;
 };
 
 
@@ -10,9 +10,9 @@
 #include <Specification/Core/CoreModule.hpp>
 #include <Specification/Opal/OpalModule.hpp>
 
-#include <asyncpp/join.hpp>
 #include <asyncpp/sleep.hpp>
 
+#include <algorithm>
 #include <array>
 #include <stdexcept>
 
@@ -34,14 +34,20 @@ void LoadModules(const TPerDesc& desc, ModuleCollection& modules) {
 }
 
 
-TrustedPeripheral::TrustedPeripheral(std::shared_ptr<StorageDevice> storageDevice)
-    : m_storageDevice(storageDevice), m_sendRecvMutex(std::make_unique<asyncpp::mutex>()) {
-    m_desc = Discovery(storageDevice);
+TrustedPeripheral::TrustedPeripheral(std::shared_ptr<StorageDevice> storageDevice,
+                                     std::shared_ptr<Metrics> metrics,
+                                     std::shared_ptr<DeviceLock> deviceLock)
+    : m_storageDevice(storageDevice),
+      m_metrics(metrics ? std::move(metrics) : std::make_shared<Metrics>()),
+      m_sendRecvMutex(std::make_unique<asyncpp::mutex>()),
+      m_drainQueue(DrainQueue::ForDevice(*storageDevice)),
+      m_deviceLock(std::move(deviceLock)) {
+    m_desc = Discovery(storageDevice, *m_metrics);
 
     if (m_desc.tperDesc) {
         if (m_desc.tperDesc->comIdMgmtSupported) {
             try {
-                std::tie(m_comId, m_comIdExtension) = RequestComId(storageDevice);
+                std::tie(m_comId, m_comIdExtension) = RequestComId(storageDevice, *m_metrics);
             }
             catch (std::exception& ex) {
                 throw std::runtime_error(std::format("dynamically allocating ComID failed: {}", ex.what()));
@@ -66,8 +72,14 @@ TrustedPeripheral::TrustedPeripheral(std::shared_ptr<StorageDevice> storageDevic
 
 
 TrustedPeripheral::~TrustedPeripheral() {
+    if (m_closed) {
+        return;
+    }
     try {
-        join(StackReset());
+        // The job holds on to the device lock, so the reset is still covered by it.
+        m_drainQueue->Post([storageDevice = m_storageDevice, metrics = m_metrics, comId = m_comId, comIdExtension = m_comIdExtension, deviceLock = m_deviceLock] {
+            return StackReset(*storageDevice, *metrics, comId, comIdExtension);
+        });
     }
     catch (std::exception& ex) {
         std::cerr << ex.what() << std::endl;
@@ -85,6 +97,11 @@ uint16_t TrustedPeripheral::GetComIdExtension() const {
 }
 
 
+uint64_t TrustedPeripheral::GetResetCount() const {
+    return m_resetCount.load(std::memory_order_relaxed);
+}
+
+
 const TPerDesc& TrustedPeripheral::GetDesc() const {
     return m_desc;
 }
@@ -95,6 +112,16 @@ const ModuleCollection& TrustedPeripheral::GetModules() const {
 }
 
 
+std::shared_ptr<Metrics> TrustedPeripheral::GetMetrics() const {
+    return m_metrics;
+}
+
+
+std::shared_ptr<DrainQueue> TrustedPeripheral::GetDrainQueue() const {
+    return m_drainQueue;
+}
+
+
 asyncpp::task<eComIdState> TrustedPeripheral::VerifyComId() {
     const VerifyComIdValidRequest request{
         .comId = m_comId,
@@ -108,43 +135,48 @@ asyncpp::task<eComIdState> TrustedPeripheral::VerifyComId() {
 
 
 asyncpp::task<void> TrustedPeripheral::StackReset() {
-    const StackResetRequest request{
-        .comId = m_comId,
-        .comIdExtension = m_comIdExtension
-    };
-
-    const auto reply = co_await ExchangeStructure<StackResetResponse>(0x02, request);
-
-    if (reply.success != eStackResetStatus::SUCCESS) {
-        throw InvocationError("STACK_RESET", "failed");
-    }
+    // Sessions ended in the background must go first, the reset would leave
+    // them referring to sessions that no longer exist.
+    co_await m_drainQueue->Flush();
+    asyncpp::unique_lock lk = co_await *m_sendRecvMutex;
+    co_await StackReset(*m_storageDevice, *m_metrics, m_comId, m_comIdExtension);
+    m_resetCount.fetch_add(1, std::memory_order_relaxed);
 }
 
 
 asyncpp::task<void> TrustedPeripheral::Reset() {
+    co_await m_drainQueue->Flush();
     std::array payload{ std::byte(0) };
     co_await Send(0x02, 0x0004, payload);
+    m_resetCount.fetch_add(1, std::memory_order_relaxed);
 }
 
 
-asyncpp::task<ComPacket> TrustedPeripheral::SendPacket(uint8_t protocol, ComPacket packet) {
-    co_return co_await ExchangePacket(protocol, std::move(packet));
+asyncpp::task<void> TrustedPeripheral::Close() {
+    co_await StackReset();
+    m_closed = true;
 }
 
 
-TPerDesc TrustedPeripheral::Discovery(std::shared_ptr<StorageDevice> storageDevice) {
+asyncpp::task<ComPacket> TrustedPeripheral::SendPacket(uint8_t protocol, ComPacket packet, CancellationToken cancellation) {
+    // Not a coroutine, so that every method call saves a frame.
+    return ExchangePacket(protocol, std::move(packet), std::move(cancellation));
+}
+
+
+TPerDesc TrustedPeripheral::Discovery(std::shared_ptr<StorageDevice> storageDevice, Metrics& metrics) {
     std::array<std::byte, 4096> response;
     std::ranges::fill(response, 0_b);
-    SecurityReceive(*storageDevice, 0x01, 0x0001, response);
+    SecurityReceive(*storageDevice, metrics, 0x01, 0x0001, response);
     TPerDesc desc = ParseTPerDesc(response);
     return desc;
 }
 
 
-std::pair<uint16_t, uint16_t> TrustedPeripheral::RequestComId(std::shared_ptr<StorageDevice> storageDevice) {
+std::pair<uint16_t, uint16_t> TrustedPeripheral::RequestComId(std::shared_ptr<StorageDevice> storageDevice, Metrics& metrics) {
     std::array<std::byte, 4> response;
     std::ranges::fill(response, 0xFF_b);
-    SecurityReceive(*storageDevice, 0x02, 0x0000, response);
+    SecurityReceive(*storageDevice, metrics, 0x02, 0x0000, response);
     const auto comId = DeSerialize(Serialized<uint16_t>{ response });
     const auto comIdExtension = DeSerialize(Serialized<uint16_t>{ std::span{ response }.subspan(2) });
     return { comId, comIdExtension };
@@ -153,35 +185,45 @@ std::pair<uint16_t, uint16_t> TrustedPeripheral::RequestComId(std::shared_ptr<St
 
 asyncpp::task<void> TrustedPeripheral::Send(uint8_t protocol, uint16_t comId, std::span<const std::byte> payload) {
     asyncpp::unique_lock lk = co_await *m_sendRecvMutex;
-    SecuritySend(*m_storageDevice, protocol, comId, payload);
+    SecuritySend(*m_storageDevice, *m_metrics, protocol, comId, payload);
 }
 
 
-asyncpp::task<void> impl::ExponentialDelay::Delay() {
+asyncpp::task<void> impl::ExponentialDelay::Delay(std::chrono::nanoseconds limit) {
     using namespace std::chrono_literals;
 
     if (maxDelay != 0ns && totalDelay > maxDelay) {
         throw NoResponseError("timed out");
     }
-    co_await asyncpp::sleep_for(delay);
-    totalDelay += delay;
+    const auto sleep = std::min(delay, limit);
+    co_await asyncpp::sleep_for(sleep);
+    totalDelay += sleep;
     delay *= 2;
 }
 
 
-asyncpp::task<ComPacket> TrustedPeripheral::ExchangePacket(uint8_t protocol, ComPacket packet) {
+asyncpp::task<ComPacket> TrustedPeripheral::ExchangePacket(uint8_t protocol, ComPacket packet, CancellationToken cancellation) {
     using namespace std::chrono_literals;
 
     const asyncpp::unique_lock lk = co_await *m_sendRecvMutex;
-
-    const auto sendBuffer = Serialize(packet);
-    SecuritySend(*m_storageDevice, protocol, packet.comId, sendBuffer);
+    // Nothing was sent yet, so the session is left as it was.
+    cancellation.ThrowIfCancelled();
+    const auto startTime = std::chrono::steady_clock::now();
+
+    auto sendBuffer = Serialize(packet);
+    SecuritySend(*m_storageDevice, *m_metrics, protocol, packet.comId, sendBuffer);
+    if (IsTracing()) {
+        Trace({ .id = eTraceEvent::PACKET_SENT, .protocol = protocol, .comId = packet.comId, .payload = std::make_shared<const std::vector<std::byte>>(std::move(sendBuffer)) });
+    }
 
     std::vector<ComPacket> receivedPackets;
     std::vector<std::byte> receiveBuffer(2048);
     impl::ExponentialDelay delay{ 1us, 2000ms };
+    size_t polls = 0;
+    bool cancelled = false;
     do {
-        SecurityReceive(*m_storageDevice, protocol, packet.comId, receiveBuffer);
+        SecurityReceive(*m_storageDevice, *m_metrics, protocol, packet.comId, receiveBuffer);
+        ++polls;
         auto receivedPacket = DeSerialize(Serialized<ComPacket>(receiveBuffer));
 
         // Device wants to send data larger than the receive buffer.
@@ -198,6 +240,11 @@ asyncpp::task<ComPacket> TrustedPeripheral::ExchangePacket(uint8_t protocol, Com
 
         // Current packet contains useful data.
         if (receivedData) {
+            if (IsTracing()) {
+                const auto length = std::min(size_t(20 + receivedPacket.PayloadLength()), receiveBuffer.size());
+                const auto bytes = std::make_shared<const std::vector<std::byte>>(receiveBuffer.begin(), receiveBuffer.begin() + length);
+                Trace({ .id = eTraceEvent::PACKET_RECEIVED, .protocol = protocol, .comId = packet.comId, .payload = bytes });
+            }
             receivedPackets.push_back(std::move(receivedPacket));
         }
 
@@ -207,10 +254,21 @@ asyncpp::task<ComPacket> TrustedPeripheral::ExchangePacket(uint8_t protocol, Com
         }
         // If device intends to send more data, but it's not ready yet, wait a bit.
         if (outstandingData == 1) {
-            co_await delay.Delay();
+            if (cancellation.IsCancelled()) {
+                cancelled = true;
+                break;
+            }
+            co_await delay.Delay(cancellation.Remaining());
         }
     } while (true);
 
+    if (cancelled) {
+        co_await StackReset(*m_storageDevice, *m_metrics, m_comId, m_comIdExtension);
+        m_resetCount.fetch_add(1, std::memory_order_relaxed);
+        cancellation.ThrowIfCancelled();
+    }
+    m_metrics->RecordExchange(std::chrono::steady_clock::now() - startTime, polls);
+
     if (receivedPackets.empty()) {
         throw NoResponseError("empty packet received");
     }
@@ -221,30 +279,54 @@ asyncpp::task<ComPacket> TrustedPeripheral::ExchangePacket(uint8_t protocol, Com
 }
 
 
+asyncpp::task<void> TrustedPeripheral::StackReset(StorageDevice& storageDevice, Metrics& metrics, uint16_t comId, uint16_t comIdExtension) {
+    const StackResetRequest request{
+        .comId = comId,
+        .comIdExtension = comIdExtension
+    };
+
+    const auto reply = co_await ExchangeStructure<StackResetResponse>(storageDevice, metrics, 0x02, comId, request);
+
+    if (reply.success != eStackResetStatus::SUCCESS) {
+        throw InvocationError("STACK_RESET", "failed");
+    }
+}
+
+
 std::array<std::byte, 2> TrustedPeripheral::SerializeComId(uint16_t comId) {
     return { std::byte(comId & 0xFF), std::byte(comId >> 8) };
 }
 
 
-void TrustedPeripheral::SecuritySend(StorageDevice& storageDevice, uint8_t protocol, uint16_t comId, std::span<const std::byte> payload) {
+void TrustedPeripheral::SecuritySend(StorageDevice& storageDevice, Metrics& metrics, uint8_t protocol, uint16_t comId, std::span<const std::byte> payload) {
     try {
         storageDevice.SecuritySend(protocol, SerializeComId(comId), payload);
-        Log(std::format("IF-SEND: Protocol={}, ComID={}, payload: {} bytes", protocol, comId, payload.size()));
+        metrics.RecordSend(payload.size());
+        if (IsTracing()) {
+            Trace({ .id = eTraceEvent::IF_SEND, .protocol = protocol, .comId = comId, .arg0 = payload.size() });
+        }
     }
     catch (std::exception& ex) {
-        Log(std::format("IF-SEND FAILED: Protocol={}, ComID={}, payload: {} bytes --- {}", protocol, comId, payload.size(), ex.what()));
+        if (IsTracing()) {
+            Trace({ .id = eTraceEvent::IF_SEND_FAILED, .protocol = protocol, .comId = comId, .arg0 = payload.size(), .payload = TraceText(ex.what()) });
+        }
         throw;
     }
 }
 
 
-void TrustedPeripheral::SecurityReceive(StorageDevice& storageDevice, uint8_t protocol, uint16_t comId, std::span<std::byte> payload) {
+void TrustedPeripheral::SecurityReceive(StorageDevice& storageDevice, Metrics& metrics, uint8_t protocol, uint16_t comId, std::span<std::byte> payload) {
     try {
         storageDevice.SecurityReceive(protocol, SerializeComId(comId), payload);
-        Log(std::format("IF-RECV: Protocol={}, ComID={}, payload: {} bytes", protocol, comId, payload.size()));
+        metrics.RecordReceive(payload.size());
+        if (IsTracing()) {
+            Trace({ .id = eTraceEvent::IF_RECV, .protocol = protocol, .comId = comId, .arg0 = payload.size() });
+        }
     }
     catch (std::exception& ex) {
-        Log(std::format("IF-RECV FAILED: Protocol={}, ComID={}, payload: {} bytes --- {}", protocol, comId, payload.size(), ex.what()));
+        if (IsTracing()) {
+            Trace({ .id = eTraceEvent::IF_RECV_FAILED, .protocol = protocol, .comId = comId, .arg0 = payload.size(), .payload = TraceText(ex.what()) });
+        }
         throw;
     }
 }
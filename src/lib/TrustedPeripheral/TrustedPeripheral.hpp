@@ -1,14 +1,19 @@
 #pragma once
 
+#include "Cancellation.hpp"
 #include "Discovery.hpp"
+#include "DrainQueue.hpp"
+#include "Metrics.hpp"
 #include "ModuleCollection.hpp"
 
 #include <Messaging/SetupPackets.hpp>
+#include <StorageDevice/DeviceLock.hpp>
 #include <StorageDevice/NvmeDevice.hpp>
 
 #include <asyncpp/mutex.hpp>
 #include <asyncpp/task.hpp>
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 
@@ -20,47 +25,72 @@ struct ComPacket;
 
 class TrustedPeripheral {
 public:
-    TrustedPeripheral(std::shared_ptr<StorageDevice> storageDevice);
+    // The device lock, if given, must be held already. It's kept until the stack
+    // reset the destructor leaves to the drain queue has run. The device's drain
+    // queue should be flushed first, or a reset left behind by a previous TPer
+    // may hit this one.
+    TrustedPeripheral(std::shared_ptr<StorageDevice> storageDevice,
+                      std::shared_ptr<Metrics> metrics = nullptr,
+                      std::shared_ptr<DeviceLock> deviceLock = nullptr);
     ~TrustedPeripheral();
 
     const TPerDesc& GetDesc() const;
     const ModuleCollection& GetModules() const;
+    std::shared_ptr<Metrics> GetMetrics() const;
+    std::shared_ptr<DrainQueue> GetDrainQueue() const;
 
     uint16_t GetComId() const;
     uint16_t GetComIdExtension() const;
+    // Counts stack resets and TPer resets, which close every session on the ComID.
+    uint64_t GetResetCount() const;
     asyncpp::task<eComIdState> VerifyComId();
     asyncpp::task<void> StackReset();
     asyncpp::task<void> Reset();
+    // Resets the stack right away. Without it, the destructor leaves that to the
+    // drain queue.
+    asyncpp::task<void> Close();
 
-    asyncpp::task<ComPacket> SendPacket(uint8_t protocol, ComPacket packet);
+    // When the token expires while a response is due, the stack is reset so that
+    // the response can't be mistaken for that of the next request.
+    asyncpp::task<ComPacket> SendPacket(uint8_t protocol, ComPacket packet, CancellationToken cancellation = {});
+
+    // Reads Level 0 discovery, which needs neither a ComID nor a session.
+    static TPerDesc Discovery(std::shared_ptr<StorageDevice> storageDevice, Metrics& metrics);
 
 private:
-    static TPerDesc Discovery(std::shared_ptr<StorageDevice> storageDevice);
-    static std::pair<uint16_t, uint16_t> RequestComId(std::shared_ptr<StorageDevice> storageDevice);
+    static std::pair<uint16_t, uint16_t> RequestComId(std::shared_ptr<StorageDevice> storageDevice, Metrics& metrics);
 
     asyncpp::task<void> Send(uint8_t protocol, uint16_t comId, std::span<const std::byte> payload);
-    asyncpp::task<ComPacket> ExchangePacket(uint8_t protocol, ComPacket packet);
+    asyncpp::task<ComPacket> ExchangePacket(uint8_t protocol, ComPacket packet, CancellationToken cancellation);
     template <class Reply, class Request>
     asyncpp::task<Reply> ExchangeStructure(uint8_t protocol, Request request);
+    template <class Reply, class Request>
+    static asyncpp::task<Reply> ExchangeStructure(StorageDevice& storageDevice, Metrics& metrics, uint8_t protocol, uint16_t comId, Request request);
+    static asyncpp::task<void> StackReset(StorageDevice& storageDevice, Metrics& metrics, uint16_t comId, uint16_t comIdExtension);
 
     static std::array<std::byte, 2> SerializeComId(uint16_t comId);
-    static void SecuritySend(StorageDevice& storageDevice, uint8_t protocol, uint16_t comId, std::span<const std::byte> payload);
-    static void SecurityReceive(StorageDevice& storageDevice, uint8_t protocol, uint16_t comId, std::span<std::byte> payload);
+    static void SecuritySend(StorageDevice& storageDevice, Metrics& metrics, uint8_t protocol, uint16_t comId, std::span<const std::byte> payload);
+    static void SecurityReceive(StorageDevice& storageDevice, Metrics& metrics, uint8_t protocol, uint16_t comId, std::span<std::byte> payload);
 
 private:
     std::shared_ptr<StorageDevice> m_storageDevice;
+    std::shared_ptr<Metrics> m_metrics;
     TPerDesc m_desc;
     uint16_t m_comId;
     uint16_t m_comIdExtension;
     ModuleCollection m_modules;
     std::unique_ptr<asyncpp::mutex> m_sendRecvMutex;
+    std::shared_ptr<DrainQueue> m_drainQueue;
+    std::shared_ptr<DeviceLock> m_deviceLock;
+    std::atomic_uint64_t m_resetCount = 0;
+    bool m_closed = false;
 };
 
 
 namespace impl {
 
     struct ExponentialDelay {
-        asyncpp::task<void> Delay();
+        asyncpp::task<void> Delay(std::chrono::nanoseconds limit = std::chrono::nanoseconds::max());
 
         std::chrono::nanoseconds delay;
         std::chrono::nanoseconds maxDelay{ 0 };
@@ -72,18 +102,26 @@ namespace impl {
 
 template <class Reply, class Request>
 asyncpp::task<Reply> TrustedPeripheral::ExchangeStructure(uint8_t protocol, Request request) {
-    using namespace std::chrono_literals;
-
     asyncpp::unique_lock lk = co_await *m_sendRecvMutex;
+    co_return co_await ExchangeStructure<Reply>(*m_storageDevice, *m_metrics, protocol, m_comId, std::move(request));
+}
+
+
+template <class Reply, class Request>
+asyncpp::task<Reply> TrustedPeripheral::ExchangeStructure(StorageDevice& storageDevice, Metrics& metrics, uint8_t protocol, uint16_t comId, Request request) {
+    using namespace std::chrono_literals;
 
+    const auto startTime = std::chrono::steady_clock::now();
     const auto sendBuffer = Serialize(request);
-    m_storageDevice->SecuritySend(protocol, SerializeComId(m_comId), sendBuffer);
+    SecuritySend(storageDevice, metrics, protocol, comId, sendBuffer);
 
     impl::ExponentialDelay delay{ 1us, 2000ms };
+    size_t polls = 0;
     do {
         std::array<std::byte, 256> responseBytes;
         std::ranges::fill(responseBytes, 0_b);
-        m_storageDevice->SecurityReceive(protocol, SerializeComId(m_comId), responseBytes);
+        SecurityReceive(storageDevice, metrics, protocol, comId, responseBytes);
+        ++polls;
         auto reply = DeSerialize(Serialized<Reply>{ responseBytes });
 
         if (reply.requestCode == 0) {
@@ -93,6 +131,7 @@ asyncpp::task<Reply> TrustedPeripheral::ExchangeStructure(uint8_t protocol, Requ
             co_await delay.Delay();
             continue;
         }
+        metrics.RecordExchange(std::chrono::steady_clock::now() - startTime, polls);
         co_return reply;
     } while (true);
 }
@@ -301,3 +301,37 @@ TEST_CASE("Method: execute method", "[Method]") {
     REQUIRE(results[1].Get<int>() == 3);
     REQUIRE(results[2].Get<int>() == 2);
 }
+
+
+TEST_CASE("Method: typed method - native arguments", "[Method]") {
+    const auto method = TypedMethod<methodId, Params<uint32_t, UID, std::optional<bool>, std::optional<uint16_t>>, Results<>>{};
+    CallContext context{
+        invokingId,
+        [](MethodCall call) -> asyncpp::task<MethodResult> {
+            REQUIRE(call.args.size() == 3);
+            REQUIRE(call.args[0].Get<uint32_t>() == 7);
+            REQUIRE(value_cast<UID>(call.args[1]) == 0x0000'0009'0000'0001_uid);
+            REQUIRE(call.args[2].Get<Named>().name.Get<uint16_t>() == 1);
+            REQUIRE(call.args[2].Get<Named>().value.Get<uint16_t>() == 300);
+            co_return MethodResult{};
+        },
+    };
+    [[maybe_unused]] const std::tuple<> result = join(method(context, 7, 0x0000'0009'0000'0001_uid, std::nullopt, uint16_t(300)));
+}
+
+
+TEST_CASE("Method: typed method - native results", "[Method]") {
+    const auto method = TypedMethod<methodId, Params<>, Results<UID, std::optional<uint32_t>, std::optional<Bytes>>>{};
+    CallContext context{
+        invokingId,
+        [](MethodCall) -> asyncpp::task<MethodResult> {
+            co_return MethodResult{
+                .values = { value_cast(0x0000'0009'0000'0001_uid), Named(1, Bytes{ std::byte(0xAB) }), Named(5, 0) },
+            };
+        },
+    };
+    const auto [uid, number, bytes] = join(method(context));
+    REQUIRE(uid == 0x0000'0009'0000'0001_uid);
+    REQUIRE(number == std::nullopt);
+    REQUIRE(bytes == Bytes{ std::byte(0xAB) });
+}
@@ -0,0 +1,165 @@
+#include <EncryptedDevice/DataStore.hpp>
+#include <EncryptedDevice/EncryptedDevice.hpp>
+#include <Error/Exception.hpp>
+#include <MockDevice/MockDevice.hpp>
+#include <Specification/Core/Defs/UIDs.hpp>
+#include <Specification/Opal/OpalModule.hpp>
+
+#include <asyncpp/join.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <string_view>
+
+
+using namespace sedmgr;
+
+
+static const auto lockingSp = Opal1Module::Get()->FindUid("SP::Locking").value();
+static const auto dataStore = UID(opal::eTable::DataStore);
+
+
+static Bytes ToBytes(std::string_view text) {
+    const auto bytes = std::as_bytes(std::span(text));
+    return { bytes.begin(), bytes.end() };
+}
+
+
+static std::string ToString(std::optional<std::span<const std::byte>> bytes) {
+    REQUIRE(bytes);
+    return { reinterpret_cast<const char*>(bytes->data()), bytes->size() };
+}
+
+
+static size_t CountCalls(const EncryptedDevice& device, core::eMethod method) {
+    const auto snapshot = device.GetMetrics().Snapshot();
+    const auto it = snapshot.methodLatency.find(UID(method));
+    return it != snapshot.methodLatency.end() ? it->second.count : 0;
+}
+
+
+TEST_CASE("DataStore: byte table transfers are split", "[DataStore]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(lockingSp));
+
+    Bytes pattern(mock::SimulationConfig{}.dataStoreSize);
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        pattern[i] = std::byte(i * 7);
+    }
+    const auto setsBefore = CountCalls(device, core::eMethod::Set);
+    join(session.WriteBytes(dataStore, 0, pattern));
+    const auto getsBefore = CountCalls(device, core::eMethod::Get);
+    const auto readBack = join(session.ReadBytes(dataStore, 0, uint32_t(pattern.size())));
+
+    REQUIRE(readBack == pattern);
+    REQUIRE(CountCalls(device, core::eMethod::Set) - setsBefore == 3);
+    REQUIRE(CountCalls(device, core::eMethod::Get) - getsBefore == 3);
+    REQUIRE(join(session.ReadBytes(dataStore, 100, 3)) == Bytes(pattern.begin() + 100, pattern.begin() + 103));
+    REQUIRE_THROWS_AS(join(session.ReadBytes(dataStore, uint32_t(pattern.size()) - 1, 2)), InvalidParameterError);
+}
+
+
+TEST_CASE("DataStore: empty table", "[DataStore]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(lockingSp));
+    auto store = join(DataStore::Load(session));
+
+    REQUIRE(store.Size() == 0);
+    REQUIRE(!store.Get("asset"));
+    // Only the header is written, and only where it differs from the zeroed table.
+    REQUIRE(store.GetDirtyBytes() > 0);
+    REQUIRE(store.GetDirtyBytes() <= 16);
+}
+
+
+TEST_CASE("DataStore: values persist", "[DataStore]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(lockingSp));
+    {
+        auto store = join(DataStore::Load(session));
+        store.Put("asset", ToBytes("A-1234"));
+        store.Put("provisioning", ToBytes("7"));
+        store.Put("pba", ToBytes("sha256:0123456789abcdef"));
+        REQUIRE(store.Erase("provisioning"));
+        REQUIRE(!store.Erase("missing"));
+        join(store.Commit());
+        REQUIRE(store.GetDirtyBytes() == 0);
+    }
+    auto store = join(DataStore::Load(session));
+    REQUIRE(store.Keys() == std::vector<std::string>{ "asset", "pba" });
+    REQUIRE(ToString(store.Get("asset")) == "A-1234");
+    REQUIRE(ToString(store.Get("pba")) == "sha256:0123456789abcdef");
+}
+
+
+TEST_CASE("DataStore: reads are served from the host", "[DataStore]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(lockingSp));
+    auto store = join(DataStore::Load(session));
+    store.Put("asset", ToBytes("A-1234"));
+    join(store.Commit());
+
+    auto loaded = join(DataStore::Load(session));
+    const auto getsBefore = CountCalls(device, core::eMethod::Get);
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(ToString(loaded.Get("asset")) == "A-1234");
+    }
+    REQUIRE(CountCalls(device, core::eMethod::Get) == getsBefore);
+}
+
+
+TEST_CASE("DataStore: commit writes the changed bytes", "[DataStore]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(lockingSp));
+    auto store = join(DataStore::Load(session));
+    store.Put("asset", ToBytes("A-1234"));
+    store.Put("owner", ToBytes("storage-team"));
+    join(store.Commit());
+
+    SECTION("unchanged") {
+        store.Put("asset", ToBytes("A-1234"));
+        REQUIRE(store.GetDirtyBytes() == 0);
+    }
+    SECTION("same size") {
+        store.Put("asset", ToBytes("A-1299"));
+        REQUIRE(store.GetDirtyBytes() == 2);
+        const auto setsBefore = CountCalls(device, core::eMethod::Set);
+        join(store.Commit());
+        REQUIRE(CountCalls(device, core::eMethod::Set) - setsBefore == 1);
+    }
+    SECTION("larger") {
+        store.Put("asset", ToBytes("A-1234-REV2"));
+        // The value is moved, the index entry and header change.
+        REQUIRE(store.GetDirtyBytes() <= 11 + 8 + 4);
+        join(store.Commit());
+    }
+    auto loaded = join(DataStore::Load(session));
+    REQUIRE(ToString(loaded.Get("owner")) == "storage-team");
+    REQUIRE(ToString(loaded.Get("asset")) == ToString(store.Get("asset")));
+}
+
+
+TEST_CASE("DataStore: full table", "[DataStore]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>(mock::SimulationConfig{ .dataStoreSize = 128 })));
+    auto session = join(device.Login(lockingSp));
+    auto store = join(DataStore::Load(session));
+
+    // 16 bytes of header, 10 of index, leaves 102 bytes for the value.
+    SECTION("compaction") {
+        for (size_t length = 10; length <= 100; length += 10) {
+            store.Put("a", Bytes(length, std::byte(length)));
+        }
+        join(store.Commit());
+        auto loaded = join(DataStore::Load(session));
+        REQUIRE(loaded.Get("a")->size() == 100);
+        REQUIRE(std::ranges::all_of(*loaded.Get("a"), [](std::byte b) { return b == std::byte(100); }));
+    }
+    SECTION("insufficient space") {
+        store.Put("a", Bytes(100, std::byte(1)));
+        REQUIRE_THROWS_AS(store.Put("b", Bytes(1, std::byte(2))), InsufficientSpaceError);
+        REQUIRE_THROWS_AS(store.Put("a", Bytes(103, std::byte(3))), InsufficientSpaceError);
+        REQUIRE(store.Size() == 1);
+        REQUIRE(store.Get("a")->size() == 100);
+    }
+}
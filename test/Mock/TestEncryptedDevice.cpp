@@ -0,0 +1,123 @@
+#include <EncryptedDevice/EncryptedDevice.hpp>
+#include <Error/Exception.hpp>
+#include <MockDevice/MockDevice.hpp>
+#include <Specification/Opal/OpalModule.hpp>
+
+#include <asyncpp/join.hpp>
+
+#include <filesystem>
+#include <optional>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+using namespace sedmgr;
+
+
+static const auto lockingSp = Opal1Module::Get()->FindUid("SP::Locking").value();
+static const auto adminSp = Opal1Module::Get()->FindUid("SP::Admin").value();
+
+
+TEST_CASE("EncryptedDevice: StackReset keeps discovery and modules", "[EncryptedDevice]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    const auto modules = &device.GetModules();
+    const auto desc = &device.GetDesc();
+
+    REQUIRE_NOTHROW(join(device.StackReset()));
+    REQUIRE(&device.GetModules() == modules);
+    REQUIRE(&device.GetDesc() == desc);
+    REQUIRE_NOTHROW(join(join(device.Login(lockingSp)).End()));
+}
+
+
+TEST_CASE("EncryptedDevice: StackReset recovers busy SP", "[EncryptedDevice]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto stale = join(device.Login(lockingSp));
+    REQUIRE_THROWS_AS(join(device.Login(lockingSp)), SecurityProviderBusyError);
+
+    join(device.StackReset());
+    auto session = join(device.Login(lockingSp));
+    REQUIRE_NOTHROW(join(session.End()));
+}
+
+
+TEST_CASE("EncryptedDevice: retry policy resets the stack for a busy SP", "[EncryptedDevice]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    device.SetRetryPolicy(RetryPolicy{ .retriesBeforeStackReset = 1, .allowStackReset = true });
+    auto stale = join(device.Login(lockingSp));
+
+    auto session = join(device.Login(lockingSp));
+    const auto snapshot = device.GetMetrics().Snapshot();
+    REQUIRE(snapshot.retryCount == 1);
+    REQUIRE(snapshot.recoveryResetCount == 1);
+    REQUIRE(snapshot.retryExhaustedCount == 0);
+    REQUIRE_NOTHROW(join(session.End()));
+}
+
+
+TEST_CASE("EncryptedDevice: StackReset invalidates sibling sessions", "[EncryptedDevice]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto sibling = join(device.Login(adminSp));
+    join(device.StackReset());
+
+    REQUIRE_THROWS_AS(join(sibling.GetValue(adminSp, 1)), std::runtime_error);
+    auto session = join(device.Login(adminSp));
+    REQUIRE_NOTHROW(join(session.GetValue(adminSp, 1)));
+}
+
+
+TEST_CASE("EncryptedDevice: retry policy gives up", "[EncryptedDevice]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    device.SetRetryPolicy(RetryPolicy{ .maxAttempts = 3, .allowStackReset = false });
+    auto stale = join(device.Login(lockingSp));
+
+    REQUIRE_THROWS_AS(join(device.Login(lockingSp)), SecurityProviderBusyError);
+    const auto snapshot = device.GetMetrics().Snapshot();
+    REQUIRE(snapshot.retryCount == 2);
+    REQUIRE(snapshot.retryExhaustedCount == 1);
+}
+
+
+TEST_CASE("EncryptedDevice: device lock covers the TPer's lifetime", "[EncryptedDevice]") {
+    const auto directory = std::filesystem::temp_directory_path() / "sedmanager-test-device-locks";
+    std::filesystem::remove_all(directory);
+    const auto mock = std::make_shared<MockDevice>();
+    std::optional<EncryptedDevice> device = join(EncryptedDevice::Start(mock, nullptr, directory));
+    REQUIRE(device->GetMetrics().Snapshot().lockWait.count == 1);
+
+    DeviceLock other("MOCK0001", directory);
+    REQUIRE(!other.TryAcquire());
+    {
+        auto locking = join(device->Login(lockingSp));
+        auto admin = join(device->Login(adminSp));
+        join(locking.End());
+        join(admin.End());
+    }
+    REQUIRE(!other.TryAcquire());
+
+    // The lock is released once the stack reset left by the TPer has run.
+    device.reset();
+    join(DrainQueue::ForDevice(*mock)->Flush());
+    REQUIRE(other.TryAcquire());
+    other.Release();
+    std::filesystem::remove_all(directory);
+}
+
+
+TEST_CASE("EncryptedDevice: gives up waiting for the device lock", "[EncryptedDevice]") {
+    using namespace std::chrono_literals;
+
+    const auto directory = std::filesystem::temp_directory_path() / "sedmanager-test-device-locks";
+    std::filesystem::remove_all(directory);
+    const auto mock = std::make_shared<MockDevice>();
+    {
+        DeviceLock other("MOCK0001", directory);
+        REQUIRE(other.TryAcquire());
+        REQUIRE_THROWS_AS(join(EncryptedDevice::Start(mock, nullptr, directory, CancellationToken::After(20ms))), DeviceError);
+    }
+    // The waiter that gave up is off the queue, so it doesn't block the next one.
+    DeviceLock next("MOCK0001", directory);
+    REQUIRE(next.TryAcquire());
+    next.Release();
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,100 @@
+#include <EncryptedDevice/EncryptedDevice.hpp>
+#include <EncryptedDevice/LockingRanges.hpp>
+#include <Error/Exception.hpp>
+#include <MockDevice/MockDevice.hpp>
+#include <Specification/Core/Defs/UIDs.hpp>
+#include <Specification/Opal/OpalModule.hpp>
+
+#include <asyncpp/join.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <format>
+#include <stdexcept>
+
+
+using namespace sedmgr;
+
+
+static const auto lockingSp = Opal1Module::Get()->FindUid("SP::Locking").value();
+static const auto range1 = Opal1Module::Get()->FindUid("Locking::Range1", lockingSp).value();
+static const auto range2 = Opal1Module::Get()->FindUid("Locking::Range2", lockingSp).value();
+
+
+static GeometryFeatureDesc MakeGeometry(uint64_t granularity, uint64_t lowestAligned) {
+    return {
+        .alignmentRequired = true,
+        .logicalBlockSize = 512,
+        .alignmentGranularity = granularity,
+        .lowestAlignedLba = lowestAligned,
+    };
+}
+
+
+TEST_CASE("LockingRanges: plan without geometry", "[LockingRanges]") {
+    const auto extents = PlanLockingRanges(std::nullopt, 10, 3);
+    REQUIRE(extents == std::vector<LockingRangeExtent>{ { 0, 4 }, { 4, 3 }, { 7, 3 } });
+}
+
+
+TEST_CASE("LockingRanges: plan aligned", "[LockingRanges]") {
+    SECTION("granularity") {
+        const auto extents = PlanLockingRanges(MakeGeometry(8, 0), 100, 3);
+        // 12 whole units, the last 4 blocks are left to the global range.
+        REQUIRE(extents == std::vector<LockingRangeExtent>{ { 0, 32 }, { 32, 32 }, { 64, 32 } });
+    }
+    SECTION("lowest aligned LBA") {
+        const auto extents = PlanLockingRanges(MakeGeometry(8, 7), 100, 2);
+        REQUIRE(extents == std::vector<LockingRangeExtent>{ { 7, 48 }, { 55, 40 } });
+    }
+    SECTION("lowest aligned LBA beyond granularity") {
+        REQUIRE(PlanLockingRanges(MakeGeometry(8, 15), 100, 2) == PlanLockingRanges(MakeGeometry(8, 7), 100, 2));
+    }
+    SECTION("does not fit") {
+        REQUIRE_THROWS_AS(PlanLockingRanges(MakeGeometry(8, 0), 20, 3), std::invalid_argument);
+        REQUIRE_THROWS_AS(PlanLockingRanges(MakeGeometry(8, 0), 20, 0), std::invalid_argument);
+    }
+}
+
+
+TEST_CASE("LockingRanges: mock discovery", "[LockingRanges]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>(mock::SimulationConfig{ .alignmentRequired = true, .logicalBlockSize = 4096, .alignmentGranularity = 16, .lowestAlignedLba = 3 })));
+    const auto& geometry = device.GetDesc().geometryDesc;
+    REQUIRE(geometry);
+    REQUIRE(geometry->alignmentRequired == true);
+    REQUIRE(geometry->logicalBlockSize == 4096);
+    REQUIRE(geometry->alignmentGranularity == 16);
+    REQUIRE(geometry->lowestAlignedLba == 3);
+}
+
+
+TEST_CASE("LockingRanges: apply", "[LockingRanges]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>(mock::SimulationConfig{ .alignmentRequired = true, .alignmentGranularity = 8 })));
+    auto session = join(device.Login(lockingSp));
+
+    SECTION("aligned") {
+        const auto extents = PlanLockingRanges(device.GetDesc().geometryDesc, 16384, 4);
+        join(ApplyLockingRanges(session, extents));
+        for (size_t index = 0; index < extents.size(); ++index) {
+            const auto range = Opal1Module::Get()->FindUid(std::format("Locking::Range{}", index + 1), lockingSp).value();
+            REQUIRE(join(session.GetValue(range, 3)).Get<uint64_t>() == extents[index].rangeStart);
+            REQUIRE(join(session.GetValue(range, 4)).Get<uint64_t>() == extents[index].rangeLength);
+        }
+    }
+    SECTION("misaligned") {
+        const std::vector<LockingRangeExtent> extents = { { 0, 8 }, { 8, 5 } };
+        REQUIRE_THROWS_AS(join(ApplyLockingRanges(session, extents)), InvalidParameterError);
+        // The transaction is rolled back, so the aligned range is not changed either.
+        REQUIRE(join(session.GetValue(range1, 4)).Get<uint64_t>() == 0);
+        REQUIRE(join(session.GetValue(range2, 4)).Get<uint64_t>() == 0);
+    }
+}
+
+
+TEST_CASE("LockingRanges: global range is not checked for alignment", "[LockingRanges]") {
+    const auto globalRange = Opal1Module::Get()->FindUid("Locking::GlobalRange", lockingSp).value();
+    // The global range's length of 16384 is not a multiple of 3.
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>(mock::SimulationConfig{ .alignmentRequired = true, .alignmentGranularity = 3 })));
+    auto session = join(device.Login(lockingSp));
+    REQUIRE_NOTHROW(join(session.SetValue(globalRange, 5, true)));
+}
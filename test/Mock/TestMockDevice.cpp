@@ -0,0 +1,144 @@
+#include <EncryptedDevice/EncryptedDevice.hpp>
+#include <MockDevice/MockDevice.hpp>
+#include <Specification/Core/Defs/UIDs.hpp>
+#include <Specification/Opal/OpalModule.hpp>
+#include <TrustedPeripheral/Session.hpp>
+
+#include <asyncpp/join.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <format>
+#include <random>
+#include <thread>
+
+
+using namespace sedmgr;
+using namespace std::chrono_literals;
+
+
+static const auto mockAdminSp = Opal1Module::Get()->FindUid("SP::Admin").value();
+
+
+TEST_CASE("MockDevice: method latency", "[MockDevice]") {
+    mock::SimulationConfig config;
+    config.methodLatencyOverrides.insert_or_assign(UID(core::eMethod::Get), mock::LatencyDistribution::Constant(5ms));
+    const auto device = std::make_shared<MockDevice>(config);
+    const auto tper = std::make_shared<TrustedPeripheral>(device);
+    const auto sessionManager = std::make_shared<SessionManager>(tper);
+    const auto session = std::make_shared<Session>(sessionManager, mockAdminSp);
+    tper->GetMetrics()->Reset();
+
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE_NOTHROW(join(session->base.Get(mockAdminSp, 0)));
+    REQUIRE(std::chrono::steady_clock::now() - start >= 5ms);
+
+    const auto snapshot = tper->GetMetrics()->Snapshot();
+    REQUIRE(snapshot.exchangeCount == 1);
+    REQUIRE(snapshot.pollCount > 1);
+}
+
+
+TEST_CASE("MockDevice: IF-RECV latency", "[MockDevice]") {
+    mock::SimulationConfig config;
+    config.ifRecvLatency = mock::LatencyDistribution::Constant(2ms);
+    const auto device = std::make_shared<MockDevice>(config);
+    const auto tper = std::make_shared<TrustedPeripheral>(device);
+    const auto sessionManager = std::make_shared<SessionManager>(tper);
+
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE_NOTHROW(join(sessionManager->Properties()));
+    REQUIRE(std::chrono::steady_clock::now() - start >= 2ms);
+}
+
+
+TEST_CASE("MockDevice: latency distributions", "[MockDevice]") {
+    std::mt19937_64 rne(0);
+    REQUIRE(mock::LatencyDistribution().Sample(rne) == 0ns);
+    REQUIRE(mock::LatencyDistribution::Constant(3ms).Sample(rne) == 3ms);
+    for (int i = 0; i < 100; ++i) {
+        const auto uniform = mock::LatencyDistribution::Uniform(1ms, 2ms).Sample(rne);
+        REQUIRE(uniform >= 1ms);
+        REQUIRE(uniform <= 2ms);
+        REQUIRE(mock::LatencyDistribution::Exponential(1ms).Sample(rne) >= 0ns);
+    }
+}
+
+
+TEST_CASE("MockDevice: single session per SP", "[MockDevice]") {
+    const auto device = std::make_shared<MockDevice>();
+    const auto tper = std::make_shared<TrustedPeripheral>(device);
+    const auto sessionManager = std::make_shared<SessionManager>(tper);
+    REQUIRE_NOTHROW(join(sessionManager->StartSession(100, mockAdminSp, true)));
+    REQUIRE_THROWS(join(sessionManager->StartSession(101, mockAdminSp, true)));
+}
+
+
+TEST_CASE("MockDevice: dynamic ComIDs", "[MockDevice]") {
+    mock::SimulationConfig config;
+    config.dynamicComIds = true;
+    config.maxSessionsPerSp = 2;
+    const auto device = std::make_shared<MockDevice>(config);
+    const auto first = std::make_shared<TrustedPeripheral>(device);
+    const auto second = std::make_shared<TrustedPeripheral>(device);
+    REQUIRE(first->GetComId() != second->GetComId());
+
+    const auto firstSession = std::make_shared<Session>(std::make_shared<SessionManager>(first), mockAdminSp);
+    const auto secondSession = std::make_shared<Session>(std::make_shared<SessionManager>(second), mockAdminSp);
+    REQUIRE(value_cast<UID>(join(firstSession->base.Get(mockAdminSp, 0))) == mockAdminSp);
+    REQUIRE(value_cast<UID>(join(secondSession->base.Get(mockAdminSp, 0))) == mockAdminSp);
+}
+
+
+TEST_CASE("MockDevice: sessions are counted across ComIDs", "[MockDevice]") {
+    mock::SimulationConfig config;
+    config.dynamicComIds = true;
+    const auto device = std::make_shared<MockDevice>(config);
+    const auto first = std::make_shared<SessionManager>(std::make_shared<TrustedPeripheral>(device));
+    const auto second = std::make_shared<SessionManager>(std::make_shared<TrustedPeripheral>(device));
+
+    const auto session = join(first->StartSession(100, mockAdminSp, true));
+    REQUIRE(session.spSessionId == 5000);
+    REQUIRE_THROWS(join(second->StartSession(101, mockAdminSp, true)));
+
+    join(first->EndSession(session.spSessionId, session.hostSessionId));
+    REQUIRE(join(second->StartSession(101, mockAdminSp, true)).spSessionId == 5001);
+}
+
+
+TEST_CASE("MockDevice: hundreds of drives", "[MockDevice]") {
+    constexpr size_t numDrives = 200;
+    constexpr size_t numThreads = 8;
+
+    std::vector<std::shared_ptr<MockDevice>> devices;
+    for (size_t i = 0; i < numDrives; ++i) {
+        mock::SimulationConfig config;
+        config.serial = std::format("MOCK{:04}", i);
+        config.methodLatency = mock::LatencyDistribution::Uniform(0us, 200us);
+        config.seed = i;
+        devices.push_back(std::make_shared<MockDevice>(config));
+    }
+
+    std::atomic_size_t next = 0;
+    std::atomic_size_t succeeded = 0;
+    {
+        std::vector<std::jthread> threads;
+        for (size_t t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&] {
+                for (auto index = next++; index < numDrives; index = next++) {
+                    try {
+                        auto device = join(EncryptedDevice::Start(devices[index]));
+                        auto session = join(device.Login(mockAdminSp));
+                        const auto uid = value_cast<UID>(join(session.GetValue(mockAdminSp, 0)));
+                        join(session.End());
+                        succeeded += uid == mockAdminSp;
+                    }
+                    catch (std::exception&) {
+                    }
+                }
+            });
+        }
+    }
+    REQUIRE(succeeded == numDrives);
+}
@@ -0,0 +1,62 @@
+#include <Error/Exception.hpp>
+#include <MockDevice/MockDevice.hpp>
+#include <TrustedPeripheral/Probe.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+
+
+using namespace sedmgr;
+
+
+class CountingDevice : public MockDevice {
+public:
+    void SecuritySend(uint8_t securityProtocol,
+                      std::span<const std::byte, 2> protocolSpecific,
+                      std::span<const std::byte> data) override {
+        ++sendCount;
+        MockDevice::SecuritySend(securityProtocol, protocolSpecific, data);
+    }
+
+    std::atomic_size_t sendCount = 0;
+};
+
+
+TEST_CASE("Probe: discovery only", "[Probe]") {
+    const auto first = std::make_shared<CountingDevice>();
+    const auto second = std::make_shared<CountingDevice>();
+    const auto results = ProbeDevices({ first, nullptr, second });
+
+    REQUIRE(results.size() == 3);
+    for (const auto index : { 0, 2 }) {
+        REQUIRE(!results[index].error);
+        REQUIRE(results[index].desc);
+        REQUIRE(results[index].desc->lockingDesc);
+        REQUIRE(results[index].desc->sscDescs.size() == 1);
+    }
+    REQUIRE(results[1].error);
+    REQUIRE(!results[1].desc);
+    REQUIRE(first->sendCount == 0);
+    REQUIRE(second->sendCount == 0);
+}
+
+
+TEST_CASE("Probe: open in parallel", "[Probe]") {
+    const std::vector<StorageDeviceLabel> labels = {
+        { "mock0", eStorageDeviceInterface::OTHER },
+        { "missing", eStorageDeviceInterface::OTHER },
+        { "mock1", eStorageDeviceInterface::OTHER },
+    };
+    const auto results = ProbeDevices(labels, [](const StorageDeviceLabel& label) -> std::shared_ptr<StorageDevice> {
+        if (label.path == "missing") {
+            throw DeviceError("no such device");
+        }
+        return std::make_shared<MockDevice>();
+    });
+
+    REQUIRE(results.size() == 3);
+    REQUIRE(results[0].desc);
+    REQUIRE(results[1].error == "no such device");
+    REQUIRE(results[2].desc);
+}
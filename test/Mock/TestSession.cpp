@@ -1,14 +1,24 @@
+#include <Error/Exception.hpp>
 #include <MockDevice/MockDevice.hpp>
 #include <Specification/Core/CoreModule.hpp>
 #include <Specification/Opal/OpalModule.hpp>
+#include <TrustedPeripheral/DrainQueue.hpp>
 #include <TrustedPeripheral/Session.hpp>
 
 #include <asyncpp/join.hpp>
+#include <asyncpp/sleep.hpp>
 
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
 
 using namespace sedmgr;
 using namespace std::string_view_literals;
+using namespace std::chrono_literals;
 
 
 const auto adminSpUid = Opal1Module::Get()->FindUid("SP::Admin").value();
@@ -56,6 +66,20 @@ TEST_CASE_METHOD(AdminSessionFixture, "Session: Get", "Session") {
 }
 
 
+TEST_CASE("Session: Get result columns out of range", "Session") {
+    const List inRange = { Named(uint32_t(1), Value(uint32_t(10))), Named(uint32_t(2), Value(uint32_t(20))) };
+    const auto values = impl::UnlabelColumns(inRange, 1, 3);
+    REQUIRE(values.size() == 2);
+    REQUIRE(values[1].Get<uint32_t>() == 20);
+
+    // The first column past the range used to be written past the end.
+    const List pastEnd = { Named(uint32_t(3), Value(uint32_t(30))) };
+    REQUIRE_THROWS_AS(impl::UnlabelColumns(pastEnd, 1, 3), InvalidResponseError);
+    const List beforeStart = { Named(uint32_t(0), Value(uint32_t(0))) };
+    REQUIRE_THROWS_AS(impl::UnlabelColumns(beforeStart, 1, 3), InvalidResponseError);
+}
+
+
 TEST_CASE_METHOD(AdminSessionFixture, "Session: Set", "Session") {
     REQUIRE_NOTHROW(join(session->base.Set(adminSpUid, 2, value_cast("Stan"sv))));
     REQUIRE(value_cast<std::string_view>(join(session->base.Get(adminSpUid, 2))) == "Stan"sv);
@@ -93,4 +117,200 @@ TEST_CASE_METHOD(AdminSessionFixture, "Session: Revert", "Session") {
 
 TEST_CASE_METHOD(AdminSessionFixture, "Session: Activate", "Session") {
     REQUIRE_NOTHROW(join(session->opal.Activate(lockingSpUid)));
-}
\ No newline at end of file
+}
+
+TEST_CASE_METHOD(AdminSessionFixture, "Session: Transaction", "Session") {
+    const bool negotiateProperties = GENERATE(true, false);
+    if (negotiateProperties) {
+        join(sessionManager->Properties());
+    }
+    const auto original = join(session->base.Get(lockingSpUid, 2));
+
+    SECTION("commit") {
+        auto transaction = session->StartTransaction();
+        transaction.Set(adminSpUid, 2, value_cast("Stan"sv));
+        transaction.Set(lockingSpUid, 2, value_cast("Kyle"sv));
+        transaction.Set(adminSpUid, 2, value_cast("Eric"sv));
+        REQUIRE(transaction.Size() == 2);
+        REQUIRE_NOTHROW(join(transaction.Commit()));
+        REQUIRE(value_cast<std::string_view>(join(session->base.Get(adminSpUid, 2))) == "Eric"sv);
+        REQUIRE(value_cast<std::string_view>(join(session->base.Get(lockingSpUid, 2))) == "Kyle"sv);
+    }
+    SECTION("abort") {
+        auto transaction = session->StartTransaction();
+        transaction.Set(lockingSpUid, 2, value_cast("Kyle"sv));
+        transaction.Abort();
+        REQUIRE_NOTHROW(join(transaction.Commit()));
+        REQUIRE(join(session->base.Get(lockingSpUid, 2)) == original);
+    }
+    SECTION("failure") {
+        auto transaction = session->StartTransaction();
+        transaction.Set(lockingSpUid, 2, value_cast("Kyle"sv));
+        transaction.Set(adminSpUid, 1000, value_cast("Eric"sv));
+        REQUIRE_THROWS_AS(join(transaction.Commit()), InvalidParameterError);
+        REQUIRE(join(session->base.Get(lockingSpUid, 2)) == original);
+
+        // The updates are kept for another attempt.
+        REQUIRE(transaction.Size() == 2);
+        transaction.Abort();
+        transaction.Set(lockingSpUid, 2, value_cast("Kyle"sv));
+        REQUIRE_NOTHROW(join(transaction.Commit()));
+        REQUIRE(transaction.Size() == 0);
+        REQUIRE(value_cast<std::string_view>(join(session->base.Get(lockingSpUid, 2))) == "Kyle"sv);
+    }
+}
+
+
+TEST_CASE("Session: destruction doesn't block", "Session") {
+    constexpr int count = 100;
+    constexpr auto recvLatency = 1ms;
+
+    mock::SimulationConfig config;
+    config.ifRecvLatency = mock::LatencyDistribution::Constant(recvLatency);
+    config.maxSessionsPerSp = count;
+    const auto device = std::make_shared<MockDevice>(config);
+    const auto tper = std::make_shared<TrustedPeripheral>(device);
+    const auto sessionManager = std::make_shared<SessionManager>(tper);
+
+    std::vector<Session> sessions;
+    for (int i = 0; i < count; ++i) {
+        sessions.push_back(join(Session::Start(sessionManager, adminSpUid)));
+    }
+
+    // Ending them in place would take at least one IF-RECV each.
+    const auto start = std::chrono::steady_clock::now();
+    sessions.clear();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    REQUIRE(elapsed < count * recvLatency / 2);
+
+    join(tper->GetDrainQueue()->Flush());
+    REQUIRE(tper->GetDrainQueue()->Pending() == 0);
+    for (int i = 0; i < count; ++i) {
+        REQUIRE_NOTHROW(sessions.push_back(join(Session::Start(sessionManager, adminSpUid))));
+    }
+    for (auto& session : sessions) {
+        REQUIRE_NOTHROW(join(session.Close()));
+    }
+}
+
+
+TEST_CASE("Session: drain queue runs one job at a time", "Session") {
+    const auto queue = std::make_shared<DrainQueue>();
+    std::mutex mutex;
+    std::vector<int> order;
+    std::atomic_int active = 0;
+    std::atomic_int maxActive = 0;
+    const auto job = [&](int id) {
+        return [&, id]() -> asyncpp::task<void> {
+            maxActive = std::max(maxActive.load(), ++active);
+            std::this_thread::sleep_for(5ms);
+            {
+                std::lock_guard lk(mutex);
+                order.push_back(id);
+            }
+            --active;
+            co_return;
+        };
+    };
+    for (int i = 0; i < 8; ++i) {
+        queue->Post(job(i));
+    }
+    // The worker has likely started, and the caller must not run jobs alongside it.
+    join(queue->Flush());
+    REQUIRE(queue->Pending() == 0);
+    REQUIRE(maxActive == 1);
+    REQUIRE(order == std::vector{ 0, 1, 2, 3, 4, 5, 6, 7 });
+}
+
+
+TEST_CASE("Session: transaction cancelled between batches", "Session") {
+    // Without exchanged properties, each batch holds one method. Each IF-RECV
+    // blocks, so the first batch completes past the deadline, and the second
+    // one is cancelled before it's sent.
+    mock::SimulationConfig config;
+    config.ifRecvLatency = mock::LatencyDistribution::Constant(40ms);
+    const auto device = std::make_shared<MockDevice>(config);
+    const auto tper = std::make_shared<TrustedPeripheral>(device);
+    const auto sessionManager = std::make_shared<SessionManager>(tper);
+    auto session = join(Session::Start(sessionManager, adminSpUid));
+    const auto originalName = value_cast<std::string>(join(session.base.Get(adminSpUid, 2)));
+
+    session.SetCancellation(CancellationToken::After(20ms));
+    auto transaction = session.StartTransaction();
+    transaction.Set(adminSpUid, 2, value_cast("Stan"sv));
+    transaction.Set(lockingSpUid, 2, value_cast("Stan"sv));
+    REQUIRE_THROWS_AS(join(transaction.Commit()), CancelledError);
+    REQUIRE(tper->GetResetCount() == 0);
+
+    // The open transaction was aborted, so the first batch was rolled back and
+    // the session works as before.
+    session.SetCancellation({});
+    REQUIRE(value_cast<std::string>(join(session.base.Get(adminSpUid, 2))) == originalName);
+    REQUIRE_NOTHROW(join(session.base.Set(adminSpUid, 2, value_cast("Stan"sv))));
+    REQUIRE_NOTHROW(join(session.Close()));
+}
+
+
+TEST_CASE("Session: drain queue flush waits for a suspended job", "Session") {
+    const auto queue = std::make_shared<DrainQueue>();
+    std::atomic_bool started = false;
+    std::atomic_bool finished = false;
+    queue->Post([&]() -> asyncpp::task<void> {
+        started = true;
+        // Resumes on another thread than the one that started the job.
+        co_await asyncpp::sleep_for(20ms);
+        finished = true;
+    });
+    while (!started) {
+        std::this_thread::sleep_for(1ms);
+    }
+    join(queue->Flush());
+    REQUIRE(finished);
+    REQUIRE(queue->Pending() == 0);
+}
+
+
+TEST_CASE("Session: cancellation", "Session") {
+    mock::SimulationConfig config;
+    config.methodLatencyOverrides[UID(core::eMethod::Get)] = mock::LatencyDistribution::Constant(500ms);
+    const auto device = std::make_shared<MockDevice>(config);
+    const auto tper = std::make_shared<TrustedPeripheral>(device);
+    const auto sessionManager = std::make_shared<SessionManager>(tper);
+    auto session = join(Session::Start(sessionManager, adminSpUid));
+
+    SECTION("before sending") {
+        const auto cancellation = CancellationToken::Manual();
+        cancellation.Cancel();
+        session.SetCancellation(cancellation);
+        REQUIRE_THROWS_AS(join(session.base.Next(tableTableUid, {})), CancelledError);
+        REQUIRE(tper->GetResetCount() == 0);
+
+        session.SetCancellation({});
+        REQUIRE_NOTHROW(join(session.base.Next(tableTableUid, {})));
+        REQUIRE_NOTHROW(join(session.Close()));
+    }
+    SECTION("while the response is due") {
+        session.SetCancellation(CancellationToken::After(20ms));
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE_THROWS_AS(join(session.base.Get(adminSpUid, 0)), CancelledError);
+        REQUIRE(std::chrono::steady_clock::now() - start < 500ms);
+        REQUIRE(tper->GetResetCount() == 1);
+
+        // The stack reset aborted the session, so the SP is free again.
+        auto next = join(Session::Start(sessionManager, adminSpUid));
+        REQUIRE_NOTHROW(join(next.base.Next(tableTableUid, {})));
+        REQUIRE_NOTHROW(join(next.Close()));
+        REQUIRE_NOTHROW(join(session.Close()));
+    }
+
+    SECTION("transaction") {
+        const auto cancellation = CancellationToken::Manual();
+        cancellation.Cancel();
+        session.SetCancellation(cancellation);
+        auto transaction = session.StartTransaction();
+        transaction.Set(adminSpUid, 2, value_cast("Stan"sv));
+        REQUIRE_THROWS_AS(join(transaction.Commit()), CancelledError);
+        REQUIRE(tper->GetResetCount() == 0);
+        REQUIRE_NOTHROW(join(session.Close()));
+    }
+}
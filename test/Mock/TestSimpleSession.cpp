@@ -0,0 +1,199 @@
+#include <EncryptedDevice/EncryptedDevice.hpp>
+#include <Error/Exception.hpp>
+#include <MockDevice/MockDevice.hpp>
+#include <Specification/Core/CoreModule.hpp>
+#include <Specification/Core/Defs/TableRows.hpp>
+#include <Specification/Core/Defs/UIDs.hpp>
+#include <Specification/Opal/OpalModule.hpp>
+
+#include <asyncpp/join.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <set>
+
+
+using namespace sedmgr;
+
+
+static const auto adminSp = Opal1Module::Get()->FindUid("SP::Admin").value();
+static const auto lockingSp = Opal1Module::Get()->FindUid("SP::Locking").value();
+
+
+static asyncpp::task<std::vector<UID>> CollectRows(SimpleSession& session, UID table) {
+    std::vector<UID> rows;
+    auto stream = session.GetTableRows(table);
+    while (const auto row = co_await stream) {
+        rows.push_back(*row);
+    }
+    co_return rows;
+}
+
+
+TEST_CASE("SimpleSession: GetTableRows batches Next", "[SimpleSession]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(adminSp));
+    const auto before = device.GetMetrics().Snapshot();
+
+    const auto rows = join(CollectRows(session, UID(core::eTable::Table)));
+    const auto after = device.GetMetrics().Snapshot();
+
+    REQUIRE(rows.size() > 2);
+    REQUIRE(std::set(rows.begin(), rows.end()).size() == rows.size());
+    const auto nextCalls = after.methodLatency.at(UID(core::eMethod::Next)).count -
+                           (before.methodLatency.contains(UID(core::eMethod::Next)) ? before.methodLatency.at(UID(core::eMethod::Next)).count : 0);
+    REQUIRE(nextCalls == 2);
+}
+
+
+TEST_CASE("SimpleSession: GetTableRows lists SPs", "[SimpleSession]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(adminSp));
+    const auto rows = join(CollectRows(session, UID(core::eTable::SP)));
+    REQUIRE(std::ranges::find(rows, adminSp) != rows.end());
+    REQUIRE(std::ranges::find(rows, lockingSp) != rows.end());
+}
+
+
+TEST_CASE("SimpleSession: GetObjectValues", "[SimpleSession]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(adminSp));
+    const auto columnCount = device.GetModules().FindTable(UID(core::eTable::SP))->columns.size();
+
+    const auto values = join(session.GetObjectValues(adminSp));
+    REQUIRE(values.size() == columnCount);
+    REQUIRE(value_cast<UID>(values[0]) == adminSp);
+    REQUIRE(value_cast<std::string>(values[1]) == "Admin");
+}
+
+
+TEST_CASE("SimpleSession: GetRow", "[SimpleSession]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(lockingSp));
+    const auto globalRange = Opal1Module::Get()->FindUid("Locking::GlobalRange", lockingSp).value();
+    const auto globalKey = Opal1Module::Get()->FindUid("K_AES_256::GlobalRange", lockingSp).value();
+
+    SECTION("fields") {
+        const auto getsBefore = device.GetMetrics().Snapshot().methodLatency[UID(core::eMethod::Get)].count;
+        const auto row = join(session.GetRow<core::LockingRow>(globalRange,
+                                                               &core::LockingRow::readLocked,
+                                                               &core::LockingRow::rangeLength,
+                                                               &core::LockingRow::activeKey));
+        REQUIRE(device.GetMetrics().Snapshot().methodLatency[UID(core::eMethod::Get)].count == getsBefore + 1);
+        REQUIRE(row.readLocked == false);
+        REQUIRE(row.rangeLength == 16384);
+        REQUIRE(row.activeKey == globalKey);
+        REQUIRE(!row.name);
+        REQUIRE(!row.writeLocked);
+    }
+    SECTION("all columns") {
+        const auto row = join(session.GetRow<core::LockingRow>(globalRange));
+        REQUIRE(row.name == "GlobalRange");
+        REQUIRE(!row.commonName);
+        REQUIRE(row.rangeStart == 0);
+        REQUIRE(row.writeLocked == false);
+        REQUIRE(row.activeKey == globalKey);
+    }
+}
+
+
+TEST_CASE("SimpleSession: TryGetObjectValues", "[SimpleSession]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(adminSp));
+    const auto globalRange = 0x0000'0802'0000'0001_uid; // Not in the Admin SP.
+    const std::vector<CellRange> ranges = {
+        {adminSp,      1, 2},
+        { globalRange, 3, 5},
+        { lockingSp,   0, 3},
+    };
+
+    const auto exchangesBefore = device.GetMetrics().Snapshot().exchangeCount;
+    const auto results = join(session.TryGetObjectValues(ranges));
+    REQUIRE(device.GetMetrics().Snapshot().exchangeCount - exchangesBefore == 1);
+    REQUIRE(results.size() == 3);
+    REQUIRE(results[0]);
+    REQUIRE(value_cast<std::string>(results[0]->at(0)) == "Admin");
+    REQUIRE(!results[1]);
+    REQUIRE(results[1].error().Is(eMethodStatus::INVALID_PARAMETER));
+    REQUIRE(results[2]);
+    REQUIRE(results[2]->size() == 3);
+    REQUIRE(value_cast<UID>(results[2]->at(0)) == lockingSp);
+    REQUIRE(value_cast<std::string>(results[2]->at(1)) == "Locking");
+}
+
+
+TEST_CASE("SimpleSession: TryGetValue / TrySetValue", "[SimpleSession]") {
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(adminSp));
+
+    SECTION("success") {
+        const auto value = join(session.TryGetValue(adminSp, 1));
+        REQUIRE(value);
+        REQUIRE(value_cast<std::string>(*value) == "Admin");
+    }
+    SECTION("failure status is returned") {
+        const auto globalRange = 0x0000'0802'0000'0001_uid; // Not in the Admin SP.
+        const auto result = join(session.TrySetValue(globalRange, 7, false));
+        REQUIRE(!result);
+        REQUIRE(result.error().Is(eMethodStatus::INVALID_PARAMETER));
+        REQUIRE_THROWS_AS(result.error().Throw("Set"), InvalidParameterError);
+    }
+}
+
+
+static uint64_t CountSets(const EncryptedDevice& device) {
+    const auto snapshot = device.GetMetrics().Snapshot();
+    const auto it = snapshot.methodLatency.find(UID(core::eMethod::Set));
+    return it != snapshot.methodLatency.end() ? it->second.count : 0;
+}
+
+
+TEST_CASE("SimpleSession: write-behind", "[SimpleSession]") {
+    using namespace std::string_view_literals;
+
+    auto device = join(EncryptedDevice::Start(std::make_shared<MockDevice>()));
+    auto session = join(device.Login(adminSp));
+    session.SetWriteBehind(true);
+    const auto setsBefore = CountSets(device);
+
+    SECTION("merged and flushed on read") {
+        join(session.SetValue(adminSp, 1, value_cast("Name"sv)));
+        join(session.SetValue(adminSp, 2, value_cast("Org"sv)));
+        REQUIRE(CountSets(device) == setsBefore);
+        REQUIRE(value_cast<std::string>(join(session.GetValue(adminSp, 2))) == "Org");
+        REQUIRE(value_cast<std::string>(join(session.GetValue(adminSp, 1))) == "Name");
+        REQUIRE(CountSets(device) == setsBefore + 1);
+    }
+    SECTION("failures") {
+        const auto globalRange = 0x0000'0802'0000'0001_uid; // Not in the Admin SP.
+        join(session.SetValue(globalRange, 7, false));
+        join(session.SetValue(globalRange, 8, false));
+        const auto failures = join(session.TryFlush());
+        REQUIRE(failures.size() == 2);
+        REQUIRE(failures[0].column == 7);
+        REQUIRE(failures[1].column == 8);
+        REQUIRE(failures[0].error.Is(eMethodStatus::INVALID_PARAMETER));
+        REQUIRE(CountSets(device) == setsBefore + 1);
+    }
+    SECTION("isolated failures") {
+        const auto globalRange = 0x0000'0802'0000'0001_uid;
+        join(session.SetValue(globalRange, 7, false));
+        join(session.SetValue(globalRange, 8, false));
+        const auto failures = join(session.TryFlush(true));
+        REQUIRE(failures.size() == 2);
+        REQUIRE(CountSets(device) == setsBefore + 3);
+    }
+    SECTION("flushed before a transaction") {
+        join(session.SetValue(adminSp, 2, value_cast("Org"sv)));
+        auto transaction = join(session.StartTransaction());
+        transaction.Set(adminSp, 2, value_cast("Transaction"sv));
+        join(transaction.Commit());
+        REQUIRE(value_cast<std::string>(join(session.GetValue(adminSp, 2))) == "Transaction");
+    }
+    SECTION("flushed on End") {
+        join(session.SetValue(adminSp, 2, value_cast("Org"sv)));
+        join(session.End());
+        REQUIRE(CountSets(device) == setsBefore + 1);
+    }
+}
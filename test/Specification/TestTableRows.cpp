@@ -0,0 +1,38 @@
+#include <Specification/Core/CoreModule.hpp>
+#include <Specification/Core/Defs/TableRows.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <tuple>
+
+
+using namespace sedmgr;
+
+
+template <TableRow Row>
+static void CheckColumns() {
+    const auto table = CoreModule::Get()->FindTable(UID(Row::table));
+    REQUIRE(table);
+    const auto check = [&](const auto& column) {
+        INFO(column.name);
+        REQUIRE(column.index < table->columns.size());
+        REQUIRE(table->columns[column.index].name == column.name);
+    };
+    std::apply([&](const auto&... columns) { (check(columns), ...); }, Row::Columns());
+}
+
+
+TEST_CASE("TableRows: columns match table descriptions", "[TableRows]") {
+    CheckColumns<core::AuthorityRow>();
+    CheckColumns<core::C_PINRow>();
+    CheckColumns<core::LockingRow>();
+    CheckColumns<core::MBRControlRow>();
+}
+
+
+TEST_CASE("TableRows: column of field", "[TableRows]") {
+    STATIC_REQUIRE(ColumnOf<&core::LockingRow::rangeStart> == 3);
+    STATIC_REQUIRE(ColumnOf<&core::LockingRow::readLocked> == 7);
+    STATIC_REQUIRE(ColumnOf<&core::AuthorityRow::credential> == 10);
+    STATIC_REQUIRE(ColumnOf<&core::MBRControlRow::done> == 2);
+}
@@ -0,0 +1,72 @@
+#include <Error/Exception.hpp>
+#include <StorageDevice/DeviceLock.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+
+using namespace sedmgr;
+using namespace std::chrono_literals;
+
+
+struct LockDirectoryFixture {
+    LockDirectoryFixture() {
+        std::filesystem::remove_all(directory);
+    }
+    ~LockDirectoryFixture() {
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+    }
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "sedmanager-test-locks";
+};
+
+
+TEST_CASE_METHOD(LockDirectoryFixture, "DeviceLock: exclusive", "[DeviceLock]") {
+    DeviceLock first("SERIAL0001", directory);
+    DeviceLock second("SERIAL0001", directory);
+    DeviceLock other("SERIAL0002", directory);
+
+    REQUIRE(first.TryAcquire());
+    REQUIRE(!second.TryAcquire());
+    REQUIRE(other.TryAcquire());
+    first.Release();
+    REQUIRE(second.TryAcquire());
+    REQUIRE(!first.TryAcquire());
+}
+
+
+TEST_CASE_METHOD(LockDirectoryFixture, "DeviceLock: waiters are served in order", "[DeviceLock]") {
+    DeviceLock holder("SERIAL0001", directory);
+    DeviceLock early("SERIAL0001", directory);
+    DeviceLock late("SERIAL0001", directory);
+
+    REQUIRE(holder.TryAcquire());
+    REQUIRE(!early.TryAcquire());
+    REQUIRE(!late.TryAcquire());
+    holder.Release();
+    REQUIRE(!late.TryAcquire());
+    REQUIRE(early.TryAcquire());
+    early.Release();
+    REQUIRE(late.TryAcquire());
+}
+
+
+TEST_CASE_METHOD(LockDirectoryFixture, "DeviceLock: waiters of dead processes are skipped", "[DeviceLock]") {
+    DeviceLock lock("SERIAL0001", directory);
+    std::ofstream(directory / "SERIAL0001.queue") << 2147483646 << ' ' << 0 << '\n';
+    REQUIRE(lock.TryAcquire());
+}
+
+
+TEST_CASE_METHOD(LockDirectoryFixture, "DeviceLock: timeout", "[DeviceLock]") {
+    DeviceLock holder("SERIAL0001", directory);
+    DeviceLock waiter("SERIAL0001", directory);
+    holder.Acquire();
+    REQUIRE_THROWS_AS(waiter.Acquire(20ms), DeviceError);
+    holder.Release();
+    REQUIRE_NOTHROW(waiter.Acquire(20ms));
+    REQUIRE(waiter.IsHeld());
+}
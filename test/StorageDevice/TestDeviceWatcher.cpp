@@ -0,0 +1,72 @@
+#ifdef __linux__
+
+#include <StorageDevice/DeviceWatcher.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+
+using namespace sedmgr;
+using namespace std::chrono_literals;
+
+
+struct WatchDirectoryFixture {
+    WatchDirectoryFixture() {
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+    }
+    ~WatchDirectoryFixture() {
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+    }
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "sedmanager-test-dev";
+};
+
+
+TEST_CASE_METHOD(WatchDirectoryFixture, "DeviceWatcher: timeout", "[DeviceWatcher]") {
+    DeviceWatcher watcher(directory);
+    REQUIRE(watcher.Wait(10ms).empty());
+}
+
+
+TEST_CASE_METHOD(WatchDirectoryFixture, "DeviceWatcher: reports new NVMe nodes", "[DeviceWatcher]") {
+    std::ofstream(directory / "nvme0");
+    DeviceWatcher watcher(directory);
+
+    std::ofstream(directory / "sda");
+    std::ofstream(directory / "nvme1n1");
+    std::ofstream(directory / "nvme1");
+    const auto devices = watcher.Wait(1s);
+    REQUIRE(devices.size() == 1);
+    REQUIRE(devices[0].path == (directory / "nvme1").string());
+    REQUIRE(devices[0].interface == eStorageDeviceInterface::NVME);
+    REQUIRE(watcher.Wait(10ms).empty());
+}
+
+
+TEST_CASE_METHOD(WatchDirectoryFixture, "DeviceWatcher: keeps waiting past other nodes", "[DeviceWatcher]") {
+    DeviceWatcher watcher(directory);
+
+    std::ofstream(directory / "sda");
+    REQUIRE(watcher.Wait(20ms).empty());
+
+    std::ofstream(directory / "nvme2n1");
+    std::jthread creator([this] {
+        std::this_thread::sleep_for(20ms);
+        std::ofstream(directory / "nvme2");
+    });
+    const auto devices = watcher.Wait(1s);
+    REQUIRE(devices.size() == 1);
+    REQUIRE(devices[0].path == (directory / "nvme2").string());
+}
+
+
+TEST_CASE("DeviceWatcher: missing directory", "[DeviceWatcher]") {
+    REQUIRE_THROWS(DeviceWatcher(std::filesystem::temp_directory_path() / "sedmanager-test-missing"));
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifdef __linux__
+
+#include <StorageDevice/StorageDevice.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+
+
+using namespace sedmgr;
+
+
+struct SysfsFixture {
+    SysfsFixture() {
+        std::filesystem::remove_all(root);
+        AddController("nvme10", "Model B", "SERIAL-B", "2.0", { { "nvme10n1", 1000 } });
+        AddController("nvme2", "Model A", "SERIAL-A", "1.0", { { "nvme2n2", 16 }, { "nvme2n1", 8 } });
+        std::filesystem::create_directories(root / "class" / "nvme" / "nvme-subsys0");
+    }
+    ~SysfsFixture() {
+        std::error_code ec;
+        std::filesystem::remove_all(root, ec);
+    }
+
+    void AddController(std::string_view name,
+                       std::string_view model,
+                       std::string_view serial,
+                       std::string_view firmware,
+                       std::vector<std::pair<std::string, uint64_t>> namespaces) {
+        const auto dir = root / "class" / "nvme" / name;
+        std::filesystem::create_directories(dir);
+        // sysfs pads the attributes with spaces.
+        std::ofstream(dir / "model") << model << "          \n";
+        std::ofstream(dir / "serial") << serial << "    \n";
+        std::ofstream(dir / "firmware_rev") << firmware << "\n";
+        for (const auto& [ns, sectors] : namespaces) {
+            std::filesystem::create_directories(dir / ns);
+            std::ofstream(dir / ns / "size") << sectors << "\n";
+        }
+    }
+
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "sedmanager-test-sysfs";
+};
+
+
+TEST_CASE_METHOD(SysfsFixture, "EnumerateStorageDeviceInfo: sysfs", "[StorageDevice]") {
+    const auto devices = EnumerateStorageDeviceInfo(root);
+    REQUIRE(devices.size() == 2);
+
+    REQUIRE(devices[0].label.path == "/dev/nvme2");
+    REQUIRE(devices[0].label.interface == eStorageDeviceInterface::NVME);
+    REQUIRE(devices[0].desc.name == "Model A");
+    REQUIRE(devices[0].desc.serial == "SERIAL-A");
+    REQUIRE(devices[0].desc.firmware == "1.0");
+    REQUIRE(devices[0].namespaces.size() == 2);
+    REQUIRE(devices[0].namespaces[0].path == "/dev/nvme2n1");
+    REQUIRE(devices[0].namespaces[0].size == 8 * 512);
+    REQUIRE(devices[0].namespaces[1].path == "/dev/nvme2n2");
+
+    REQUIRE(devices[1].label.path == "/dev/nvme10");
+    REQUIRE(devices[1].desc.serial == "SERIAL-B");
+    REQUIRE(devices[1].namespaces.size() == 1);
+}
+
+
+TEST_CASE_METHOD(SysfsFixture, "EnumerateStorageDeviceInfo: multipath namespaces", "[StorageDevice]") {
+    AddController("nvme3", "Model C", "SERIAL-C", "3.0", { { "nvme1c3n2", 4 }, { "nvme1c3n1", 2 } });
+    const auto devices = EnumerateStorageDeviceInfo(root);
+    REQUIRE(devices.size() == 3);
+    REQUIRE(devices[1].label.path == "/dev/nvme3");
+    REQUIRE(devices[1].namespaces.size() == 2);
+    REQUIRE(devices[1].namespaces[0].path == "/dev/nvme1n1");
+    REQUIRE(devices[1].namespaces[0].size == 2 * 512);
+    REQUIRE(devices[1].namespaces[1].path == "/dev/nvme1n2");
+}
+
+
+TEST_CASE_METHOD(SysfsFixture, "EnumerateStorageDeviceInfo: malformed size", "[StorageDevice]") {
+    std::ofstream(root / "class" / "nvme" / "nvme2" / "nvme2n1" / "size") << "garbage\n";
+    const auto devices = EnumerateStorageDeviceInfo(root);
+    REQUIRE(devices.size() == 2);
+    REQUIRE(devices[0].namespaces.size() == 2);
+    REQUIRE(devices[0].namespaces[0].size == 0);
+    REQUIRE(devices[0].namespaces[1].size == 16 * 512);
+}
+
+
+TEST_CASE("EnumerateStorageDeviceInfo: missing sysfs", "[StorageDevice]") {
+    REQUIRE(EnumerateStorageDeviceInfo(std::filesystem::temp_directory_path() / "sedmanager-test-missing").empty());
+}
+
+#endif
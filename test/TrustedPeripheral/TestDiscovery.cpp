@@ -65,6 +65,29 @@ TEST_CASE("Discovery: Locking features", "[Discovery]") {
 }
 
 
+TEST_CASE("Discovery: Geometry features", "[Discovery]") {
+    const std::array<std::byte, 32> featureBytes = {
+        0x00_b, 0x03_b, // Feature code
+        0x10_b, // Version | Reserved
+        0x1C_b, // Length
+        0x01_b, // Bitmask: Res | ALIGN
+        0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0_b, // Reserved
+        0x00_b, 0x00_b, 0x10_b, 0x00_b, // Logical block size
+        0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0x08_b, // Alignment granularity
+        0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0_b, 0x07_b, // Lowest aligned LBA
+    };
+    const auto discoveryBytes = MakeDiscoveryBytes(featureBytes);
+    const auto desc = ParseTPerDesc(discoveryBytes);
+
+    REQUIRE(desc.geometryDesc);
+    REQUIRE(desc.geometryDesc->alignmentRequired == true);
+    REQUIRE(desc.geometryDesc->logicalBlockSize == 4096);
+    REQUIRE(desc.geometryDesc->alignmentGranularity == 8);
+    REQUIRE(desc.geometryDesc->lowestAlignedLba == 7);
+    REQUIRE(desc.sscDescs.empty());
+}
+
+
 TEST_CASE("Discovery: Opal v1", "[Discovery]") {
     const std::array<std::byte, 20> featureBytes = {
         0x02_b, 0x00_b, // Feature code
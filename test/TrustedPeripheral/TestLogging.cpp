@@ -0,0 +1,99 @@
+#include <TrustedPeripheral/Logging.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+
+using namespace sedmgr;
+
+
+TEST_CASE("Logging: trace buffer order", "[Logging]") {
+    TraceBuffer buffer(8);
+    REQUIRE(buffer.Capacity() == 8);
+    for (uint64_t i = 0; i < 5; ++i) {
+        REQUIRE(buffer.Push({ .arg0 = i }));
+    }
+    for (uint64_t i = 0; i < 5; ++i) {
+        const auto event = buffer.Pop();
+        REQUIRE(event);
+        REQUIRE(event->arg0 == i);
+    }
+    REQUIRE(!buffer.Pop());
+}
+
+
+TEST_CASE("Logging: trace buffer overflow", "[Logging]") {
+    TraceBuffer buffer(4);
+    for (uint64_t i = 0; i < 6; ++i) {
+        buffer.Push({ .arg0 = i });
+    }
+    REQUIRE(buffer.Dropped() == 2);
+    REQUIRE(buffer.Pop()->arg0 == 0);
+    REQUIRE(buffer.Push({ .arg0 = 6 }));
+}
+
+
+TEST_CASE("Logging: trace buffer concurrent producers", "[Logging]") {
+    constexpr size_t numThreads = 4;
+    constexpr size_t numEvents = 1000;
+    TraceBuffer buffer(numThreads * numEvents);
+    {
+        std::vector<std::jthread> threads;
+        for (size_t t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&buffer, t] {
+                for (size_t i = 0; i < numEvents; ++i) {
+                    buffer.Push({ .arg0 = t, .arg1 = i });
+                }
+            });
+        }
+    }
+    std::vector<size_t> counts(numThreads, 0);
+    while (const auto event = buffer.Pop()) {
+        REQUIRE(event->arg1 == counts[event->arg0]);
+        ++counts[event->arg0];
+    }
+    REQUIRE(counts == std::vector<size_t>(numThreads, numEvents));
+    REQUIRE(buffer.Dropped() == 0);
+}
+
+
+TEST_CASE("Logging: format trace event", "[Logging]") {
+    SECTION("IF-SEND") {
+        const auto text = FormatTraceEvent({ .id = eTraceEvent::IF_SEND, .protocol = 1, .comId = 4097, .arg0 = 2048 });
+        REQUIRE(text.find("IF-SEND: Protocol=1, ComID=4097, payload: 2048 bytes") != std::string::npos);
+    }
+    SECTION("method name") {
+        const auto findName = [](UID uid) -> std::optional<std::string> {
+            return uid == UID(0xFF06) ? std::optional<std::string>("Get") : std::nullopt;
+        };
+        const auto text = FormatTraceEvent({ .id = eTraceEvent::METHOD_RESULT, .arg0 = 0, .arg1 = 0xFF06 }, findName);
+        REQUIRE(text.find("'Get' status=0") != std::string::npos);
+    }
+    SECTION("failure message") {
+        const auto text = FormatTraceEvent({ .id = eTraceEvent::METHOD_FAILED, .arg1 = 0xFF06, .payload = TraceText("boom") });
+        REQUIRE(text.find("--- boom") != std::string::npos);
+    }
+}
+
+
+TEST_CASE("Logging: trace to file", "[Logging]") {
+    const auto path = std::filesystem::temp_directory_path() / "sedmgr-test-trace.log";
+    const bool wasTracing = IsTracing();
+    TraceToFile(path);
+    REQUIRE(IsTracing());
+    Trace({ .id = eTraceEvent::METHOD_FAILED, .arg1 = 0xFF06, .payload = TraceText("to file") });
+    REQUIRE_THROWS_AS(DrainTrace(), std::logic_error);
+    SetTracing(false);
+
+    std::ifstream file(path);
+    std::stringstream text;
+    text << file.rdbuf();
+    REQUIRE(text.str().find("--- to file") != std::string::npos);
+    REQUIRE(DrainTrace().empty());
+    std::filesystem::remove(path);
+    SetTracing(wasTracing);
+}
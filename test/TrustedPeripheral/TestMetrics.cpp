@@ -0,0 +1,124 @@
+#include <MockDevice/MockDevice.hpp>
+#include <Specification/Core/Defs/UIDs.hpp>
+#include <Specification/Opal/OpalModule.hpp>
+#include <TrustedPeripheral/Metrics.hpp>
+#include <TrustedPeripheral/SessionManager.hpp>
+
+#include <asyncpp/join.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+
+using namespace sedmgr;
+
+
+TEST_CASE("Metrics: histogram empty", "[Metrics]") {
+    const Histogram histogram;
+    REQUIRE(histogram.Count() == 0);
+    REQUIRE(histogram.Min() == 0);
+    REQUIRE(histogram.Max() == 0);
+    REQUIRE(histogram.Percentile(50) == 0);
+}
+
+
+TEST_CASE("Metrics: histogram small values are exact", "[Metrics]") {
+    Histogram histogram;
+    for (uint64_t value = 1; value <= 10; ++value) {
+        histogram.Record(value);
+    }
+    REQUIRE(histogram.Count() == 10);
+    REQUIRE(histogram.Sum() == 55);
+    REQUIRE(histogram.Min() == 1);
+    REQUIRE(histogram.Max() == 10);
+    REQUIRE(histogram.Percentile(50) == 5);
+    REQUIRE(histogram.Percentile(100) == 10);
+}
+
+
+TEST_CASE("Metrics: histogram relative error", "[Metrics]") {
+    Histogram histogram;
+    for (uint64_t value = 1; value <= 100000; ++value) {
+        histogram.Record(value * 1000);
+    }
+    const auto p50 = histogram.Percentile(50);
+    const auto p99 = histogram.Percentile(99);
+    REQUIRE(p50 >= 50'000'000);
+    REQUIRE(p50 <= 50'000'000 + 50'000'000 / 16);
+    REQUIRE(p99 >= 99'000'000);
+    REQUIRE(p99 <= 99'000'000 + 99'000'000 / 16);
+    REQUIRE(histogram.Percentile(100) == histogram.Max());
+}
+
+
+TEST_CASE("Metrics: histogram large values", "[Metrics]") {
+    Histogram histogram;
+    histogram.Record(std::numeric_limits<uint64_t>::max());
+    REQUIRE(histogram.Percentile(50) == std::numeric_limits<uint64_t>::max());
+}
+
+
+TEST_CASE("Metrics: record communication", "[Metrics]") {
+    const auto device = std::make_shared<MockDevice>();
+    const auto tper = std::make_shared<TrustedPeripheral>(device);
+    const auto sessionManager = std::make_shared<SessionManager>(tper);
+    tper->GetMetrics()->Reset();
+
+    REQUIRE_NOTHROW(join(sessionManager->Properties()));
+
+    const auto snapshot = tper->GetMetrics()->Snapshot();
+    REQUIRE(snapshot.ifSendCount >= 1);
+    REQUIRE(snapshot.ifRecvCount >= 1);
+    REQUIRE(snapshot.bytesSent > 0);
+    REQUIRE(snapshot.bytesReceived > 0);
+    REQUIRE(snapshot.exchangeCount == 1);
+    REQUIRE(snapshot.pollCount >= 1);
+    REQUIRE(snapshot.methodLatency.contains(UID(core::eMethod::Properties)));
+    REQUIRE(snapshot.methodLatency.at(UID(core::eMethod::Properties)).count == 1);
+}
+
+
+TEST_CASE("Metrics: record ComID management exchanges", "[Metrics]") {
+    const auto device = std::make_shared<MockDevice>();
+    const auto tper = std::make_shared<TrustedPeripheral>(device);
+    tper->GetMetrics()->Reset();
+
+    REQUIRE_NOTHROW(join(tper->VerifyComId()));
+
+    const auto snapshot = tper->GetMetrics()->Snapshot();
+    REQUIRE(snapshot.exchangeCount == 1);
+    REQUIRE(snapshot.pollCount >= 1);
+    REQUIRE(snapshot.exchangeLatency.count == 1);
+}
+
+
+TEST_CASE("Metrics: record session start and end", "[Metrics]") {
+    const auto device = std::make_shared<MockDevice>();
+    const auto tper = std::make_shared<TrustedPeripheral>(device);
+    const auto sessionManager = std::make_shared<SessionManager>(tper);
+    const auto adminSp = Opal1Module::Get()->FindUid("SP::Admin").value();
+    tper->GetMetrics()->Reset();
+
+    const auto session = join(sessionManager->StartSession(100, adminSp, false));
+    join(sessionManager->EndSession(session.spSessionId, session.hostSessionId));
+
+    const auto snapshot = tper->GetMetrics()->Snapshot();
+    REQUIRE(snapshot.methodLatency.at(UID(core::eMethod::StartSession)).count == 1);
+    REQUIRE(snapshot.endSessionLatency.count == 1);
+}
+
+
+TEST_CASE("Metrics: reset", "[Metrics]") {
+    Metrics metrics;
+    metrics.RecordSend(512);
+    metrics.RecordReceive(2048);
+    metrics.RecordExchange(std::chrono::microseconds(100), 2);
+    metrics.RecordMethod(UID(core::eMethod::Get), std::chrono::microseconds(100));
+    metrics.RecordEndSession(std::chrono::microseconds(100));
+    REQUIRE(metrics.Snapshot().bytesSent == 512);
+    metrics.Reset();
+    const auto snapshot = metrics.Snapshot();
+    REQUIRE(snapshot.ifSendCount == 0);
+    REQUIRE(snapshot.exchangeCount == 0);
+    REQUIRE(snapshot.methodLatency.empty());
+    REQUIRE(snapshot.endSessionLatency.count == 0);
+}
@@ -0,0 +1,89 @@
+#include <Error/Exception.hpp>
+#include <TrustedPeripheral/RetryPolicy.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <stdexcept>
+
+
+using namespace sedmgr;
+using namespace std::chrono_literals;
+
+
+TEST_CASE("RetryPolicy: classify", "[RetryPolicy]") {
+    const auto classify = [](auto exception) { return RetryPolicy::Classify(std::make_exception_ptr(exception)); };
+
+    REQUIRE(classify(SecurityProviderBusyError("StartSession")) == eFailureClass::CONTENTION);
+    REQUIRE(classify(NoSessionsAvailableError("StartSession")) == eFailureClass::CONTENTION);
+    REQUIRE(classify(TPerMalfunctionError("Get")) == eFailureClass::TRANSIENT);
+    REQUIRE(classify(DeviceError("IF-RECV failed")) == eFailureClass::TRANSIENT);
+    REQUIRE(classify(NoResponseError("timed out")) == eFailureClass::DESYNC);
+    REQUIRE(classify(NotAuthorizedError("Get")) == eFailureClass::PERMANENT);
+    REQUIRE(classify(CancelledError("deadline exceeded")) == eFailureClass::PERMANENT);
+    REQUIRE(classify(std::invalid_argument("bad table")) == eFailureClass::PERMANENT);
+}
+
+
+TEST_CASE("RetryPolicy: escalation", "[RetryPolicy]") {
+    SECTION("transient") {
+        RetryState retry(RetryPolicy{ .allowStackReset = true });
+        REQUIRE(retry.Next(eFailureClass::TRANSIENT) == eRecoveryAction::RETRY);
+        REQUIRE(retry.Next(eFailureClass::TRANSIENT) == eRecoveryAction::RESTART_SESSION);
+        REQUIRE(retry.Next(eFailureClass::TRANSIENT) == eRecoveryAction::RETRY);
+        REQUIRE(retry.Next(eFailureClass::TRANSIENT) == eRecoveryAction::STACK_RESET);
+        REQUIRE(retry.Next(eFailureClass::TRANSIENT) == eRecoveryAction::RETRY);
+        REQUIRE(retry.Next(eFailureClass::TRANSIENT) == eRecoveryAction::FAIL);
+    }
+    SECTION("contention") {
+        RetryState retry(RetryPolicy{ .allowStackReset = true });
+        REQUIRE(retry.Next(eFailureClass::CONTENTION) == eRecoveryAction::RETRY);
+        REQUIRE(retry.Next(eFailureClass::CONTENTION) == eRecoveryAction::RETRY);
+        REQUIRE(retry.Next(eFailureClass::CONTENTION) == eRecoveryAction::RETRY);
+        REQUIRE(retry.Next(eFailureClass::CONTENTION) == eRecoveryAction::STACK_RESET);
+    }
+    SECTION("desync") {
+        RetryState retry(RetryPolicy{});
+        REQUIRE(retry.Next(eFailureClass::DESYNC) == eRecoveryAction::RESTART_SESSION);
+        REQUIRE(retry.Next(eFailureClass::DESYNC) == eRecoveryAction::RESTART_SESSION);
+        RetryState resetting(RetryPolicy{ .allowStackReset = true });
+        REQUIRE(resetting.Next(eFailureClass::DESYNC) == eRecoveryAction::STACK_RESET);
+    }
+    SECTION("stack reset not allowed") {
+        RetryState retry(RetryPolicy{ .retriesBeforeStackReset = 0 });
+        REQUIRE(retry.Next(eFailureClass::CONTENTION) == eRecoveryAction::RETRY);
+    }
+    SECTION("contention only") {
+        RetryState retry(RetryPolicy{ .retriesBeforeStackReset = 0, .allowStackReset = true, .contentionOnly = true });
+        REQUIRE(retry.Next(eFailureClass::TRANSIENT) == eRecoveryAction::FAIL);
+        RetryState contended(RetryPolicy{ .retriesBeforeStackReset = 0, .allowStackReset = true, .contentionOnly = true });
+        REQUIRE(contended.Next(eFailureClass::CONTENTION) == eRecoveryAction::STACK_RESET);
+    }
+    SECTION("permanent") {
+        RetryState retry(RetryPolicy{});
+        REQUIRE(retry.Next(eFailureClass::PERMANENT) == eRecoveryAction::FAIL);
+    }
+    SECTION("none") {
+        RetryState retry(RetryPolicy::None());
+        REQUIRE(retry.Next(eFailureClass::TRANSIENT) == eRecoveryAction::FAIL);
+    }
+    SECTION("budget") {
+        RetryState retry(RetryPolicy{ .budget = 0ns });
+        REQUIRE(retry.Next(eFailureClass::TRANSIENT) == eRecoveryAction::FAIL);
+    }
+}
+
+
+TEST_CASE("RetryPolicy: backoff", "[RetryPolicy]") {
+    const auto policy = RetryPolicy{ .initialDelay = 4ms, .maxDelay = 10ms };
+    RetryState retry(policy);
+    std::chrono::nanoseconds maxBackoff = 0ns;
+    for (int i = 0; i < 4; ++i) {
+        retry.Next(eFailureClass::CONTENTION);
+        const auto backoff = retry.Backoff();
+        REQUIRE(backoff >= 2ms);
+        REQUIRE(backoff <= policy.maxDelay);
+        maxBackoff = std::max(maxBackoff, backoff);
+    }
+    REQUIRE(maxBackoff >= policy.maxDelay / 2);
+}